@@ -1,76 +1,328 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <imgui.h>
 #include <util/ImVecUtil.hpp>
+#include "core/HitTest.hpp"
+#include "core/PointCodec.hpp"
+#include "core/StrokeGeometry.hpp"
+#include "util/MemoryStats.hpp"
+
+// Уникальный идентификатор элемента в пределах процесса
+inline std::atomic<uint64_t> &ElementIdCounter()
+{
+    static std::atomic<uint64_t> next{1};
+    return next;
+}
+
+inline uint64_t NextElementId()
+{
+    return ElementIdCounter().fetch_add(1, std::memory_order_relaxed);
+}
+
+// Новые id не пересекаются с загруженными из файла (used — наибольший из них)
+inline void ReserveElementIds(uint64_t used)
+{
+    std::atomic<uint64_t> &next = ElementIdCounter();
+    uint64_t current = next.load(std::memory_order_relaxed);
+    while (current <= used && !next.compare_exchange_weak(current, used + 1, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Ревизии берутся из общего счётчика процесса, поэтому пара (id, ревизия)
+// не повторяется: после undo и новой правки элемент не получит ревизию
+// состояния, оставшегося в redo. Ревизии не сохраняются в файл
+inline uint64_t NextRevision()
+{
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
 
 // Базовый абстрактный объект на холсте
 struct CanvasElement
 {
+    // Стабильный id: сохраняется при clone(), по нему сопоставляются
+    // снимки истории, операции репликации и индексы
+    uint64_t id = NextElementId();
+    // Новая при каждом изменении содержимого (см. CanvasState::note_modified)
+    uint64_t revision = NextRevision();
+
     virtual ~CanvasElement() = default;
 
+    // Объекты элементов (и их копии в истории) учитываются в MemCategory::Elements
+    static void *operator new(size_t size)
+    {
+        MemTrackAlloc(MemCategory::Elements, size);
+        return ::operator new(size);
+    }
+    static void operator delete(void *p, size_t size)
+    {
+        MemTrackFree(MemCategory::Elements, size);
+        ::operator delete(p);
+    }
+
     // Функция копирования через клонирование для корректной работы undo/redo
     virtual std::unique_ptr<CanvasElement> clone() const = 0;
 
+    // Новый элемент-копия с собственным id (копирование, вставка, дублирование)
+    virtual std::unique_ptr<CanvasElement> duplicate() const
+    {
+        std::unique_ptr<CanvasElement> copy = clone();
+        copy->id = NextElementId();
+        copy->revision = NextRevision();
+        return copy;
+    }
+
+    // Сдвиг в координатах холста
+    virtual void translate(const ImVec2 &delta) = 0;
+
     // Отрисовка объекта. origin — левый-верхний угол холста на экране
     virtual void render(ImDrawList *draw_list, const ImVec2 &origin, const ImVec2 &pan, float zoom) const = 0;
 
+    // render() можно вызвать на рабочем потоке со своим draw_list: он не
+    // обращается к контексту ImGui (см. RenderCanvas)
+    virtual bool renders_off_main_thread() const { return false; }
+
     // Проверка попадания точки в элемент (для выбора)
     virtual bool contains(const ImVec2 &point, const ImVec2 &pan, float zoom) const = 0;
 
+    // Границы элемента в координатах холста. false — если элемент пустой
+    virtual bool get_bounds(ImVec2 &min, ImVec2 &max) const = 0;
+
     // Получение типа элемента
     virtual const char *get_type() const = 0;
+
+    // Занимаемая память: объект и принадлежащие ему буферы
+    virtual size_t memory_bytes() const = 0;
 };
 
 // ---------- Stroke ----------
 struct Stroke : public CanvasElement
 {
-    std::vector<ImVec2> points;
+    // Точки активного штриха в полной точности. Изменять через add_point(),
+    // иначе вызвать update_bounds(). После pack() вектор пустой
+    TrackedVector<ImVec2, MemCategory::Geometry> points;
     ImVec4 color = ImVec4(1, 1, 1, 1);
     float thickness = 2.0f;
 
+    // Bounding box точек в координатах холста (без учёта толщины)
+    ImVec2 bounds_min = ImVec2(0.0f, 0.0f);
+    ImVec2 bounds_max = ImVec2(0.0f, 0.0f);
+
+    // Завершённый штрих: общая неизменяемая геометрия (см. StrokeGeometry.hpp)
+    // и трансформация экземпляра, точка холста = offset + p * scale
+    std::shared_ptr<const StrokeGeometry> geometry;
+    ImVec2 offset = ImVec2(0.0f, 0.0f);
+    float scale = 1.0f;
+
+    // Сетка активного штриха, наращиваемая по мере добавления точек; ведёт
+    // её слой отрисовки (DrawStroke), элемент рисуется одним потоком за кадр
+    mutable WetStrokeHandle wet;
+
+    // Копия разделяет геометрию — снимки истории не дублируют точки
     std::unique_ptr<CanvasElement> clone() const override
     {
         return std::make_unique<Stroke>(*this);
     }
 
-    void render(ImDrawList *draw_list, const ImVec2 &origin, const ImVec2 &pan, float zoom) const override
+    std::unique_ptr<CanvasElement> duplicate() const override
+    {
+        if (geometry)
+            geometry->mark_instanced();
+        return CanvasElement::duplicate();
+    }
+
+    bool is_packed() const { return geometry != nullptr; }
+
+    size_t point_count() const { return is_packed() ? geometry->point_count() : points.size(); }
+
+    // Перевод завершённого штриха в компактную форму
+    void pack()
     {
-        if (points.size() < 2)
+        if (is_packed() || points.empty())
             return;
-        std::vector<ImVec2> transformed;
-        transformed.reserve(points.size());
-        for (const ImVec2 &p : points)
+        geometry = StrokeGeometry::Encode(points.data(), points.size(), bounds_min, bounds_max);
+        offset = ImVec2(0.0f, 0.0f);
+        scale = 1.0f;
+        // Сетка, построенная при рисовании, остаётся в wet: следующий кадр
+        // переносит её в кэш геометрии, а не тессельсирует штрих заново
+        points.clear();
+        points.shrink_to_fit();
+    }
+
+    // Уже упакованные точки в координатах холста (загрузка, репликация);
+    // bounds_min/bounds_max должны быть заданы
+    void set_packed(PackedPoints &&packed, float packed_scale)
+    {
+        geometry = StrokeGeometry::FromPacked(std::move(packed), packed_scale, bounds_min, bounds_max);
+        offset = ImVec2(0.0f, 0.0f);
+        scale = 1.0f;
+        wet.mesh.reset();
+        points.clear();
+    }
+
+    // Шаг квантования в координатах холста с учётом масштаба экземпляра
+    float packed_scale() const { return is_packed() ? geometry->packed_scale() * scale : 0.0f; }
+
+    // Обратно в полную точность (например, чтобы продолжить редактирование).
+    // Геометрия отвязывается от остальных экземпляров
+    void unpack()
+    {
+        if (!is_packed())
+            return;
+        points.resize(point_count());
+        DecodePoints(geometry->packed().data(), points.size(), offset + geometry->bounds_min() * scale,
+                     geometry->packed_scale() * scale, points.data());
+        geometry.reset();
+        offset = ImVec2(0.0f, 0.0f);
+        scale = 1.0f;
+    }
+
+    // Точки в проекции offset + p * scale (по умолчанию — координаты холста)
+    void decode_points(std::vector<ImVec2> &out, const ImVec2 &to_offset = ImVec2(0.0f, 0.0f),
+                       float to_scale = 1.0f) const
+    {
+        out.resize(point_count());
+        if (is_packed())
         {
-            transformed.push_back(origin + pan + p * zoom);
+            DecodePoints(geometry->packed().data(), out.size(),
+                         to_offset + (offset + geometry->bounds_min() * scale) * to_scale,
+                         geometry->packed_scale() * scale * to_scale, out.data());
+            return;
         }
-        float thick = thickness * zoom;
-        draw_list->AddPolyline(
-            transformed.data(),
-            static_cast<int>(transformed.size()),
-            ImColor(color),
-            ImDrawFlags_None,
-            thick);
+        for (size_t i = 0; i < points.size(); ++i)
+            out[i] = to_offset + points[i] * to_scale;
     }
 
+    // Ломаная без кэшей. Холст рисует штрихи слоем отрисовки (DrawStroke):
+    // тессельсирование и сетки — там
+    void render(ImDrawList *draw_list, const ImVec2 &origin, const ImVec2 &pan, float zoom) const override
+    {
+        if (point_count() < 2)
+            return;
+        thread_local std::vector<ImVec2> transformed;
+        decode_points(transformed, origin + pan, zoom);
+        draw_list->AddPolyline(transformed.data(), static_cast<int>(transformed.size()), ImColor(color),
+                               ImDrawFlags_None, thickness * zoom);
+    }
+
+    bool renders_off_main_thread() const override { return true; }
+
     bool contains(const ImVec2 &point, const ImVec2 &pan, float zoom) const override
     {
-        for (const ImVec2 &p : points)
+        // Переводим точку экрана в координаты холста и проверяем отрезки
+        return hit_test((point - pan) / zoom, thickness);
+    }
+
+    // Попадание точки (в координатах холста) в радиус от любого отрезка штриха.
+    // Сначала дешёвая проверка по bounding box, затем SIMD-ядро по отрезкам
+    bool hit_test(const ImVec2 &world_point, float radius) const
+    {
+        if (point_count() == 0)
+            return false;
+        if (world_point.x < bounds_min.x - radius || world_point.x > bounds_max.x + radius ||
+            world_point.y < bounds_min.y - radius || world_point.y > bounds_max.y + radius)
+            return false;
+        if (!is_packed())
+            return PolylineNear(points.data(), points.size(), world_point, radius);
+
+        // Проверка в локальных координатах геометрии
+        const ImVec2 local = (world_point - offset) / scale;
+        const float local_radius = radius / scale;
+        if (geometry->instanced())
+            return geometry->hit_cache()->near(local, local_radius);
+
+        // Декодируем порциями на стеке; соседние порции перекрываются на одну точку,
+        // чтобы не потерять отрезок на стыке
+        constexpr size_t chunk = 128;
+        ImVec2 buffer[chunk];
+        const size_t count = point_count();
+        const uint16_t *packed = geometry->packed().data();
+        for (size_t start = 0; start < count; start += chunk - 1)
         {
-            ImVec2 screen_p = p * zoom + pan;
-            float dx = point.x - screen_p.x;
-            float dy = point.y - screen_p.y;
-            if (dx * dx + dy * dy <= (thickness * zoom) * (thickness * zoom))
-            {
+            size_t n = std::min(chunk, count - start);
+            DecodePoints(packed + start * 2, n, geometry->bounds_min(), geometry->packed_scale(), buffer);
+            if (PolylineNear(buffer, n, local, local_radius))
                 return true;
-            }
+            if (start + n >= count)
+                break;
         }
         return false;
     }
 
+    void translate(const ImVec2 &delta) override
+    {
+        if (is_packed())
+            offset += delta;
+        else
+            for (ImVec2 &p : points)
+                p += delta;
+        wet.mesh.reset();
+        bounds_min += delta;
+        bounds_max += delta;
+    }
+
+    // Добавление точки с обновлением bounding box
+    void add_point(const ImVec2 &p)
+    {
+        unpack();
+        if (points.empty())
+        {
+            bounds_min = bounds_max = p;
+        }
+        else
+        {
+            bounds_min.x = std::min(bounds_min.x, p.x);
+            bounds_min.y = std::min(bounds_min.y, p.y);
+            bounds_max.x = std::max(bounds_max.x, p.x);
+            bounds_max.y = std::max(bounds_max.y, p.y);
+        }
+        points.push_back(p);
+    }
+
+    // Пересчёт bounding box после прямого изменения points
+    void update_bounds()
+    {
+        wet.mesh.reset();
+        if (points.empty())
+            return;
+        bounds_min = bounds_max = points[0];
+        for (const ImVec2 &p : points)
+        {
+            bounds_min.x = std::min(bounds_min.x, p.x);
+            bounds_min.y = std::min(bounds_min.y, p.y);
+            bounds_max.x = std::max(bounds_max.x, p.x);
+            bounds_max.y = std::max(bounds_max.y, p.y);
+        }
+    }
+
+    bool get_bounds(ImVec2 &min, ImVec2 &max) const override
+    {
+        if (point_count() == 0)
+            return false;
+        // Запас на толщину линии
+        min = bounds_min - ImVec2(thickness, thickness);
+        max = bounds_max + ImVec2(thickness, thickness);
+        return true;
+    }
+
     const char *get_type() const override { return "Stroke"; }
+
+    // Общая геометрия делится поровну между владельцами
+    size_t memory_bytes() const override
+    {
+        size_t bytes = sizeof(Stroke) + points.capacity() * sizeof(ImVec2);
+        if (wet.mesh)
+            bytes += wet.mesh->memory_bytes();
+        if (geometry)
+            bytes += geometry->memory_bytes() / static_cast<size_t>(geometry.use_count());
+        return bytes;
+    }
 };
 
 // ---------- Text label (Markdown/LaTeX) ----------
@@ -157,5 +409,102 @@ struct TextLabel : public CanvasElement
                point.y >= screen_pos.y && point.y <= screen_pos.y + text_size.y;
     }
 
+    bool get_bounds(ImVec2 &min, ImVec2 &max) const override
+    {
+        ImVec2 text_size = ImGui::CalcTextSize(text.c_str());
+        min = position;
+        max = position + text_size;
+        return true;
+    }
+
+    void translate(const ImVec2 &delta) override { position += delta; }
+
     const char *get_type() const override { return "TextLabel"; }
+
+    // Строка вне объекта (длиннее small-string буфера)
+    size_t text_heap_bytes() const { return text.capacity() >= sizeof(std::string) ? text.capacity() + 1 : 0; }
+
+    size_t memory_bytes() const override { return sizeof(TextLabel) + text_heap_bytes(); }
+};
+
+// ---------- Image ----------
+struct ImageElement : public CanvasElement
+{
+    std::string path;                     // файл изображения (PNG)
+    ImVec2 position = ImVec2(0.0f, 0.0f); // левый-верхний угол в координатах холста
+    ImVec2 size = ImVec2(0.0f, 0.0f);     // размер на холсте
+
+    // Размер файла, который не удалось прочитать, и предел размера по умолчанию
+    static constexpr float kPlaceholderSize = 256.0f;
+    static constexpr float kMaxAutoSize = 1024.0f;
+
+    ImageElement() = default;
+    ImageElement(const std::string &file, const ImVec2 &canvas_size) : path(file), size(canvas_size) {}
+
+    // Размер на холсте для картинки width x height пикселей: длинная сторона
+    // не больше kMaxAutoSize; заглушка, если размер неизвестен
+    static ImVec2 FitSize(int width, int height)
+    {
+        if (width <= 0 || height <= 0)
+            return ImVec2(kPlaceholderSize, kPlaceholderSize);
+        float w = static_cast<float>(width), h = static_cast<float>(height);
+        float k = std::min(1.0f, kMaxAutoSize / std::max(w, h));
+        return ImVec2(w * k, h * k);
+    }
+
+    std::unique_ptr<CanvasElement> clone() const override
+    {
+        return std::make_unique<ImageElement>(*this);
+    }
+
+    // Размер ещё не задан: вставленный файл не декодирован (см. CanvasController::add_images)
+    bool has_size() const { return size.x > 0.0f && size.y > 0.0f; }
+
+    // Размер на холсте; без заданного размера — заглушка
+    ImVec2 display_size() const
+    {
+        if (has_size())
+            return size;
+        return ImVec2(kPlaceholderSize, kPlaceholderSize);
+    }
+
+    // Рамка на месте картинки, крест — если файл не прочитан. Саму картинку
+    // рисует слой отрисовки: текстуры и декодирование — в ImageStore (см. RenderCanvas)
+    void render(ImDrawList *draw_list, const ImVec2 &origin, const ImVec2 &pan, float zoom) const override
+    {
+        render_placeholder(draw_list, origin + pan + position * zoom, zoom, false);
+    }
+
+    void render_placeholder(ImDrawList *draw_list, const ImVec2 &min, float zoom, bool failed) const
+    {
+        ImVec2 max = min + display_size() * zoom;
+        draw_list->AddRectFilled(min, max, IM_COL32(60, 60, 70, 255));
+        draw_list->AddRect(min, max, IM_COL32(110, 110, 125, 255));
+        if (failed)
+        {
+            draw_list->AddLine(min, max, IM_COL32(200, 70, 70, 255), 2.0f);
+            draw_list->AddLine(ImVec2(min.x, max.y), ImVec2(max.x, min.y), IM_COL32(200, 70, 70, 255), 2.0f);
+        }
+    }
+
+    bool contains(const ImVec2 &point, const ImVec2 &pan, float zoom) const override
+    {
+        ImVec2 p = (point - pan) / zoom;
+        ImVec2 max = position + display_size();
+        return p.x >= position.x && p.x <= max.x && p.y >= position.y && p.y <= max.y;
+    }
+
+    bool get_bounds(ImVec2 &min, ImVec2 &max) const override
+    {
+        min = position;
+        max = position + display_size();
+        return true;
+    }
+
+    void translate(const ImVec2 &delta) override { position += delta; }
+
+    const char *get_type() const override { return "Image"; }
+
+    // Пиксели и текстуры учитываются в MemCategory::Images / Textures
+    size_t memory_bytes() const override { return sizeof(ImageElement) + path.capacity(); }
 };
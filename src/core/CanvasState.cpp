@@ -0,0 +1,57 @@
+#include "core/CanvasState.hpp"
+#include <unordered_map>
+
+void CanvasState::restore(CanvasState&& snapshot) {
+    std::unordered_map<uint64_t, uint64_t> old_revisions;
+    old_revisions.reserve(elements.size());
+    for (const auto& el : elements) {
+        old_revisions.emplace(el->id, el->revision);
+    }
+    // Старые элементы уходят из документа — указатели в журнале больше не действительны
+    for (auto& change : changes) {
+        change.element = nullptr;
+    }
+
+    // Обмен, а не присваивание: прежний документ остаётся в snapshot
+    // (History кладёт его в обратный стек без клонирования)
+    elements.swap(snapshot.elements);
+    std::swap(pan, snapshot.pan);
+    std::swap(zoom, snapshot.zoom);
+    selected_element = nullptr;
+    is_editing_text = false;
+
+    for (size_t i = 0; i < elements.size(); ++i) {
+        CanvasElement* el = elements[i].get();
+        auto it = old_revisions.find(el->id);
+        if (it == old_revisions.end()) {
+            note_added(el, i);
+            continue;
+        }
+        if (it->second != el->revision) {
+            changes.push_back({ChangeKind::Modified, el->id, el});
+        }
+        old_revisions.erase(it);
+    }
+    for (const auto& [id, revision] : old_revisions) {
+        changes.push_back({ChangeKind::Removed, id, nullptr});
+    }
+}
+
+void CanvasState::replace(CanvasState&& document) {
+    for (auto& change : changes) {
+        change.element = nullptr;
+    }
+    for (const auto& el : elements) {
+        changes.push_back({ChangeKind::Removed, el->id, nullptr});
+    }
+
+    elements.swap(document.elements);
+    std::swap(pan, document.pan);
+    std::swap(zoom, document.zoom);
+    selected_element = nullptr;
+    is_editing_text = false;
+
+    for (size_t i = 0; i < elements.size(); ++i) {
+        note_added(elements[i].get(), i);
+    }
+}
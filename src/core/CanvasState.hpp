@@ -2,6 +2,7 @@
 #include <vector>
 #include <memory>
 #include "core/CanvasElement.hpp"
+#include "core/ChangeLog.hpp"
 
 struct CanvasState {
     std::vector<std::unique_ptr<CanvasElement>> elements;
@@ -13,6 +14,9 @@ struct CanvasState {
     ImVec2 pan = ImVec2(0.0f, 0.0f);
     float  zoom = 1.0f;
 
+    // Журнал изменений текущего кадра (не копируется). Разбирается CollectChanges()
+    std::vector<ElementChange> changes;
+
     CanvasState() = default;
 
     // Копирование с глубоким клонированием объектов для корректного undo/redo
@@ -37,4 +41,43 @@ struct CanvasState {
         is_editing_text = false;
         return *this;
     }
+
+    // Перемещение без клонирования (снимки в истории, возврат из undo/redo)
+    CanvasState(CanvasState&&) noexcept = default;
+    CanvasState& operator=(CanvasState&&) noexcept = default;
+
+    // Учёт изменений: вызывать после каждой правки элементов
+    // index — позиция el в elements, если известна; иначе проверяется конец
+    void note_added(CanvasElement* el, size_t index = ElementChange::kNoIndex) {
+        if (index == ElementChange::kNoIndex && !elements.empty() && elements.back().get() == el)
+            index = elements.size() - 1;
+        changes.push_back({ChangeKind::Added, el->id, el, static_cast<uint32_t>(index)});
+    }
+    void note_modified(CanvasElement* el) {
+        el->revision = NextRevision();
+        changes.push_back({ChangeKind::Modified, el->id, el});
+    }
+    void note_appended(CanvasElement* el, uint32_t from) {
+        el->revision = NextRevision();
+        changes.push_back({ChangeKind::Appended, el->id, el, from});
+    }
+    void note_removed(uint64_t id) {
+        changes.push_back({ChangeKind::Removed, id, nullptr});
+    }
+
+    // Замена документа снимком (undo/redo) с записью разницы в журнал.
+    // После вызова snapshot содержит прежние элементы документа
+    void restore(CanvasState&& snapshot);
+
+    // Замена документа другим (открытие файла, смена страницы). id разных
+    // документов могут совпадать, поэтому разница по ревизиям не ищется:
+    // журнал получает удаление всех прежних элементов и добавление всех новых
+    void replace(CanvasState&& document);
+
+    // Память документа: элементы и их буферы
+    size_t memory_bytes() const {
+        size_t bytes = sizeof(CanvasState) + elements.capacity() * sizeof(elements[0]);
+        for (const auto& el : elements) bytes += el->memory_bytes();
+        return bytes;
+    }
 };
@@ -0,0 +1,123 @@
+#include "core/ChangeLog.hpp"
+#include "core/CanvasState.hpp"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+struct Pending
+{
+    bool existed_before = false; // элемент был в документе до начала кадра
+    bool removed = false;
+    bool added = false;
+    bool modified = false;
+    uint32_t append_from = std::numeric_limits<uint32_t>::max();
+    uint32_t index = ElementChange::kNoIndex; // подсказка позиции для added
+    CanvasElement *element = nullptr;
+};
+
+} // namespace
+
+FrameChanges CollectChanges(CanvasState &canvas)
+{
+    FrameChanges out;
+    if (canvas.changes.empty())
+        return out;
+
+    std::unordered_map<uint64_t, Pending> pending;
+    std::vector<uint64_t> order;
+    pending.reserve(canvas.changes.size());
+
+    for (const ElementChange &c : canvas.changes)
+    {
+        auto [it, inserted] = pending.try_emplace(c.id);
+        Pending &p = it->second;
+        if (inserted)
+        {
+            p.existed_before = c.kind != ChangeKind::Added;
+            order.push_back(c.id);
+        }
+        switch (c.kind)
+        {
+        case ChangeKind::Added:
+            p.added = true;
+            p.removed = false;
+            p.index = c.from;
+            p.element = c.element;
+            break;
+        case ChangeKind::Removed:
+            p = Pending{p.existed_before, true};
+            break;
+        case ChangeKind::Modified:
+            p.modified = true;
+            p.element = c.element;
+            break;
+        case ChangeKind::Appended:
+            p.append_from = std::min(p.append_from, c.from);
+            p.element = c.element;
+            break;
+        }
+    }
+    canvas.changes.clear();
+
+    // Индексы нужны для вставок без верной подсказки и для устаревших
+    // указателей; строим один раз и только если такие есть
+    auto hint_valid = [&](const Pending &p, uint64_t id) {
+        return p.element && p.index < canvas.elements.size() && canvas.elements[p.index].get() == p.element &&
+               p.element->id == id;
+    };
+    bool need_lookup = false;
+    for (uint64_t id : order)
+    {
+        const Pending &p = pending[id];
+        if (!p.removed && ((p.added && !hint_valid(p, id)) || !p.element))
+            need_lookup = true;
+    }
+    std::unordered_map<uint64_t, std::pair<uint32_t, CanvasElement *>> lookup;
+    if (need_lookup)
+    {
+        lookup.reserve(canvas.elements.size());
+        for (size_t i = 0; i < canvas.elements.size(); ++i)
+            lookup.emplace(canvas.elements[i]->id, std::make_pair(static_cast<uint32_t>(i), canvas.elements[i].get()));
+    }
+
+    for (uint64_t id : order)
+    {
+        Pending &p = pending[id];
+        if (!p.removed && need_lookup)
+        {
+            auto it = lookup.find(id);
+            if (it == lookup.end())
+                p.removed = true; // указатель устарел, элемента больше нет
+            else
+                p.element = it->second.second;
+        }
+
+        if (p.removed)
+        {
+            if (p.existed_before)
+                out.removed.push_back(id);
+            continue;
+        }
+        if (p.added)
+        {
+            // Удалён и добавлен заново в одном кадре — для подписчиков это замена
+            if (p.existed_before)
+                out.removed.push_back(id);
+            out.added.emplace_back(need_lookup ? lookup[id].first : p.index, p.element);
+        }
+        else if (p.modified)
+        {
+            out.modified.push_back(p.element);
+        }
+        else if (p.append_from != std::numeric_limits<uint32_t>::max())
+        {
+            out.appended.emplace_back(p.element, p.append_from);
+        }
+    }
+
+    std::sort(out.added.begin(), out.added.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    return out;
+}
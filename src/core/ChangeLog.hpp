@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+struct CanvasElement;
+struct CanvasState;
+
+enum class ChangeKind : uint8_t
+{
+    Added,
+    Modified,
+    Appended, // к штриху добавлены точки, начиная с from
+    Removed
+};
+
+// Запись журнала изменений документа. element == nullptr означает, что
+// указатель устарел (например, после restore) и элемент ищется по id
+struct ElementChange
+{
+    static constexpr uint32_t kNoIndex = std::numeric_limits<uint32_t>::max();
+
+    ChangeKind kind;
+    uint64_t id;
+    CanvasElement *element;
+    // Appended — первая новая точка; Added — позиция в elements при записи
+    // (подсказка: CollectChanges проверяет её и ищет по id, если она устарела)
+    uint32_t from = 0;
+};
+
+// Изменения за кадр, сведённые к одной записи на элемент.
+// Применять в порядке: removed, added (по возрастанию индекса), modified, appended
+struct FrameChanges
+{
+    std::vector<uint64_t> removed;
+    std::vector<std::pair<uint32_t, CanvasElement *>> added; // (индекс в elements, элемент)
+    std::vector<CanvasElement *> modified;
+    std::vector<std::pair<CanvasElement *, uint32_t>> appended; // (штрих, первая новая точка)
+
+    bool empty() const { return removed.empty() && added.empty() && modified.empty() && appended.empty(); }
+};
+
+// Забирает накопленный журнал canvas.changes и сводит его
+FrameChanges CollectChanges(CanvasState &canvas);
@@ -1,22 +1,114 @@
 #include "core/History.hpp"
+#include "util/MemoryStats.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+size_t HistoryPatch::memory_bytes() const {
+    size_t bytes = (before.capacity() + after.capacity()) * sizeof(Item);
+    for (const Item& item : before)
+        if (item.element) bytes += item.element->memory_bytes();
+    for (const Item& item : after)
+        if (item.element) bytes += item.element->memory_bytes();
+    return bytes;
+}
+
+History::~History() {
+    clear_stack(undo_stack);
+    clear_stack(redo_stack);
+}
+
+void History::push_entry(std::vector<Entry>& stack, Entry&& entry) {
+    entry.bytes = entry.is_patch ? entry.patch.memory_bytes() : entry.state.memory_bytes();
+    MemTrackAlloc(MemCategory::History, entry.bytes);
+    stack.push_back(std::move(entry));
+}
+
+History::Entry History::pop_entry(std::vector<Entry>& stack) {
+    Entry entry = std::move(stack.back());
+    stack.pop_back();
+    MemTrackFree(MemCategory::History, entry.bytes);
+    return entry;
+}
+
+void History::clear_stack(std::vector<Entry>& stack) {
+    for (const Entry& entry : stack) MemTrackFree(MemCategory::History, entry.bytes);
+    stack.clear();
+}
+
+void History::swap_patch(CanvasState& canvas, std::vector<HistoryPatch::Item>& from,
+                         std::vector<HistoryPatch::Item>& to) {
+    std::unordered_map<uint64_t, HistoryPatch::Item*> taken;
+    taken.reserve(from.size());
+    for (HistoryPatch::Item& item : from) taken[item.id] = &item;
+
+    // Один проход: элементы стороны from уходят в патч, элементы стороны to
+    // встают на свои позиции (to отсортирован по index)
+    std::vector<std::unique_ptr<CanvasElement>> result;
+    result.reserve(canvas.elements.size() - std::min(from.size(), canvas.elements.size()) + to.size());
+    size_t next = 0;
+    auto place_due = [&] {
+        while (next < to.size() && to[next].index <= result.size()) {
+            CanvasElement* el = to[next].element.get();
+            result.push_back(std::move(to[next].element));
+            canvas.note_added(el, result.size() - 1);
+            next++;
+        }
+    };
+    for (auto& el : canvas.elements) {
+        place_due();
+        auto it = taken.find(el->id);
+        if (it != taken.end()) {
+            if (canvas.selected_element == el.get()) canvas.selected_element = nullptr;
+            canvas.note_removed(el->id);
+            it->second->element = std::move(el);
+            continue;
+        }
+        result.push_back(std::move(el));
+    }
+    place_due();
+    for (; next < to.size(); ++next) {
+        CanvasElement* el = to[next].element.get();
+        result.push_back(std::move(to[next].element));
+        canvas.note_added(el, result.size() - 1);
+    }
+    canvas.elements = std::move(result);
+}
 
 void History::push(const CanvasState& state) {
-    undo_stack.push_back(state);
-    redo_stack.clear();
+    Entry entry;
+    entry.state = state;
+    push_entry(undo_stack, std::move(entry));
+    clear_stack(redo_stack);
+}
+
+void History::push_patch(HistoryPatch&& patch) {
+    if (patch.empty()) return;
+    Entry entry;
+    entry.is_patch = true;
+    entry.patch = std::move(patch);
+    push_entry(undo_stack, std::move(entry));
+    clear_stack(redo_stack);
 }
 
-std::optional<CanvasState> History::undo(const CanvasState& current) {
-    if (undo_stack.empty()) return std::nullopt;
-    redo_stack.push_back(current);
-    CanvasState prev = undo_stack.back();
-    undo_stack.pop_back();
-    return prev;
+bool History::undo(CanvasState& canvas) {
+    if (undo_stack.empty()) return false;
+    Entry entry = pop_entry(undo_stack);
+    if (entry.is_patch)
+        swap_patch(canvas, entry.patch.after, entry.patch.before);
+    else
+        canvas.restore(std::move(entry.state)); // теперь в entry.state текущий документ для redo
+    push_entry(redo_stack, std::move(entry));
+    return true;
 }
 
-std::optional<CanvasState> History::redo(const CanvasState& current) {
-    if (redo_stack.empty()) return std::nullopt;
-    undo_stack.push_back(current);
-    CanvasState next = redo_stack.back();
-    redo_stack.pop_back();
-    return next;
+bool History::redo(CanvasState& canvas) {
+    if (redo_stack.empty()) return false;
+    Entry entry = pop_entry(redo_stack);
+    if (entry.is_patch)
+        swap_patch(canvas, entry.patch.before, entry.patch.after);
+    else
+        canvas.restore(std::move(entry.state));
+    push_entry(undo_stack, std::move(entry));
+    return true;
 }
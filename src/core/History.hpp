@@ -1,16 +1,64 @@
 #pragma once
 #include "core/CanvasState.hpp"
-#include <optional>
 #include <vector>
 
-// Простой менеджер undo/redo через снимки
+// Компактная запись истории для действия, уже применённого к документу:
+// только затронутые элементы с их позициями до и после. Элементы той
+// стороны, которой сейчас нет в документе, хранятся в записи
+struct HistoryPatch {
+    struct Item {
+        size_t index; // позиция в документе соответствующей стороны
+        uint64_t id;
+        std::unique_ptr<CanvasElement> element; // nullptr, пока элемент в документе
+    };
+    std::vector<Item> before; // по возрастанию index
+    std::vector<Item> after;  // по возрастанию index
+
+    bool empty() const { return before.empty() && after.empty(); }
+    size_t memory_bytes() const;
+};
+
+// Менеджер undo/redo: снимки документа и компактные патчи.
+// Объём записей учитывается в MemCategory::History
 class History {
 public:
+    History() = default;
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+    ~History();
+
+    // Снимок перед изменением
     void push(const CanvasState& state);
-    std::optional<CanvasState> undo(const CanvasState& current);
-    std::optional<CanvasState> redo(const CanvasState& current);
+    // Патч уже выполненного действия (документ в состоянии "after")
+    void push_patch(HistoryPatch&& patch);
+
+    // Возвращают false, если отменять/повторять нечего
+    bool undo(CanvasState& canvas);
+    bool redo(CanvasState& canvas);
+
+    size_t snapshot_count() const { return undo_stack.size() + redo_stack.size(); }
+
+    // Обмен записями с другой историей (у каждой страницы блокнота своя)
+    void swap(History& other) {
+        undo_stack.swap(other.undo_stack);
+        redo_stack.swap(other.redo_stack);
+    }
 
 private:
-    std::vector<CanvasState> undo_stack;
-    std::vector<CanvasState> redo_stack;
+    struct Entry {
+        bool is_patch = false;
+        CanvasState state;
+        HistoryPatch patch;
+        size_t bytes = 0;
+    };
+
+    static void push_entry(std::vector<Entry>& stack, Entry&& entry);
+    static Entry pop_entry(std::vector<Entry>& stack);
+    static void clear_stack(std::vector<Entry>& stack);
+    // Заменяет в документе элементы стороны from на элементы стороны to
+    static void swap_patch(CanvasState& canvas, std::vector<HistoryPatch::Item>& from,
+                           std::vector<HistoryPatch::Item>& to);
+
+    std::vector<Entry> undo_stack;
+    std::vector<Entry> redo_stack;
 };
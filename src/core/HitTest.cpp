@@ -0,0 +1,205 @@
+#include "core/HitTest.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define MYNOTES_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(MYNOTES_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MYNOTES_TARGET_AVX __attribute__((target("avx")))
+#define MYNOTES_HAS_AVX_KERNEL 1
+#endif
+
+static inline float segment_dist2(const ImVec2 &a, const ImVec2 &b, const ImVec2 &p)
+{
+    float abx = b.x - a.x, aby = b.y - a.y;
+    float apx = p.x - a.x, apy = p.y - a.y;
+    float len2 = abx * abx + aby * aby;
+    float t = len2 > 0.0f ? std::clamp((apx * abx + apy * aby) / len2, 0.0f, 1.0f) : 0.0f;
+    float dx = apx - abx * t, dy = apy - aby * t;
+    return dx * dx + dy * dy;
+}
+
+bool PolylineNearScalar(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius)
+{
+    const float r2 = radius * radius;
+    if (count == 1)
+        return segment_dist2(pts[0], pts[0], p) <= r2;
+    for (size_t i = 0; i + 1 < count; ++i)
+    {
+        if (segment_dist2(pts[i], pts[i + 1], p) <= r2)
+            return true;
+    }
+    return false;
+}
+
+#if defined(MYNOTES_X86)
+// 4 segments per iteration. Points are AoS (x,y pairs); a 2x__m128 load of
+// pts[i..i+3] is deinterleaved into xs/ys, the same is done for pts[i+1..i+4].
+static bool polyline_near_sse(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius)
+{
+    if (count < 5)
+        return PolylineNearScalar(pts, count, p, radius);
+
+    const float *f = &pts[0].x;
+    const __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y);
+    const __m128 r2 = _mm_set1_ps(radius * radius);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), eps = _mm_set1_ps(1e-20f);
+
+    size_t i = 0;
+    for (; i + 4 < count; i += 4)
+    {
+        __m128 a_lo = _mm_loadu_ps(f + 2 * i), a_hi = _mm_loadu_ps(f + 2 * i + 4);
+        __m128 b_lo = _mm_loadu_ps(f + 2 * i + 2), b_hi = _mm_loadu_ps(f + 2 * i + 6);
+        __m128 ax = _mm_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ay = _mm_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 bx = _mm_shuffle_ps(b_lo, b_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 by = _mm_shuffle_ps(b_lo, b_hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 abx = _mm_sub_ps(bx, ax), aby = _mm_sub_ps(by, ay);
+        __m128 apx = _mm_sub_ps(px, ax), apy = _mm_sub_ps(py, ay);
+        __m128 dot = _mm_add_ps(_mm_mul_ps(apx, abx), _mm_mul_ps(apy, aby));
+        __m128 len2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(abx, abx), _mm_mul_ps(aby, aby)), eps);
+        __m128 t = _mm_min_ps(_mm_max_ps(_mm_div_ps(dot, len2), zero), one);
+        __m128 dx = _mm_sub_ps(apx, _mm_mul_ps(abx, t));
+        __m128 dy = _mm_sub_ps(apy, _mm_mul_ps(aby, t));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        if (_mm_movemask_ps(_mm_cmple_ps(d2, r2)))
+            return true;
+    }
+    return PolylineNearScalar(pts + i, count - i, p, radius);
+}
+#endif
+
+#if defined(MYNOTES_HAS_AVX_KERNEL)
+// 8 segments per iteration. _mm256_shuffle_ps works per 128-bit lane, so the
+// segments come out permuted — irrelevant for an "any segment" test as long
+// as the start and end points are permuted identically.
+MYNOTES_TARGET_AVX
+static bool polyline_near_avx(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius)
+{
+    if (count < 9)
+        return polyline_near_sse(pts, count, p, radius);
+
+    const float *f = &pts[0].x;
+    const __m256 px = _mm256_set1_ps(p.x), py = _mm256_set1_ps(p.y);
+    const __m256 r2 = _mm256_set1_ps(radius * radius);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), eps = _mm256_set1_ps(1e-20f);
+
+    size_t i = 0;
+    for (; i + 8 < count; i += 8)
+    {
+        __m256 a_lo = _mm256_loadu_ps(f + 2 * i), a_hi = _mm256_loadu_ps(f + 2 * i + 8);
+        __m256 b_lo = _mm256_loadu_ps(f + 2 * i + 2), b_hi = _mm256_loadu_ps(f + 2 * i + 10);
+        __m256 ax = _mm256_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 ay = _mm256_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 bx = _mm256_shuffle_ps(b_lo, b_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 by = _mm256_shuffle_ps(b_lo, b_hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m256 abx = _mm256_sub_ps(bx, ax), aby = _mm256_sub_ps(by, ay);
+        __m256 apx = _mm256_sub_ps(px, ax), apy = _mm256_sub_ps(py, ay);
+        __m256 dot = _mm256_add_ps(_mm256_mul_ps(apx, abx), _mm256_mul_ps(apy, aby));
+        __m256 len2 = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(abx, abx), _mm256_mul_ps(aby, aby)), eps);
+        __m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_div_ps(dot, len2), zero), one);
+        __m256 dx = _mm256_sub_ps(apx, _mm256_mul_ps(abx, t));
+        __m256 dy = _mm256_sub_ps(apy, _mm256_mul_ps(aby, t));
+        __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        if (_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ)))
+            return true;
+    }
+    return PolylineNearScalar(pts + i, count - i, p, radius);
+}
+#endif
+
+using PolylineKernel = bool (*)(const ImVec2 *, size_t, const ImVec2 &, float);
+
+static PolylineKernel select_kernel(const char **name)
+{
+#if defined(MYNOTES_HAS_AVX_KERNEL)
+    if (__builtin_cpu_supports("avx"))
+    {
+        *name = "avx";
+        return polyline_near_avx;
+    }
+#endif
+#if defined(MYNOTES_X86)
+    *name = "sse";
+    return polyline_near_sse;
+#else
+    *name = "scalar";
+    return PolylineNearScalar;
+#endif
+}
+
+static const char *g_kernel_name = "scalar";
+static const PolylineKernel g_kernel = select_kernel(&g_kernel_name);
+
+bool PolylineNear(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius)
+{
+    if (count == 0)
+        return false;
+    return g_kernel(pts, count, p, radius);
+}
+
+const char *PolylineKernelName()
+{
+    return g_kernel_name;
+}
+
+// ---------- Benchmark ----------
+
+// The loop Stroke::contains and the eraser used before: vertices only.
+static bool vertex_loop(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float dx = p.x - pts[i].x, dy = p.y - pts[i].y;
+        if (dx * dx + dy * dy <= radius * radius)
+            return true;
+    }
+    return false;
+}
+
+HitTestBenchmark RunHitTestBenchmark(size_t segments)
+{
+    // Strokes of 256 random-walk points, as many as `segments` fills (about
+    // 4100 for the default 1M segments); queries far enough to miss so every
+    // segment is visited (worst case, no early exit).
+    const size_t stroke_len = 256;
+    const size_t stroke_count = std::max<size_t>(1, segments / (stroke_len - 1));
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> step(-3.0f, 3.0f);
+    std::vector<ImVec2> pts(stroke_count * stroke_len);
+    for (size_t s = 0; s < stroke_count; ++s)
+    {
+        ImVec2 cur(0.0f, 0.0f);
+        for (size_t i = 0; i < stroke_len; ++i)
+        {
+            cur.x += 2.0f + step(rng);
+            cur.y += step(rng);
+            pts[s * stroke_len + i] = cur;
+        }
+    }
+    const ImVec2 query(-1000.0f, -1000.0f);
+
+    auto measure = [&](PolylineKernel kernel) {
+        volatile bool sink = false;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t s = 0; s < stroke_count; ++s)
+            sink = sink | kernel(pts.data() + s * stroke_len, stroke_len, query, 4.0f);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return sec > 0.0 ? double(stroke_count * (stroke_len - 1)) / sec : 0.0;
+    };
+
+    HitTestBenchmark result;
+    result.segments = stroke_count * (stroke_len - 1);
+    result.vertex_loop_sps = measure(vertex_loop);
+    result.scalar_sps = measure(PolylineNearScalar);
+    result.simd_sps = measure(g_kernel);
+    return result;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <imgui.h>
+
+// Point-to-polyline proximity test: true if any segment of pts[0..count)
+// lies within radius of p. A single point is treated as a degenerate segment.
+// Uses AVX or SSE when available (selected once at runtime), scalar otherwise.
+bool PolylineNear(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius);
+
+// Reference implementation, also used for the tail of the SIMD loops.
+bool PolylineNearScalar(const ImVec2 *pts, size_t count, const ImVec2 &p, float radius);
+
+// Name of the kernel PolylineNear dispatches to ("avx", "sse", "scalar")
+const char *PolylineKernelName();
+
+struct HitTestBenchmark
+{
+    size_t segments = 0;          // segments tested per run
+    double vertex_loop_sps = 0.0; // old vertex-only loop, segments per second
+    double scalar_sps = 0.0;
+    double simd_sps = 0.0;
+};
+
+// Times the kernels on synthetic handwriting-like strokes.
+HitTestBenchmark RunHitTestBenchmark(size_t segments = 1 << 20);
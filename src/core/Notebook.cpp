@@ -0,0 +1,340 @@
+#include "core/Notebook.hpp"
+#include "core/Serialize.hpp"
+#include "util/DiskCache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kNotebookMagic = 0x424e'4e4d; // "MNNB"
+constexpr uint32_t kNotebookFormat = 1;
+// magic, format, число страниц, текущая страница, наибольший id элемента
+constexpr size_t kHeaderSize = 4 + 4 + 4 + 4 + 8;
+// смещение, размер, ключ, число элементов, pan, zoom
+constexpr size_t kEntrySize = 8 + 8 + 8 + 4 + 8 + 4;
+constexpr uint32_t kMaxPages = 1u << 20;
+constexpr size_t kCopyChunk = size_t(1) << 20;
+
+void fail_with(std::string* error, const char* message) {
+    if (error) *error = message;
+}
+
+} // namespace
+
+std::shared_ptr<NotebookFile> NotebookFile::Open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::shared_ptr<NotebookFile> file(new NotebookFile());
+    file->fd = fd;
+    file->file_size = static_cast<uint64_t>(st.st_size);
+    return file;
+}
+
+NotebookFile::~NotebookFile() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool NotebookFile::read(uint64_t offset, void* dst, size_t size) const {
+    if (offset > file_size || size > file_size - offset) return false;
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    while (size > 0) {
+        ssize_t n = ::pread(fd, out, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        out += n;
+        offset += static_cast<uint64_t>(n);
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+PageBytes PageData::load() const {
+    if (bytes) return bytes;
+    if (!file) return nullptr;
+    auto out = std::make_shared<std::vector<uint8_t>>();
+    if (size > file->size()) return nullptr;
+    out->resize(size);
+    if (!file->read(offset, out->data(), out->size())) return nullptr;
+    return out;
+}
+
+PageBytes SerializePage(const CanvasState& page) {
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    ByteWriter w(*bytes);
+    w.put<uint32_t>(static_cast<uint32_t>(page.elements.size()));
+    for (const auto& el : page.elements) WriteElement(w, *el);
+    return bytes;
+}
+
+bool ParsePage(const std::vector<uint8_t>& bytes, CanvasState& page) {
+    ByteReader r(bytes.data(), bytes.size());
+    uint32_t count = r.get<uint32_t>();
+    if (r.failed() || count > r.remaining()) return false;
+    page.elements.clear();
+    page.elements.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::unique_ptr<CanvasElement> el = ReadElement(r);
+        if (!el) return false;
+        page.elements.push_back(std::move(el));
+    }
+    return r.remaining() == 0;
+}
+
+uint64_t PageKey(const std::vector<uint8_t>& bytes) {
+    Fnv1a h;
+    h.add(bytes.data(), bytes.size());
+    return h.h;
+}
+
+Notebook::Notebook() {
+    pages.push_back(empty_page());
+}
+
+Notebook::Page Notebook::empty_page() {
+    static const PageBytes empty = SerializePage(CanvasState());
+    Page page;
+    page.info.key = PageKey(*empty);
+    page.data.bytes = empty;
+    return page;
+}
+
+bool Notebook::open(const std::string& path, CanvasState& canvas, History& history, std::string* error) {
+    std::shared_ptr<NotebookFile> opened = NotebookFile::Open(path);
+    if (!opened) {
+        fail_with(error, "cannot open file");
+        return false;
+    }
+
+    uint8_t header[kHeaderSize];
+    if (!opened->read(0, header, sizeof(header))) {
+        fail_with(error, "not a notebook");
+        return false;
+    }
+    ByteReader hr(header, sizeof(header));
+    uint32_t magic = hr.get<uint32_t>();
+    uint32_t format = hr.get<uint32_t>();
+    uint32_t count = hr.get<uint32_t>();
+    uint32_t current = hr.get<uint32_t>();
+    uint64_t max_id = hr.get<uint64_t>();
+    if (magic != kNotebookMagic || format != kNotebookFormat) {
+        fail_with(error, "not a notebook");
+        return false;
+    }
+    if (count == 0 || count > kMaxPages || current >= count) {
+        fail_with(error, "corrupt page table");
+        return false;
+    }
+
+    // Таблица страниц — единственное, что читается для всех страниц
+    const uint64_t table_end = kHeaderSize + uint64_t(count) * kEntrySize;
+    std::vector<uint8_t> table(size_t(count) * kEntrySize);
+    if (!opened->read(kHeaderSize, table.data(), table.size())) {
+        fail_with(error, "corrupt page table");
+        return false;
+    }
+    ByteReader tr(table.data(), table.size());
+    std::vector<Page> loaded(count);
+    for (Page& page : loaded) {
+        page.data.file = opened;
+        page.data.offset = tr.get<uint64_t>();
+        page.data.size = tr.get<uint64_t>();
+        page.info.key = tr.get<uint64_t>();
+        page.info.element_count = tr.get<uint32_t>();
+        page.info.pan.x = tr.get<float>();
+        page.info.pan.y = tr.get<float>();
+        page.info.zoom = tr.get<float>();
+        if (page.data.offset < table_end || page.data.offset > opened->size() ||
+            page.data.size > opened->size() - page.data.offset || !(page.info.zoom > 0.0f)) {
+            fail_with(error, "corrupt page table");
+            return false;
+        }
+    }
+
+    // Загруженные id не должны совпасть с id новых элементов
+    ReserveElementIds(max_id);
+    CanvasState page;
+    PageBytes bytes = loaded[current].data.load();
+    if (!bytes || !ParsePage(*bytes, page)) {
+        fail_with(error, "corrupt page");
+        return false;
+    }
+    page.pan = loaded[current].info.pan;
+    page.zoom = loaded[current].info.zoom;
+
+    file_path = path;
+    file = std::move(opened);
+    pages = std::move(loaded);
+    current_page = current;
+    canvas.replace(std::move(page));
+    // История прежнего документа к новому не относится
+    History fresh;
+    history.swap(fresh);
+    skip_changes = canvas.changes.size();
+    dirty = false;
+    serial++;
+    return true;
+}
+
+bool Notebook::save(const std::string& path, const CanvasState& canvas, std::string* error) {
+    commit_current(canvas);
+
+    // Смещения известны заранее: размеры всех страниц уже есть в таблице
+    std::vector<uint8_t> head;
+    ByteWriter w(head);
+    w.put(kNotebookMagic);
+    w.put(kNotebookFormat);
+    w.put<uint32_t>(static_cast<uint32_t>(pages.size()));
+    w.put<uint32_t>(static_cast<uint32_t>(current_page));
+    w.put<uint64_t>(ElementIdCounter().load(std::memory_order_relaxed) - 1);
+    std::vector<PageData> written(pages.size());
+    uint64_t offset = kHeaderSize + uint64_t(pages.size()) * kEntrySize;
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const Page& page = pages[i];
+        written[i].offset = offset;
+        written[i].size = page.data.bytes ? page.data.bytes->size() : page.data.size;
+        offset += written[i].size;
+        w.put(written[i].offset);
+        w.put(written[i].size);
+        w.put(page.info.key);
+        w.put(page.info.element_count);
+        w.put(page.info.pan.x);
+        w.put(page.info.pan.y);
+        w.put(page.info.zoom);
+    }
+
+    // Во временный файл и переименование: прежний файл цел до конца записи,
+    // а уже открытые дескрипторы продолжают читать его содержимое
+    std::string tmp = path + ".tmp";
+    FILE* out = std::fopen(tmp.c_str(), "wb");
+    if (!out) {
+        fail_with(error, "cannot create file");
+        return false;
+    }
+    bool ok = std::fwrite(head.data(), 1, head.size(), out) == head.size();
+    std::vector<uint8_t> chunk;
+    for (size_t i = 0; i < pages.size() && ok; ++i) {
+        const PageData& data = pages[i].data;
+        if (data.bytes) {
+            ok = std::fwrite(data.bytes->data(), 1, data.bytes->size(), out) == data.bytes->size();
+            continue;
+        }
+        // Несохранённых правок нет — страница копируется из прежнего файла кусками
+        for (uint64_t pos = 0; pos < data.size && ok; pos += chunk.size()) {
+            chunk.resize(static_cast<size_t>(std::min<uint64_t>(kCopyChunk, data.size - pos)));
+            ok = data.file && data.file->read(data.offset + pos, chunk.data(), chunk.size()) &&
+                 std::fwrite(chunk.data(), 1, chunk.size(), out) == chunk.size();
+        }
+    }
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        fail_with(error, "write error");
+        return false;
+    }
+
+    std::shared_ptr<NotebookFile> reopened = NotebookFile::Open(path);
+    if (!reopened) {
+        // Файл записан, страницы остаются в памяти и в прежнем файле
+        fail_with(error, "cannot reopen saved file");
+        return false;
+    }
+    for (size_t i = 0; i < pages.size(); ++i) {
+        written[i].file = reopened;
+        pages[i].data = std::move(written[i]);
+    }
+    file = std::move(reopened);
+    file_path = path;
+    return true;
+}
+
+bool Notebook::switch_to(size_t index, CanvasState& canvas, History& history, std::string* error) {
+    if (index >= pages.size()) return false;
+    if (index == current_page) return true;
+
+    // Одна страница с диска на UI-потоке; остальные не затрагиваются
+    CanvasState page;
+    PageBytes bytes = pages[index].data.load();
+    if (!bytes || !ParsePage(*bytes, page)) {
+        fail_with(error, "cannot read page");
+        return false;
+    }
+    page.pan = pages[index].info.pan;
+    page.zoom = pages[index].info.zoom;
+
+    commit_current(canvas);
+    Page& from = pages[current_page];
+    from.history = std::make_unique<History>();
+    from.history->swap(history);
+    Page& to = pages[index];
+    if (to.history) {
+        history.swap(*to.history);
+        to.history.reset();
+    }
+
+    canvas.replace(std::move(page));
+    current_page = index;
+    skip_changes = canvas.changes.size();
+    dirty = false;
+    serial++;
+    return true;
+}
+
+void Notebook::add_page(CanvasState& canvas, History& history) {
+    pages.insert(pages.begin() + static_cast<std::ptrdiff_t>(current_page) + 1, empty_page());
+    switch_to(current_page + 1, canvas, history);
+}
+
+void Notebook::note_pending_changes(const CanvasState& canvas) {
+    if (canvas.changes.size() > skip_changes) {
+        dirty = true;
+        serial++;
+        last_edit_time = std::chrono::steady_clock::now();
+    }
+    skip_changes = canvas.changes.size();
+}
+
+void Notebook::track_changes(const CanvasState& canvas) {
+    note_pending_changes(canvas);
+    skip_changes = 0; // журнал сейчас заберёт CollectChanges
+}
+
+void Notebook::commit_current(const CanvasState& canvas) {
+    note_pending_changes(canvas);
+    Page& page = pages[current_page];
+    page.info.pan = canvas.pan;
+    page.info.zoom = canvas.zoom;
+    if (!dirty) return;
+    PageBytes bytes = SerializePage(canvas);
+    page.info.key = PageKey(*bytes);
+    page.info.element_count = static_cast<uint32_t>(canvas.elements.size());
+    page.data = PageData();
+    page.data.bytes = std::move(bytes);
+    dirty = false;
+}
+
+void Notebook::adopt_snapshot(uint64_t snapshot_serial, uint64_t key, PageBytes bytes, uint32_t element_count) {
+    if (!dirty || snapshot_serial != serial || !bytes) return;
+    Page& page = pages[current_page];
+    page.info.key = key;
+    page.info.element_count = element_count;
+    page.data = PageData();
+    page.data.bytes = std::move(bytes);
+    dirty = false;
+}
+
+size_t Notebook::memory_bytes() const {
+    size_t bytes = pages.capacity() * sizeof(Page);
+    for (const Page& page : pages)
+        if (page.data.bytes) bytes += page.data.bytes->capacity();
+    return bytes;
+}
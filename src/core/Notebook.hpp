@@ -0,0 +1,129 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <imgui.h>
+#include "core/CanvasState.hpp"
+#include "core/History.hpp"
+
+// Открытый файл блокнота. Страницы читаются позиционным чтением из любого
+// потока; после сохранения прежний файл остаётся доступен задачам, которые
+// ещё держат на него ссылку
+class NotebookFile
+{
+public:
+    static std::shared_ptr<NotebookFile> Open(const std::string &path);
+    ~NotebookFile();
+
+    NotebookFile(const NotebookFile &) = delete;
+    NotebookFile &operator=(const NotebookFile &) = delete;
+
+    bool read(uint64_t offset, void *dst, size_t size) const;
+    uint64_t size() const { return file_size; }
+
+private:
+    NotebookFile() = default;
+
+    int fd = -1;
+    uint64_t file_size = 0;
+};
+
+using PageBytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Содержимое страницы вне редактора: сериализованные элементы в памяти
+// (изменённая и ещё не сохранённая страница) либо участок файла блокнота
+struct PageData
+{
+    PageBytes bytes;
+    std::shared_ptr<NotebookFile> file;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+
+    // Из любого потока; nullptr при ошибке чтения
+    PageBytes load() const;
+};
+
+// Содержимое страницы: число элементов и элементы (Serialize). Вид
+// (pan/zoom) хранится в таблице страниц и в содержимое не входит
+PageBytes SerializePage(const CanvasState &page);
+bool ParsePage(const std::vector<uint8_t> &bytes, CanvasState &page);
+// Хэш содержимого: одинаковые страницы дают один ключ (ключ миниатюры)
+uint64_t PageKey(const std::vector<uint8_t> &bytes);
+
+struct PageInfo
+{
+    uint64_t key = 0; // ключ содержимого на момент последней фиксации страницы
+    uint32_t element_count = 0;
+    ImVec2 pan = ImVec2(0.0f, 0.0f);
+    float zoom = 1.0f;
+};
+
+// Многостраничный документ. Редактируется всегда одна страница — она живёт
+// в CanvasState, остальные хранятся сериализованными (в памяти или в файле)
+// вместе со своей историей undo/redo.
+// Открытие читает только заголовок и таблицу страниц и загружает текущую
+// страницу, поэтому не зависит от числа страниц. Только UI-поток
+class Notebook
+{
+public:
+    Notebook(); // одна пустая страница
+
+    Notebook(const Notebook &) = delete;
+    Notebook &operator=(const Notebook &) = delete;
+
+    bool open(const std::string &path, CanvasState &canvas, History &history, std::string *error = nullptr);
+    // Текущая страница сериализуется, остальные пишутся из памяти или
+    // копируются из прежнего файла. Запись во временный файл и переименование
+    bool save(const std::string &path, const CanvasState &canvas, std::string *error = nullptr);
+    const std::string &path() const { return file_path; }
+
+    size_t page_count() const { return pages.size(); }
+    size_t current() const { return current_page; }
+    const PageInfo &info(size_t index) const { return pages[index].info; }
+    // Для фоновых потоков: только ссылки, файл здесь не читается
+    const PageData &data(size_t index) const { return pages[index].data; }
+
+    // Текущая страница фиксируется, новая заменяет документ через
+    // CanvasState::replace (в журнал попадает полная замена элементов)
+    bool switch_to(size_t index, CanvasState &canvas, History &history, std::string *error = nullptr);
+    // Пустая страница после текущей; становится текущей
+    void add_page(CanvasState &canvas, History &history);
+
+    // Каждый кадр до CollectChanges: отмечает правки текущей страницы
+    void track_changes(const CanvasState &canvas);
+    // Текущая страница изменена после последней фиксации
+    bool current_dirty() const { return dirty; }
+    // Растёт с каждой правкой и при смене страницы
+    uint64_t edit_serial() const { return serial; }
+    std::chrono::steady_clock::time_point last_edit() const { return last_edit_time; }
+    // Фоновый снимок текущей страницы (SerializePage) становится её
+    // содержимым, если после снимка правок не было
+    void adopt_snapshot(uint64_t snapshot_serial, uint64_t key, PageBytes bytes, uint32_t element_count);
+
+    // Несохранённые страницы в памяти
+    size_t memory_bytes() const;
+
+private:
+    struct Page
+    {
+        PageInfo info;
+        PageData data;
+        std::unique_ptr<History> history; // у текущей страницы — внешняя History
+    };
+
+    void note_pending_changes(const CanvasState &canvas);
+    void commit_current(const CanvasState &canvas);
+    static Page empty_page();
+
+    std::string file_path;
+    std::shared_ptr<NotebookFile> file;
+    std::vector<Page> pages;
+    size_t current_page = 0;
+    bool dirty = false;
+    uint64_t serial = 0;
+    size_t skip_changes = 0; // записи журнала от replace при смене страницы
+    std::chrono::steady_clock::time_point last_edit_time;
+};
@@ -0,0 +1,52 @@
+#include "core/PointCodec.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MYNOTES_SSE2 1
+#endif
+
+float QuantizeScale(const ImVec2 &min, const ImVec2 &max)
+{
+    float extent = std::max(max.x - min.x, max.y - min.y);
+    return extent > 0.0f ? extent / 65535.0f : 1.0f;
+}
+
+void EncodePoints(const ImVec2 *pts, size_t count, const ImVec2 &origin, float scale, uint16_t *out)
+{
+    const float inv = 1.0f / scale;
+    for (size_t i = 0; i < count; ++i)
+    {
+        float qx = std::round((pts[i].x - origin.x) * inv);
+        float qy = std::round((pts[i].y - origin.y) * inv);
+        out[2 * i] = static_cast<uint16_t>(std::clamp(qx, 0.0f, 65535.0f));
+        out[2 * i + 1] = static_cast<uint16_t>(std::clamp(qy, 0.0f, 65535.0f));
+    }
+}
+
+void DecodePoints(const uint16_t *q, size_t count, const ImVec2 &offset, float scale, ImVec2 *out)
+{
+    size_t i = 0;
+#if defined(MYNOTES_SSE2)
+    // 4 points = 8 codes = one 128-bit load; the x,y interleaving of the input
+    // matches ImVec2 so results are stored without shuffles.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 off = _mm_setr_ps(offset.x, offset.y, offset.x, offset.y);
+    const __m128 s = _mm_set1_ps(scale);
+    float *dst = &out[0].x;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i codes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(q + 2 * i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(codes, zero));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(codes, zero));
+        _mm_storeu_ps(dst + 2 * i, _mm_add_ps(off, _mm_mul_ps(lo, s)));
+        _mm_storeu_ps(dst + 2 * i + 4, _mm_add_ps(off, _mm_mul_ps(hi, s)));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        out[i].x = offset.x + q[2 * i] * scale;
+        out[i].y = offset.y + q[2 * i + 1] * scale;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <imgui.h>
+
+// 16-bit fixed-point encoding of stroke points relative to the stroke's
+// bounding box origin: p = origin + q * scale, q in [0, 65535] per axis.
+// Halves point memory (8 -> 4 bytes) for finished strokes.
+
+// Quantization step (canvas units per code) for a box; the larger side spans the full range.
+float QuantizeScale(const ImVec2 &min, const ImVec2 &max);
+
+// Interleaved output: out[2*i] = x, out[2*i+1] = y
+void EncodePoints(const ImVec2 *pts, size_t count, const ImVec2 &origin, float scale, uint16_t *out);
+
+// out[i] = offset + q[i] * scale. Any affine canvas -> screen mapping with
+// uniform zoom folds into offset/scale, so rendering decodes straight into
+// screen space. SSE2 path converts four points per iteration.
+void DecodePoints(const uint16_t *q, size_t count, const ImVec2 &offset, float scale, ImVec2 *out);
@@ -0,0 +1,116 @@
+#include "core/Serialize.hpp"
+
+namespace {
+
+enum ElementTag : uint8_t {
+    TagStroke = 1,
+    TagText = 2,
+    TagImage = 3,
+};
+
+void put_vec2(ByteWriter& w, const ImVec2& v) {
+    w.put(v.x);
+    w.put(v.y);
+}
+
+void put_vec4(ByteWriter& w, const ImVec4& v) {
+    w.put(v.x);
+    w.put(v.y);
+    w.put(v.z);
+    w.put(v.w);
+}
+
+ImVec2 get_vec2(ByteReader& r) {
+    float x = r.get<float>();
+    float y = r.get<float>();
+    return ImVec2(x, y);
+}
+
+ImVec4 get_vec4(ByteReader& r) {
+    float x = r.get<float>();
+    float y = r.get<float>();
+    float z = r.get<float>();
+    float w = r.get<float>();
+    return ImVec4(x, y, z, w);
+}
+
+} // namespace
+
+void WriteElement(ByteWriter& w, const CanvasElement& element) {
+    if (auto stroke = dynamic_cast<const Stroke*>(&element)) {
+        w.put<uint8_t>(TagStroke);
+        w.put(stroke->id);
+        put_vec4(w, stroke->color);
+        w.put(stroke->thickness);
+        put_vec2(w, stroke->bounds_min);
+        put_vec2(w, stroke->bounds_max);
+        w.put<uint8_t>(stroke->is_packed() ? 1 : 0);
+        w.put<uint32_t>(static_cast<uint32_t>(stroke->point_count()));
+        if (stroke->is_packed()) {
+            // An instance is written as a standalone stroke: its transform
+            // folds into the bounds and the quantization step
+            const PackedPoints& packed = stroke->geometry->packed();
+            w.put(stroke->packed_scale());
+            w.put_bytes(packed.data(), packed.size() * sizeof(uint16_t));
+        } else {
+            w.put_bytes(stroke->points.data(), stroke->points.size() * sizeof(ImVec2));
+        }
+    } else if (auto text = dynamic_cast<const TextLabel*>(&element)) {
+        w.put<uint8_t>(TagText);
+        w.put(text->id);
+        put_vec2(w, text->position);
+        put_vec4(w, text->color);
+        w.put(text->size);
+        w.put_string(text->text);
+    } else if (auto image = dynamic_cast<const ImageElement*>(&element)) {
+        // Only the file reference; the renderer decodes the file when it is drawn
+        w.put<uint8_t>(TagImage);
+        w.put(image->id);
+        put_vec2(w, image->position);
+        put_vec2(w, image->size);
+        w.put_string(image->path);
+    }
+}
+
+std::unique_ptr<CanvasElement> ReadElement(ByteReader& r) {
+    uint8_t tag = r.get<uint8_t>();
+    uint64_t id = r.get<uint64_t>();
+
+    std::unique_ptr<CanvasElement> result;
+    if (tag == TagStroke) {
+        auto stroke = std::make_unique<Stroke>();
+        stroke->color = get_vec4(r);
+        stroke->thickness = r.get<float>();
+        stroke->bounds_min = get_vec2(r);
+        stroke->bounds_max = get_vec2(r);
+        bool packed = r.get<uint8_t>() != 0;
+        uint32_t count = r.get<uint32_t>();
+        if (count > r.remaining()) return nullptr; // corrupt size, avoid huge allocations
+        if (packed) {
+            float packed_scale = r.get<float>();
+            PackedPoints data(size_t(count) * 2);
+            r.get_bytes(data.data(), data.size() * sizeof(uint16_t));
+            stroke->set_packed(std::move(data), packed_scale);
+        } else {
+            stroke->points.resize(count);
+            r.get_bytes(stroke->points.data(), stroke->points.size() * sizeof(ImVec2));
+        }
+        result = std::move(stroke);
+    } else if (tag == TagText) {
+        auto text = std::make_unique<TextLabel>();
+        text->position = get_vec2(r);
+        text->color = get_vec4(r);
+        text->size = r.get<float>();
+        text->text = r.get_string();
+        result = std::move(text);
+    } else if (tag == TagImage) {
+        auto image = std::make_unique<ImageElement>();
+        image->position = get_vec2(r);
+        image->size = get_vec2(r);
+        image->path = r.get_string();
+        result = std::move(image);
+    }
+    if (!result || r.failed()) return nullptr;
+    result->id = id; // the revision stays fresh: revisions are per process
+    return result;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "core/CanvasElement.hpp"
+
+// Compact binary encoding of canvas elements (host byte order, both ends
+// are the same machine: replication over a local socket, on-disk caches).
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    template <typename T>
+    void put(const T& v) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+    void put_bytes(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), p, p + size);
+    }
+    void put_string(const std::string& s) {
+        put<uint32_t>(static_cast<uint32_t>(s.size()));
+        put_bytes(s.data(), s.size());
+    }
+    size_t size() const { return out.size(); }
+
+private:
+    std::vector<uint8_t>& out;
+};
+
+// Bounds-checked reader: on overrun it sets failed() and returns zeros.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    T get() {
+        T v{};
+        if (!check(sizeof(T))) return v;
+        std::memcpy(&v, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+    bool get_bytes(void* dst, size_t n) {
+        if (!check(n)) return false;
+        std::memcpy(dst, data + pos, n);
+        pos += n;
+        return true;
+    }
+    std::string get_string() {
+        uint32_t n = get<uint32_t>();
+        if (!check(n)) return {};
+        std::string s(reinterpret_cast<const char*>(data + pos), n);
+        pos += n;
+        return s;
+    }
+
+    bool failed() const { return fail; }
+    size_t remaining() const { return size - pos; }
+    size_t offset() const { return pos; }
+
+private:
+    bool check(size_t n) {
+        if (fail || n > size - pos) {
+            fail = true;
+            return false;
+        }
+        return true;
+    }
+
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool fail = false;
+};
+
+// Element = type tag + id + type-specific payload. Strokes are
+// written in their current storage (packed or full precision).
+void WriteElement(ByteWriter& w, const CanvasElement& element);
+std::unique_ptr<CanvasElement> ReadElement(ByteReader& r);
@@ -0,0 +1,93 @@
+#include "core/SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+void erase_one(std::vector<CanvasElement *> &list, CanvasElement *el)
+{
+    auto it = std::find(list.begin(), list.end(), el);
+    if (it != list.end())
+    {
+        *it = list.back();
+        list.pop_back();
+    }
+}
+
+} // namespace
+
+SpatialGrid::CellRange SpatialGrid::range(const ImVec2 &min, const ImVec2 &max) const
+{
+    const float inv = 1.0f / cell_size;
+    return {static_cast<int>(std::floor(min.x * inv)), static_cast<int>(std::floor(min.y * inv)),
+            static_cast<int>(std::floor(max.x * inv)), static_cast<int>(std::floor(max.y * inv))};
+}
+
+void SpatialGrid::clear()
+{
+    cells.clear();
+    oversized.clear();
+    count = 0;
+}
+
+void SpatialGrid::insert(CanvasElement *el, const ImVec2 &min, const ImVec2 &max)
+{
+    CellRange r = range(min, max);
+    count++;
+    if (r.oversized())
+    {
+        oversized.push_back(el);
+        return;
+    }
+    for (int y = r.y0; y <= r.y1; ++y)
+        for (int x = r.x0; x <= r.x1; ++x)
+            cells[key(x, y)].push_back(el);
+}
+
+void SpatialGrid::remove(CanvasElement *el, const ImVec2 &min, const ImVec2 &max)
+{
+    CellRange r = range(min, max);
+    count--;
+    if (r.oversized())
+    {
+        erase_one(oversized, el);
+        return;
+    }
+    for (int y = r.y0; y <= r.y1; ++y)
+        for (int x = r.x0; x <= r.x1; ++x)
+        {
+            auto it = cells.find(key(x, y));
+            if (it == cells.end())
+                continue;
+            erase_one(it->second, el);
+            if (it->second.empty())
+                cells.erase(it);
+        }
+}
+
+void SpatialGrid::query(const ImVec2 &min, const ImVec2 &max, std::vector<CanvasElement *> &out) const
+{
+    out.clear();
+    out.insert(out.end(), oversized.begin(), oversized.end());
+    CellRange r = range(min, max);
+    if (r.oversized())
+    {
+        // Запрос шире сетки — проще отдать всё
+        for (const auto &[k, list] : cells)
+            out.insert(out.end(), list.begin(), list.end());
+    }
+    else
+    {
+        for (int y = r.y0; y <= r.y1; ++y)
+            for (int x = r.x0; x <= r.x1; ++x)
+            {
+                auto it = cells.find(key(x, y));
+                if (it != cells.end())
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+            }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <imgui.h>
+
+struct CanvasElement;
+
+// Равномерная сетка по bounding box элементов для поиска кандидатов в
+// окрестности точки или пути. Очень большие элементы хранятся отдельным
+// списком и возвращаются всегда
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cell_size = 256.0f) : cell_size(cell_size) {}
+
+    void clear();
+    // min/max при remove должны совпадать с переданными в insert
+    void insert(CanvasElement *el, const ImVec2 &min, const ImVec2 &max);
+    void remove(CanvasElement *el, const ImVec2 &min, const ImVec2 &max);
+
+    // Элементы из ячеек, пересекающих прямоугольник, без повторов
+    void query(const ImVec2 &min, const ImVec2 &max, std::vector<CanvasElement *> &out) const;
+
+    size_t size() const { return count; }
+
+private:
+    struct CellRange
+    {
+        int x0, y0, x1, y1;
+        bool oversized() const { return int64_t(x1 - x0 + 1) * (y1 - y0 + 1) > kMaxCells; }
+    };
+    static constexpr int64_t kMaxCells = 256;
+
+    CellRange range(const ImVec2 &min, const ImVec2 &max) const;
+    static uint64_t key(int x, int y) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(y); }
+
+    float cell_size;
+    size_t count = 0;
+    std::unordered_map<uint64_t, std::vector<CanvasElement *>> cells;
+    std::vector<CanvasElement *> oversized;
+};
@@ -0,0 +1,131 @@
+#include "core/StrokeErase.hpp"
+
+#include <cmath>
+
+namespace
+{
+
+float dot(const ImVec2 &a, const ImVec2 &b) { return a.x * b.x + a.y * b.y; }
+
+float dist2_point_segment(const ImVec2 &p, const ImVec2 &a, const ImVec2 &b)
+{
+    ImVec2 ab = b - a;
+    float len2 = dot(ab, ab);
+    float t = len2 > 0.0f ? std::clamp(dot(p - a, ab) / len2, 0.0f, 1.0f) : 0.0f;
+    ImVec2 d = p - (a + ab * t);
+    return dot(d, d);
+}
+
+// Квадрат расстояния между отрезками p-q и a-b
+float dist2_segment_segment(const ImVec2 &p, const ImVec2 &q, const ImVec2 &a, const ImVec2 &b)
+{
+    ImVec2 r = q - p, s = b - a;
+    float denom = r.x * s.y - r.y * s.x;
+    if (denom != 0.0f)
+    {
+        ImVec2 ap = a - p;
+        float t = (ap.x * s.y - ap.y * s.x) / denom;
+        float u = (ap.x * r.y - ap.y * r.x) / denom;
+        if (t >= 0.0f && t <= 1.0f && u >= 0.0f && u <= 1.0f)
+            return 0.0f; // пересекаются
+    }
+    return std::min(std::min(dist2_point_segment(p, a, b), dist2_point_segment(q, a, b)),
+                    std::min(dist2_point_segment(a, p, q), dist2_point_segment(b, p, q)));
+}
+
+} // namespace
+
+bool CutStroke(const Stroke &stroke, const ImVec2 &a, const ImVec2 &b, float radius,
+               std::vector<std::unique_ptr<Stroke>> &pieces)
+{
+    const size_t count = stroke.point_count();
+    if (count == 0)
+        return false;
+
+    // Ластик касается краёв линии, а не её оси
+    const float reach = radius + stroke.thickness * 0.5f;
+    const float reach2 = reach * reach;
+    if (stroke.bounds_max.x < std::min(a.x, b.x) - reach || stroke.bounds_min.x > std::max(a.x, b.x) + reach ||
+        stroke.bounds_max.y < std::min(a.y, b.y) - reach || stroke.bounds_min.y > std::max(a.y, b.y) + reach)
+        return false;
+
+    thread_local std::vector<ImVec2> pts;
+    stroke.decode_points(pts);
+    auto inside = [&](const ImVec2 &p) { return dist2_point_segment(p, a, b) <= reach2; };
+
+    if (count == 1)
+        return inside(pts[0]);
+
+    bool touched = false;
+    std::vector<ImVec2> piece;
+    auto flush = [&]
+    {
+        if (piece.size() >= 2)
+        {
+            auto s = std::make_unique<Stroke>();
+            s->color = stroke.color;
+            s->thickness = stroke.thickness;
+            s->points.assign(piece.begin(), piece.end());
+            s->update_bounds();
+            s->pack();
+            pieces.push_back(std::move(s));
+        }
+        piece.clear();
+    };
+
+    bool prev_in = inside(pts[0]);
+    touched = prev_in;
+    if (!prev_in)
+        piece.push_back(pts[0]);
+
+    // Шаг выборки вдоль отрезка: меньше диаметра ластика, чтобы не проскочить его
+    const float step = std::max(reach * 0.5f, 1e-3f);
+    for (size_t i = 1; i < count; ++i)
+    {
+        const ImVec2 p = pts[i - 1], q = pts[i];
+        // Отрезок далеко от ластика целиком — без выборки
+        if (!prev_in && dist2_segment_segment(p, q, a, b) > reach2)
+        {
+            piece.push_back(q);
+            continue;
+        }
+        ImVec2 d = q - p;
+        int n = std::max(1, static_cast<int>(std::ceil(std::sqrt(dot(d, d)) / step)));
+        float prev_t = 0.0f;
+        for (int k = 1; k <= n; ++k)
+        {
+            float t = static_cast<float>(k) / n;
+            bool in = inside(p + d * t);
+            if (in != prev_in)
+            {
+                // Граница следа ластика уточняется делением пополам
+                float lo = prev_t, hi = t;
+                for (int it = 0; it < 10; ++it)
+                {
+                    float mid = (lo + hi) * 0.5f;
+                    (inside(p + d * mid) == prev_in ? lo : hi) = mid;
+                }
+                ImVec2 boundary = p + d * (prev_in ? hi : lo);
+                if (in)
+                {
+                    piece.push_back(boundary);
+                    flush();
+                    touched = true;
+                }
+                else
+                {
+                    piece.push_back(boundary);
+                }
+            }
+            prev_in = in;
+            prev_t = t;
+        }
+        if (!prev_in)
+            piece.push_back(q);
+    }
+
+    if (!touched)
+        return false;
+    flush();
+    return true;
+}
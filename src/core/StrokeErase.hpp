@@ -0,0 +1,11 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "core/CanvasElement.hpp"
+
+// Вырезает из штриха всё, что попадает под ластик — капсулу радиуса radius
+// вокруг отрезка a-b (координаты холста); учитывается толщина штриха.
+// Возвращает false, если штрих не задет. Иначе pieces — уцелевшие куски
+// (упакованные, с новыми id), пусто — штрих стёрт целиком
+bool CutStroke(const Stroke &stroke, const ImVec2 &a, const ImVec2 &b, float radius,
+               std::vector<std::unique_ptr<Stroke>> &pieces);
@@ -0,0 +1,109 @@
+#include "core/StrokeGeometry.hpp"
+#include "core/HitTest.hpp"
+#include "core/PointCodec.hpp"
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <vector>
+
+bool StrokeHitCache::near(const ImVec2 &p, float radius) const
+{
+    const size_t count = points.size();
+    for (size_t c = 0; c < chunk_bounds.size(); ++c)
+    {
+        const ImVec4 &b = chunk_bounds[c];
+        if (p.x < b.x - radius || p.x > b.z + radius || p.y < b.y - radius || p.y > b.w + radius)
+            continue;
+        // Порция c: точки [c*kChunk, c*kChunk + kChunk], общая точка на стыке
+        const size_t start = c * kChunk;
+        const size_t n = std::min(kChunk + 1, count - start);
+        if (PolylineNear(points.data() + start, n, p, radius))
+            return true;
+    }
+    return false;
+}
+
+size_t StrokeHitCache::memory_bytes() const
+{
+    return sizeof(StrokeHitCache) + points.capacity() * sizeof(ImVec2) + chunk_bounds.capacity() * sizeof(ImVec4);
+}
+
+std::shared_ptr<const StrokeGeometry> StrokeGeometry::Encode(const ImVec2 *pts, size_t count, const ImVec2 &min,
+                                                             const ImVec2 &max)
+{
+    auto g = std::make_shared<StrokeGeometry>();
+    g->min = min;
+    g->max = max;
+    g->scale = QuantizeScale(min, max);
+    g->data.resize(count * 2);
+    EncodePoints(pts, count, min, g->scale, g->data.data());
+    return g;
+}
+
+std::shared_ptr<const StrokeGeometry> StrokeGeometry::FromPacked(PackedPoints &&packed, float packed_scale,
+                                                                 const ImVec2 &min, const ImVec2 &max)
+{
+    auto g = std::make_shared<StrokeGeometry>();
+    g->min = min;
+    g->max = max;
+    g->scale = packed_scale;
+    g->data = std::move(packed);
+    return g;
+}
+
+StrokeRenderCache &StrokeGeometry::render_cache(std::unique_ptr<StrokeRenderCache> (*make)()) const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (!render_slot)
+    {
+        render_slot = make();
+        render_cache_ptr.store(render_slot.get(), std::memory_order_release);
+    }
+    return *render_slot;
+}
+
+std::shared_ptr<const StrokeHitCache> StrokeGeometry::hit_cache() const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cached_hits)
+        return cached_hits;
+
+    auto hits = std::make_shared<StrokeHitCache>();
+    const size_t count = point_count();
+    if (count == 0)
+    {
+        // Пустая геометрия: без порций, near() всегда false
+        cached_hits = std::move(hits);
+        return cached_hits;
+    }
+    hits->points.resize(count);
+    DecodePoints(data.data(), count, min, scale, hits->points.data());
+    const size_t segments = count > 1 ? count - 1 : 1;
+    for (size_t start = 0; start < segments; start += StrokeHitCache::kChunk)
+    {
+        const size_t end = std::min(start + StrokeHitCache::kChunk, count - 1);
+        ImVec4 b(hits->points[start].x, hits->points[start].y, hits->points[start].x, hits->points[start].y);
+        for (size_t i = start + 1; i <= end; ++i)
+        {
+            const ImVec2 &p = hits->points[i];
+            b.x = std::min(b.x, p.x);
+            b.y = std::min(b.y, p.y);
+            b.z = std::max(b.z, p.x);
+            b.w = std::max(b.w, p.y);
+        }
+        hits->chunk_bounds.push_back(b);
+    }
+    cached_hits = std::move(hits);
+    return cached_hits;
+}
+
+size_t StrokeGeometry::memory_bytes() const
+{
+    size_t bytes = sizeof(StrokeGeometry) + data.capacity() * sizeof(uint16_t);
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (render_slot)
+        bytes += render_slot->memory_bytes();
+    if (cached_hits)
+        bytes += cached_hits->memory_bytes();
+    return bytes;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <imgui.h>
+#include "util/MemoryStats.hpp"
+
+using PackedPoints = TrackedVector<uint16_t, MemCategory::Geometry>;
+
+// Данные слоя отрисовки, привязанные к штриху или его геометрии (сетки,
+// см. render/StrokeRenderer.hpp). core знает о них только занимаемую память
+struct StrokeRenderCache
+{
+    virtual ~StrokeRenderCache() = default;
+    virtual size_t memory_bytes() const = 0;
+};
+
+// Владеющий указатель на кэш, который копии не наследуют: клон штриха,
+// который рисуется сейчас (история, снимки), при нужде строит свой
+struct WetStrokeHandle
+{
+    std::unique_ptr<StrokeRenderCache> mesh;
+
+    WetStrokeHandle() = default;
+    WetStrokeHandle(const WetStrokeHandle &) {}
+    WetStrokeHandle(WetStrokeHandle &&) = default;
+    WetStrokeHandle &operator=(const WetStrokeHandle &)
+    {
+        mesh.reset();
+        return *this;
+    }
+    WetStrokeHandle &operator=(WetStrokeHandle &&) = default;
+};
+
+// Точки геометрии, разложенные для проверки попадания: полная точность и
+// bounding box каждой порции из kChunk отрезков
+struct StrokeHitCache
+{
+    static constexpr size_t kChunk = 64;
+    TrackedVector<ImVec2, MemCategory::Caches> points;
+    TrackedVector<ImVec4, MemCategory::Caches> chunk_bounds; // (min.x, min.y, max.x, max.y)
+
+    bool near(const ImVec2 &p, float radius) const;
+    size_t memory_bytes() const;
+};
+
+// Неизменяемая упакованная геометрия завершённого штриха. Разделяется
+// экземплярами (копирование, вставка, дублирование) и копиями в истории
+// через shared_ptr; цвет, толщина и трансформация хранятся в Stroke.
+// Координаты локальные: p = bounds_min + q * packed_scale
+class StrokeGeometry
+{
+public:
+    static std::shared_ptr<const StrokeGeometry> Encode(const ImVec2 *pts, size_t count, const ImVec2 &min,
+                                                        const ImVec2 &max);
+    // Уже упакованные данные (загрузка, репликация)
+    static std::shared_ptr<const StrokeGeometry> FromPacked(PackedPoints &&packed, float packed_scale,
+                                                            const ImVec2 &min, const ImVec2 &max);
+
+    const PackedPoints &packed() const { return data; }
+    float packed_scale() const { return scale; }
+    const ImVec2 &bounds_min() const { return min; }
+    const ImVec2 &bounds_max() const { return max; }
+    size_t point_count() const { return data.size() / 2; }
+
+    // Геометрия создана копированием: рисовать и проверять попадание через
+    // общие кэши. Обычные штрихи кэшей не заводят — им они не окупаются
+    bool instanced() const { return shared.load(std::memory_order_relaxed); }
+    void mark_instanced() const { shared.store(true, std::memory_order_relaxed); }
+
+    // Кэш слоя отрисовки, общий для всех экземпляров (сетка штриха).
+    // Создаётся первым вызовом render_cache(make) и живёт вместе с
+    // геометрией; find_render_cache() не создаёт и не блокирует
+    StrokeRenderCache *find_render_cache() const { return render_cache_ptr.load(std::memory_order_acquire); }
+    StrokeRenderCache &render_cache(std::unique_ptr<StrokeRenderCache> (*make)()) const;
+    std::shared_ptr<const StrokeHitCache> hit_cache() const;
+
+    // Упакованные точки и построенные кэши
+    size_t memory_bytes() const;
+
+private:
+    PackedPoints data;
+    float scale = 1.0f;
+    ImVec2 min = ImVec2(0.0f, 0.0f);
+    ImVec2 max = ImVec2(0.0f, 0.0f);
+
+    mutable std::atomic<bool> shared{false};
+    mutable std::mutex cache_mutex;
+    mutable std::unique_ptr<StrokeRenderCache> render_slot;
+    mutable std::atomic<StrokeRenderCache *> render_cache_ptr{nullptr}; // render_slot для чтения без блокировки
+    mutable std::shared_ptr<const StrokeHitCache> cached_hits;
+};
@@ -0,0 +1,382 @@
+#include "core/TextIndex.hpp"
+#include "core/CanvasState.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+
+std::string to_lower(std::string_view s)
+{
+    std::string out(s);
+    for (char &c : out)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+uint32_t trigram_key(const char *p)
+{
+    return (uint32_t(uint8_t(p[0])) << 16) | (uint32_t(uint8_t(p[1])) << 8) | uint8_t(p[2]);
+}
+
+// Уникальные триграммы строки
+std::vector<uint32_t> trigrams_of(std::string_view s)
+{
+    std::vector<uint32_t> keys;
+    if (s.size() < 3)
+        return keys;
+    keys.reserve(s.size() - 2);
+    for (size_t i = 0; i + 3 <= s.size(); ++i)
+        keys.push_back(trigram_key(s.data() + i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+bool is_word_char(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || (static_cast<unsigned char>(c) & 0x80);
+}
+
+// Уникальные слова строки
+std::vector<std::string_view> words_of(std::string_view s)
+{
+    std::vector<std::string_view> out;
+    size_t i = 0;
+    while (i < s.size())
+    {
+        while (i < s.size() && !is_word_char(s[i]))
+            ++i;
+        size_t start = i;
+        while (i < s.size() && is_word_char(s[i]))
+            ++i;
+        if (i > start)
+            out.push_back(s.substr(start, i - start));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+void sorted_insert(std::vector<uint32_t> &list, uint32_t slot)
+{
+    if (list.empty() || list.back() < slot)
+    {
+        list.push_back(slot);
+        return;
+    }
+    auto it = std::lower_bound(list.begin(), list.end(), slot);
+    if (it == list.end() || *it != slot)
+        list.insert(it, slot);
+}
+
+void sorted_erase(std::vector<uint32_t> &list, uint32_t slot)
+{
+    auto it = std::lower_bound(list.begin(), list.end(), slot);
+    if (it != list.end() && *it == slot)
+        list.erase(it);
+}
+
+// Индекс элемента с данным id; поиск расходится от hint, так что небольшой
+// сдвиг находится быстро. elements.size(), если элемента нет
+size_t find_near(const std::vector<std::unique_ptr<CanvasElement>> &elements, size_t hint, uint64_t id)
+{
+    const size_t n = elements.size();
+    if (n == 0)
+        return 0;
+    hint = std::min(hint, n - 1);
+    for (size_t d = 0; d <= hint || hint + d < n; ++d)
+    {
+        if (d <= hint && elements[hint - d]->id == id)
+            return hint - d;
+        if (hint + d < n && elements[hint + d]->id == id)
+            return hint + d;
+    }
+    return n;
+}
+
+} // namespace
+
+void TextIndex::rebuild(const CanvasState &canvas)
+{
+    generation++;
+    docs.clear();
+    free_slots.clear();
+    id_to_slot.clear();
+    trigrams.clear();
+    words.clear();
+    queue.clear();
+    scan_canvas = &canvas;
+    scan_next = 0;
+}
+
+void TextIndex::enqueue(const FrameChanges &changes)
+{
+    for (uint64_t id : changes.removed)
+        queue.push_back({true, id, ImVec2(), std::string()});
+    for (const auto &[index, el] : changes.added)
+    {
+        if (auto text = dynamic_cast<const TextLabel *>(el))
+            queue.push_back({false, text->id, text->position, text->text});
+    }
+    for (const CanvasElement *el : changes.modified)
+    {
+        if (auto text = dynamic_cast<const TextLabel *>(el))
+            queue.push_back({false, text->id, text->position, text->text});
+    }
+}
+
+bool TextIndex::process(std::chrono::steady_clock::time_point deadline)
+{
+    // Часы опрашиваются раз в несколько записей
+    constexpr int kCheckEvery = 32;
+    int n = 0;
+    if (scan_canvas && scan_next > 0)
+    {
+        // Правки между кадрами сдвигают элементы, но порядок уцелевших не
+        // меняется, а новые приходят через очередь. Обход продолжается за
+        // последним пройденным элементом; если его удалили — с начала,
+        // уже проиндексированные метки пропускаются по id
+        const auto &elements = scan_canvas->elements;
+        size_t at = find_near(elements, scan_next - 1, scan_anchor);
+        scan_next = at < elements.size() ? at + 1 : 0;
+    }
+    // Метки из обхода берутся прямо из документа, поэтому их текст не старше
+    // записей очереди; очередь применяется после и оставляет последнюю правку
+    while (scan_canvas)
+    {
+        const auto &elements = scan_canvas->elements;
+        if (scan_next >= elements.size())
+        {
+            scan_canvas = nullptr;
+            break;
+        }
+        scan_anchor = elements[scan_next]->id;
+        auto text = dynamic_cast<const TextLabel *>(elements[scan_next++].get());
+        if (text && id_to_slot.find(text->id) == id_to_slot.end())
+            insert(text->id, text->position, text->text);
+        if (++n % kCheckEvery == 0 && std::chrono::steady_clock::now() >= deadline)
+            return false;
+    }
+    while (!queue.empty())
+    {
+        PendingOp &op = queue.front();
+        if (op.remove)
+            erase(op.id);
+        else
+            insert(op.id, op.position, op.text);
+        queue.pop_front();
+        if (++n % kCheckEvery == 0 && std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+    return queue.empty();
+}
+
+void TextIndex::apply(const FrameChanges &changes)
+{
+    enqueue(changes);
+    process(std::chrono::steady_clock::time_point::max());
+}
+
+void TextIndex::insert(uint64_t id, const ImVec2 &position, const std::string &text)
+{
+    auto existing = id_to_slot.find(id);
+    if (existing != id_to_slot.end())
+    {
+        // Та же строка — обновляем только позицию
+        Doc &doc = docs[existing->second];
+        if (doc.text == text)
+        {
+            doc.position = position;
+            generation++;
+            return;
+        }
+        erase(id);
+    }
+
+    uint32_t slot;
+    if (!free_slots.empty())
+    {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(docs.size());
+        docs.emplace_back();
+    }
+    Doc &doc = docs[slot];
+    doc.id = id;
+    doc.alive = true;
+    doc.position = position;
+    doc.text = text;
+    doc.lower = to_lower(text);
+    id_to_slot[id] = slot;
+    generation++;
+
+    for (uint32_t key : trigrams_of(doc.lower))
+        sorted_insert(trigrams[key], slot);
+    for (std::string_view w : words_of(doc.lower))
+    {
+        auto it = words.find(w);
+        if (it == words.end())
+            it = words.emplace(std::string(w), std::vector<uint32_t>()).first;
+        sorted_insert(it->second, slot);
+    }
+}
+
+void TextIndex::erase(uint64_t id)
+{
+    auto found = id_to_slot.find(id);
+    if (found == id_to_slot.end())
+        return;
+    uint32_t slot = found->second;
+    Doc &doc = docs[slot];
+
+    for (uint32_t key : trigrams_of(doc.lower))
+    {
+        auto it = trigrams.find(key);
+        if (it == trigrams.end())
+            continue;
+        sorted_erase(it->second, slot);
+        if (it->second.empty())
+            trigrams.erase(it);
+    }
+    for (std::string_view w : words_of(doc.lower))
+    {
+        auto it = words.find(w);
+        if (it == words.end())
+            continue;
+        sorted_erase(it->second, slot);
+        if (it->second.empty())
+            words.erase(it);
+    }
+
+    doc = Doc();
+    free_slots.push_back(slot);
+    generation++;
+    id_to_slot.erase(found);
+}
+
+void TextIndex::scan(std::string_view query, size_t max_results, std::vector<Hit> &out, size_t &total) const
+{
+    // Короткие подстроки: у 1-2 символов нет триграмм, проходим по строкам
+    for (const Doc &doc : docs)
+    {
+        if (doc.alive && doc.lower.find(query) != std::string::npos)
+        {
+            if (out.size() < max_results)
+                out.push_back({doc.id, doc.position, &doc.text});
+            ++total;
+        }
+    }
+}
+
+std::vector<TextIndex::Hit> TextIndex::search(std::string_view raw_query, Mode mode, size_t max_results, size_t *total_out) const
+{
+    std::vector<Hit> out;
+    size_t total = 0;
+    const std::string query = to_lower(raw_query);
+    if (query.empty())
+    {
+        if (total_out)
+            *total_out = 0;
+        return out;
+    }
+
+    if (mode == Mode::WordPrefix)
+    {
+        // Каждое слово запроса должно быть префиксом какого-то слова метки.
+        // Слова с общим префиксом идут подряд в упорядоченном словаре
+        std::vector<uint32_t> result, slots, next;
+        bool first = true;
+        for (std::string_view prefix : words_of(query))
+        {
+            slots.clear();
+            for (auto it = words.lower_bound(prefix);
+                 it != words.end() && std::string_view(it->first).substr(0, prefix.size()) == prefix; ++it)
+                slots.insert(slots.end(), it->second.begin(), it->second.end());
+            std::sort(slots.begin(), slots.end());
+            slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+            if (first)
+                result.swap(slots);
+            else
+            {
+                next.clear();
+                std::set_intersection(result.begin(), result.end(), slots.begin(), slots.end(),
+                                      std::back_inserter(next));
+                result.swap(next);
+            }
+            first = false;
+            if (result.empty())
+                break;
+        }
+        total = result.size();
+        for (size_t i = 0; i < result.size() && out.size() < max_results; ++i)
+        {
+            const Doc &doc = docs[result[i]];
+            out.push_back({doc.id, doc.position, &doc.text});
+        }
+    }
+    else if (query.size() < 3)
+    {
+        scan(query, max_results, out, total);
+    }
+    else
+    {
+        // Пересекаем списки триграмм начиная с самого короткого
+        std::vector<const std::vector<uint32_t> *> lists;
+        for (uint32_t key : trigrams_of(query))
+        {
+            auto it = trigrams.find(key);
+            if (it == trigrams.end())
+            {
+                lists.clear();
+                break;
+            }
+            lists.push_back(&it->second);
+        }
+        if (!lists.empty())
+        {
+            std::sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+            std::vector<uint32_t> candidates = *lists[0];
+            std::vector<uint32_t> next;
+            for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+            {
+                next.clear();
+                std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(),
+                                      std::back_inserter(next));
+                candidates.swap(next);
+            }
+            // Триграммы не гарантируют порядок — проверяем подстроку
+            for (uint32_t slot : candidates)
+            {
+                const Doc &doc = docs[slot];
+                if (doc.lower.find(query) == std::string::npos)
+                    continue;
+                if (out.size() < max_results)
+                    out.push_back({doc.id, doc.position, &doc.text});
+                ++total;
+            }
+        }
+    }
+
+    if (total_out)
+        *total_out = total;
+    return out;
+}
+
+size_t TextIndex::memory_bytes() const
+{
+    size_t bytes = docs.capacity() * sizeof(Doc) + free_slots.capacity() * sizeof(uint32_t);
+    for (const Doc &doc : docs)
+        bytes += doc.text.capacity() + doc.lower.capacity();
+    for (const PendingOp &op : queue)
+        bytes += sizeof(PendingOp) + op.text.capacity();
+    bytes += id_to_slot.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void *));
+    for (const auto &[key, list] : trigrams)
+        bytes += sizeof(key) + list.capacity() * sizeof(uint32_t) + 2 * sizeof(void *);
+    for (const auto &[word, list] : words)
+        bytes += word.capacity() + list.capacity() * sizeof(uint32_t) + 4 * sizeof(void *);
+    return bytes;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <imgui.h>
+#include "core/ChangeLog.hpp"
+
+struct CanvasState;
+
+// Инвертированный индекс по тексту всех TextLabel.
+// Подстроки ищутся по триграммам (пересечение списков + проверка кандидатов),
+// префиксы слов — по упорядоченному словарю. Обновляется по журналу изменений
+// кадра, поэтому правки, создание и undo/redo не требуют полного пересчёта.
+// Изменения сначала копируются в очередь и затем применяются порциями
+// (process), так что большой снимок документа не вызывает рывка. Полное
+// построение тоже идёт порциями: process обходит документ с места остановки.
+class TextIndex
+{
+public:
+    enum class Mode
+    {
+        Substring,
+        WordPrefix
+    };
+
+    struct Hit
+    {
+        uint64_t id;
+        ImVec2 position;
+        const std::string *text; // действителен до следующего apply()
+    };
+
+    // Полное построение (например, после загрузки документа): очищает индекс
+    // и начинает обход canvas, который продолжают вызовы process.
+    // canvas должен жить, пока обход не закончен (pending() == false)
+    void rebuild(const CanvasState &canvas);
+    // Ставит изменения кадра в очередь (указатели FrameChanges не сохраняются)
+    void enqueue(const FrameChanges &changes);
+    // Продолжает обход документа и применяет очередь до deadline (минимум
+    // одну запись); true — обход закончен и очередь пуста
+    bool process(std::chrono::steady_clock::time_point deadline);
+    // enqueue + полная обработка очереди
+    void apply(const FrameChanges &changes);
+    bool pending() const { return scan_canvas || !queue.empty(); }
+
+    // Не более max_results совпадений; total — сколько совпадений найдено всего
+    std::vector<Hit> search(std::string_view query, Mode mode, size_t max_results, size_t *total = nullptr) const;
+
+    size_t size() const { return id_to_slot.size(); }
+    // Меняется при каждом изменении содержимого индекса
+    uint64_t version() const { return generation; }
+    size_t memory_bytes() const;
+
+private:
+    struct Doc
+    {
+        uint64_t id = 0;
+        bool alive = false;
+        ImVec2 position;
+        std::string text;  // исходный текст (для показа)
+        std::string lower; // нормализованный (для поиска)
+    };
+
+    struct PendingOp
+    {
+        bool remove;
+        uint64_t id;
+        ImVec2 position;
+        std::string text;
+    };
+
+    void insert(uint64_t id, const ImVec2 &position, const std::string &text);
+    void erase(uint64_t id);
+    void scan(std::string_view query, size_t max_results, std::vector<Hit> &out, size_t &total) const;
+
+    uint64_t generation = 0;
+    const CanvasState *scan_canvas = nullptr; // обход после rebuild, nullptr — закончен
+    size_t scan_next = 0;
+    uint64_t scan_anchor = 0; // id элемента scan_next - 1
+    std::deque<PendingOp> queue;
+    std::vector<Doc> docs;
+    std::vector<uint32_t> free_slots;
+    std::unordered_map<uint64_t, uint32_t> id_to_slot;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams; // триграмма -> отсортированные слоты
+    std::map<std::string, std::vector<uint32_t>, std::less<>> words; // слово -> слоты
+};
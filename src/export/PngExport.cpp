@@ -0,0 +1,112 @@
+#include "export/PngExport.hpp"
+#include "export/PngWriter.hpp"
+#include "render/SoftwareRasterizer.hpp"
+#include "util/ThreadPool.hpp"
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Largest side we agree to produce; PNG allows more but nothing opens it.
+static constexpr int kMaxExportSide = 65535;
+
+bool ExportCanvasPng(const CanvasState& canvas, const std::string& path,
+                     const PngExportOptions& options, PngExportStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+
+    const RasterFont font = CaptureRasterFont();
+    std::vector<RasterItem> items = CollectRasterItems(canvas, font);
+
+    ImVec2 world_min, world_max;
+    if (options.use_region) {
+        world_min = ImVec2(std::min(options.region_min.x, options.region_max.x), std::min(options.region_min.y, options.region_max.y));
+        world_max = ImVec2(std::max(options.region_min.x, options.region_max.x), std::max(options.region_min.y, options.region_max.y));
+    } else {
+        if (items.empty()) {
+            std::cerr << "PNG export: canvas is empty\n";
+            return false;
+        }
+        world_min = items[0].min;
+        world_max = items[0].max;
+        for (const RasterItem& item : items) {
+            world_min.x = std::min(world_min.x, item.min.x);
+            world_min.y = std::min(world_min.y, item.min.y);
+            world_max.x = std::max(world_max.x, item.max.x);
+            world_max.y = std::max(world_max.y, item.max.y);
+        }
+        world_min = world_min - ImVec2(options.margin, options.margin);
+        world_max = world_max + ImVec2(options.margin, options.margin);
+    }
+
+    RasterView view;
+    view.world_min = world_min;
+    view.scale = options.dpi / 96.0f;
+    const size_t images = LoadRasterImages(items, view.scale);
+
+    const int width = static_cast<int>(std::ceil((world_max.x - world_min.x) * view.scale));
+    const int height = static_cast<int>(std::ceil((world_max.y - world_min.y) * view.scale));
+    if (width <= 0 || height <= 0 || width > kMaxExportSide || height > kMaxExportSide) {
+        std::cerr << "PNG export: invalid image size " << width << "x" << height << "\n";
+        return false;
+    }
+
+    PngWriter writer;
+    if (!writer.open(path, width, height)) {
+        std::cerr << "PNG export: cannot open " << path << "\n";
+        return false;
+    }
+
+    const int tile = std::max(16, options.tile_size);
+    const int tiles_x = (width + tile - 1) / tile;
+    const int bands = (height + tile - 1) / tile;
+    const size_t stride = size_t(width) * 4;
+
+    // Two bands: workers rasterize band N+1 while this thread compresses band N.
+    std::vector<uint8_t> band_buffers[2];
+    band_buffers[0].resize(stride * tile);
+    band_buffers[1].resize(stride * tile);
+
+    auto render_band = [&](int band, std::vector<uint8_t>& buffer) {
+        const int y0 = band * tile;
+        const int band_h = std::min(tile, height - y0);
+        ThreadPool::shared().parallel_for(static_cast<size_t>(tiles_x), [&](size_t tx) {
+            const int x0 = static_cast<int>(tx) * tile;
+            const int tile_w = std::min(tile, width - x0);
+            RasterizeTile(items, font, view, options.background, x0, y0, tile_w, band_h,
+                          buffer.data() + size_t(x0) * 4, stride);
+        });
+    };
+
+    render_band(0, band_buffers[0]);
+    bool ok = true;
+    for (int band = 0; band < bands && ok; ++band) {
+        std::vector<uint8_t>& current = band_buffers[band & 1];
+        std::thread next;
+        if (band + 1 < bands) {
+            next = std::thread(render_band, band + 1, std::ref(band_buffers[(band + 1) & 1]));
+        }
+        const int band_h = std::min(tile, height - band * tile);
+        ok = writer.write_rows(current.data(), band_h, stride);
+        if (next.joinable()) next.join();
+    }
+    ok = writer.close() && ok;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) {
+        stats->width = width;
+        stats->height = height;
+        stats->tiles = tiles_x * bands;
+        stats->images = images;
+        stats->seconds = seconds;
+        stats->buffer_bytes = band_buffers[0].size() + band_buffers[1].size();
+        stats->file_bytes = writer.bytes_written();
+    }
+    std::cerr << "PNG export: " << path << " " << width << "x" << height << " in "
+              << tiles_x * bands << " tiles, " << images << " images, " << seconds << "s" << (ok ? "" : " (write error)") << "\n";
+    return ok;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <imgui.h>
+#include "core/CanvasState.hpp"
+
+struct PngExportOptions
+{
+    // Export a canvas-space region instead of the document bounds
+    bool use_region = false;
+    ImVec2 region_min = ImVec2(0.0f, 0.0f);
+    ImVec2 region_max = ImVec2(0.0f, 0.0f);
+
+    float dpi = 96.0f;     // 96 dpi = one canvas unit per pixel
+    float margin = 16.0f;  // canvas units added around the document bounds
+    int tile_size = 256;   // tiles are square, one band of tiles is kept in memory
+    ImVec4 background = ImVec4(40 / 255.0f, 40 / 255.0f, 50 / 255.0f, 1.0f);
+};
+
+struct PngExportStats
+{
+    int width = 0;
+    int height = 0;
+    int tiles = 0;
+    size_t images = 0; // image elements, decoded from their files
+    double seconds = 0.0;
+    size_t buffer_bytes = 0; // peak pixel memory used during export
+    size_t file_bytes = 0;
+};
+
+// Rasterizes the canvas on the CPU (all cores, tile by tile) and streams the
+// result into a PNG file. Must be called from the UI thread because it reads
+// the ImGui font atlas; no GL context is required.
+bool ExportCanvasPng(const CanvasState &canvas, const std::string &path,
+                     const PngExportOptions &options, PngExportStats *stats = nullptr);
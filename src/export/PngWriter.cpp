@@ -0,0 +1,307 @@
+#include "export/PngWriter.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kWindowSize = 32768;
+constexpr int kMinMatch = 3;
+constexpr int kMaxMatch = 258;
+constexpr int kHashBits = 15;
+constexpr size_t kIdatChunk = 1 << 16;
+
+// Length codes 257..285 (RFC 1951, 3.2.5)
+constexpr int kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr int kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr int kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                               193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                               6145, 8193, 12289, 16385, 24577};
+constexpr int kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+uint32_t reverse_bits(uint32_t code, int length) {
+    uint32_t r = 0;
+    for (int i = 0; i < length; ++i) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+// Lookup tables for the fixed Huffman code, bit-reversed so they can be
+// written LSB-first.
+struct FixedTables {
+    std::array<uint16_t, 288> lit_code{};
+    std::array<uint8_t, 288> lit_len{};
+    std::array<uint8_t, kMaxMatch + 1> length_code{}; // length -> index into kLengthBase
+    std::array<uint8_t, kWindowSize + 1> dist_code{}; // distance -> index into kDistBase
+
+    FixedTables() {
+        for (int v = 0; v < 288; ++v) {
+            uint32_t code;
+            int len;
+            if (v < 144) { code = 0x30 + v; len = 8; }
+            else if (v < 256) { code = 0x190 + (v - 144); len = 9; }
+            else if (v < 280) { code = v - 256; len = 7; }
+            else { code = 0xC0 + (v - 280); len = 8; }
+            lit_code[v] = static_cast<uint16_t>(reverse_bits(code, len));
+            lit_len[v] = static_cast<uint8_t>(len);
+        }
+        for (int i = 0, l = kMinMatch; l <= kMaxMatch; ++l) {
+            while (i + 1 < 29 && kLengthBase[i + 1] <= l) ++i;
+            length_code[l] = static_cast<uint8_t>(i);
+        }
+        for (int i = 0, d = 1; d <= static_cast<int>(kWindowSize); ++d) {
+            while (i + 1 < 30 && kDistBase[i + 1] <= d) ++i;
+            dist_code[d] = static_cast<uint8_t>(i);
+        }
+    }
+};
+
+const FixedTables& tables() {
+    static const FixedTables t;
+    return t;
+}
+
+uint32_t hash3(const uint8_t* p) {
+    uint32_t v = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+void put_be32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24);
+    p[1] = uint8_t(v >> 16);
+    p[2] = uint8_t(v >> 8);
+    p[3] = uint8_t(v);
+}
+
+} // namespace
+
+// ---------- Deflater ----------
+
+Deflater::Deflater() : head(size_t(1) << kHashBits, -1) {
+    window.reserve(kWindowSize * 3);
+}
+
+void Deflater::put_bits(uint32_t bits, int count, std::vector<uint8_t>& out) {
+    bit_buffer |= uint64_t(bits) << bit_count;
+    bit_count += count;
+    while (bit_count >= 8) {
+        out.push_back(uint8_t(bit_buffer));
+        bit_buffer >>= 8;
+        bit_count -= 8;
+    }
+}
+
+void Deflater::put_literal(int value, std::vector<uint8_t>& out) {
+    const FixedTables& t = tables();
+    put_bits(t.lit_code[value], t.lit_len[value], out);
+}
+
+void Deflater::put_match(int length, int distance, std::vector<uint8_t>& out) {
+    const FixedTables& t = tables();
+    int li = t.length_code[length];
+    put_literal(257 + li, out);
+    if (kLengthExtra[li]) put_bits(length - kLengthBase[li], kLengthExtra[li], out);
+    int di = t.dist_code[distance];
+    put_bits(reverse_bits(di, 5), 5, out);
+    if (kDistExtra[di]) put_bits(distance - kDistBase[di], kDistExtra[di], out);
+}
+
+void Deflater::slide() {
+    // Drop everything older than the window, rebasing the hash table.
+    if (pos <= kWindowSize * 2) return;
+    size_t shift = pos - kWindowSize;
+    window.erase(window.begin(), window.begin() + shift);
+    pos -= shift;
+    for (int32_t& h : head) {
+        h = (h >= static_cast<int32_t>(shift)) ? h - static_cast<int32_t>(shift) : -1;
+    }
+}
+
+void Deflater::write(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < size; ++i) {
+        adler_a += data[i];
+        if (adler_a >= 65521) adler_a -= 65521;
+        adler_b += adler_a;
+        if (adler_b >= 65521) adler_b -= 65521;
+    }
+    window.insert(window.end(), data, data + size);
+    compress(false, out);
+}
+
+void Deflater::finish(std::vector<uint8_t>& out) {
+    compress(true, out);
+    // Closing empty block with BFINAL set
+    put_bits(1, 1, out);
+    put_bits(1, 2, out);
+    put_literal(256, out);
+    if (bit_count > 0) put_bits(0, 8 - bit_count, out);
+    uint8_t trailer[4];
+    put_be32(trailer, (adler_b << 16) | adler_a);
+    out.insert(out.end(), trailer, trailer + 4);
+}
+
+void Deflater::compress(bool final, std::vector<uint8_t>& out) {
+    if (!header_written) {
+        out.push_back(0x78); // deflate, 32K window
+        out.push_back(0x01);
+        header_written = true;
+    }
+
+    // Without the final flag keep a full match of lookahead pending.
+    size_t end = window.size();
+    size_t limit = final ? end : (end > size_t(kMaxMatch) ? end - kMaxMatch : 0);
+    if (pos >= limit) return;
+
+    put_bits(0, 1, out); // BFINAL = 0
+    put_bits(1, 2, out); // BTYPE = fixed Huffman
+
+    const uint8_t* buf = window.data();
+    while (pos < limit) {
+        int best_len = 0;
+        int best_dist = 0;
+        if (pos + kMinMatch <= end) {
+            uint32_t h = hash3(buf + pos);
+            int32_t candidate = head[h];
+            head[h] = static_cast<int32_t>(pos);
+            if (candidate >= 0 && pos - candidate <= kWindowSize) {
+                size_t max_len = std::min<size_t>(kMaxMatch, end - pos);
+                const uint8_t* a = buf + candidate;
+                const uint8_t* b = buf + pos;
+                size_t len = 0;
+                while (len < max_len && a[len] == b[len]) ++len;
+                if (len >= size_t(kMinMatch)) {
+                    best_len = static_cast<int>(len);
+                    best_dist = static_cast<int>(pos - candidate);
+                }
+            }
+        }
+
+        if (best_len > 0) {
+            put_match(best_len, best_dist, out);
+            // Long runs (flat background) are not worth hashing byte by byte.
+            if (best_len < 32) {
+                for (int i = 1; i < best_len && pos + i + kMinMatch <= end; ++i) {
+                    head[hash3(buf + pos + i)] = static_cast<int32_t>(pos + i);
+                }
+            }
+            pos += best_len;
+        } else {
+            put_literal(buf[pos], out);
+            ++pos;
+        }
+    }
+    put_literal(256, out); // end of block
+    slide();
+}
+
+// ---------- PngWriter ----------
+
+PngWriter::~PngWriter() {
+    if (file) std::fclose(file);
+}
+
+bool PngWriter::open(const std::string& path, int w, int h) {
+    if (w <= 0 || h <= 0) return false;
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    width = w;
+    height = h;
+    rows_written = 0;
+    file_size = 0;
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file_size += std::fwrite(signature, 1, sizeof(signature), file);
+
+    uint8_t ihdr[13];
+    put_be32(ihdr, uint32_t(width));
+    put_be32(ihdr + 4, uint32_t(height));
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = 6;  // RGBA
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // adaptive filtering
+    ihdr[12] = 0; // no interlace
+    write_chunk("IHDR", ihdr, sizeof(ihdr));
+
+    scanline.resize(size_t(width) * 4 + 1);
+    compressed.clear();
+    compressed.reserve(kIdatChunk * 2);
+    return !std::ferror(file);
+}
+
+bool PngWriter::write_rows(const uint8_t* rgba, int rows, size_t stride) {
+    if (!file) return false;
+    rows = std::min(rows, height - rows_written);
+    const size_t row_bytes = size_t(width) * 4;
+    for (int y = 0; y < rows; ++y) {
+        // Sub filter: flat areas become zeros and compress into long runs
+        const uint8_t* src = rgba + y * stride;
+        uint8_t* dst = scanline.data();
+        dst[0] = 1;
+        std::memcpy(dst + 1, src, 4);
+        for (size_t i = 4; i < row_bytes; ++i) {
+            dst[1 + i] = uint8_t(src[i] - src[i - 4]);
+        }
+        deflater.write(scanline.data(), scanline.size(), compressed);
+        flush_idat(false);
+    }
+    rows_written += rows;
+    return !std::ferror(file);
+}
+
+bool PngWriter::close() {
+    if (!file) return false;
+    // Pad missing rows so the file stays valid even after an aborted export
+    std::vector<uint8_t> empty(size_t(width) * 4, 0);
+    while (rows_written < height) write_rows(empty.data(), 1, empty.size());
+
+    deflater.finish(compressed);
+    flush_idat(true);
+    write_chunk("IEND", nullptr, 0);
+    bool ok = !std::ferror(file);
+    ok = (std::fclose(file) == 0) && ok;
+    file = nullptr;
+    return ok;
+}
+
+void PngWriter::write_chunk(const char* type, const uint8_t* data, size_t size) {
+    uint8_t header[8];
+    put_be32(header, uint32_t(size));
+    std::memcpy(header + 4, type, 4);
+    uint32_t crc = crc32_update(0xFFFFFFFFu, header + 4, 4);
+    if (size) crc = crc32_update(crc, data, size);
+    uint8_t footer[4];
+    put_be32(footer, crc ^ 0xFFFFFFFFu);
+
+    file_size += std::fwrite(header, 1, 8, file);
+    if (size) file_size += std::fwrite(data, 1, size, file);
+    file_size += std::fwrite(footer, 1, 4, file);
+}
+
+void PngWriter::flush_idat(bool all) {
+    size_t offset = 0;
+    while (compressed.size() - offset >= kIdatChunk || (all && offset < compressed.size())) {
+        size_t n = std::min(kIdatChunk, compressed.size() - offset);
+        write_chunk("IDAT", compressed.data() + offset, n);
+        offset += n;
+    }
+    compressed.erase(compressed.begin(), compressed.begin() + offset);
+}
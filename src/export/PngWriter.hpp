@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streaming zlib compressor: greedy LZ77 with fixed Huffman codes.
+// Keeps only the 32 KiB window plus the pending input, so memory stays
+// constant no matter how much data passes through it.
+class Deflater {
+public:
+    Deflater();
+
+    // Compresses data and appends the produced bytes to out.
+    void write(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+    // Flushes the remaining input, terminates the stream and appends the adler32 trailer.
+    void finish(std::vector<uint8_t>& out);
+
+private:
+    void compress(bool final, std::vector<uint8_t>& out);
+    void put_bits(uint32_t bits, int count, std::vector<uint8_t>& out);
+    void put_literal(int value, std::vector<uint8_t>& out);
+    void put_match(int length, int distance, std::vector<uint8_t>& out);
+    void slide();
+
+    std::vector<uint8_t> window; // history (up to 32 KiB) + pending input
+    size_t pos = 0;              // first byte of window that is not yet encoded
+    std::vector<int32_t> head;   // hash of 3 bytes -> last position in window
+    uint64_t bit_buffer = 0;
+    int bit_count = 0;
+    uint32_t adler_a = 1, adler_b = 0;
+    bool header_written = false;
+};
+
+// Writes an RGBA8 PNG row by row. Only one row of filter state is kept in
+// memory; compressed data is emitted as IDAT chunks as soon as it is ready.
+class PngWriter {
+public:
+    ~PngWriter();
+
+    bool open(const std::string& path, int width, int height);
+    // rows are tightly packed RGBA8 scanlines, stride in bytes
+    bool write_rows(const uint8_t* rgba, int rows, size_t stride);
+    bool close();
+
+    size_t bytes_written() const { return file_size; }
+
+private:
+    void write_chunk(const char* type, const uint8_t* data, size_t size);
+    void flush_idat(bool all);
+
+    FILE* file = nullptr;
+    int width = 0;
+    int height = 0;
+    int rows_written = 0;
+    size_t file_size = 0;
+    Deflater deflater;
+    std::vector<uint8_t> scanline;   // filter byte + filtered row
+    std::vector<uint8_t> compressed; // pending IDAT payload
+};
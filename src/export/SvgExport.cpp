@@ -0,0 +1,544 @@
+#include "export/SvgExport.hpp"
+#include "core/CanvasElement.hpp"
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t kBufferSize = 64 * 1024;
+// Multiple of 3, so consecutive chunks encode to base64 without padding
+constexpr size_t kImageChunk = 48 * 1024;
+// Room kept after "<svg" for the document size, known only after the last page
+constexpr size_t kHeaderRoom = 120;
+constexpr int kMaxPrecision = 4;
+// Page size of an empty page when no region is given
+constexpr float kEmptyPage = 64.0f;
+
+const char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Fixed-point number q / 10^precision without trailing zeros and without
+// the leading zero of a fraction ("-.5"). Returns the length.
+size_t FormatFixed(int64_t q, int precision, char* out) {
+    char* p = out;
+    uint64_t v = q < 0 ? uint64_t(-(q + 1)) + 1 : uint64_t(q);
+    if (q < 0) *p++ = '-';
+    uint64_t scale = 1;
+    for (int i = 0; i < precision; ++i) scale *= 10;
+    uint64_t ip = v / scale, fp = v % scale;
+    if (ip != 0 || fp == 0) {
+        char digits[24];
+        int n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + ip % 10);
+            ip /= 10;
+        } while (ip);
+        while (n) *p++ = digits[--n];
+    }
+    if (fp) {
+        *p++ = '.';
+        int digits = precision;
+        while (fp % 10 == 0) {
+            fp /= 10;
+            digits--;
+        }
+        for (int i = digits - 1; i >= 0; --i) {
+            p[i] = static_cast<char>('0' + fp % 10);
+            fp /= 10;
+        }
+        p += digits;
+    }
+    return static_cast<size_t>(p - out);
+}
+
+// Buffered output: a fixed buffer flushed to the file when full
+class SvgWriter {
+public:
+    ~SvgWriter() {
+        if (file) std::fclose(file);
+    }
+
+    bool open(const std::string& path) {
+        file = std::fopen(path.c_str(), "wb");
+        return file != nullptr;
+    }
+
+    void put(char c) {
+        if (used == kBufferSize) flush();
+        buffer[used++] = c;
+    }
+
+    void put(const char* s, size_t n) {
+        if (n > kBufferSize - used) {
+            flush();
+            if (n > kBufferSize) {
+                failed |= std::fwrite(s, 1, n, file) != n;
+                written += n;
+                return;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+    }
+
+    void put(const char* s) { put(s, std::strlen(s)); }
+
+    // XML character data and attribute values
+    void put_escaped(const char* s, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            switch (s[i]) {
+            case '&': put("&amp;", 5); break;
+            case '<': put("&lt;", 4); break;
+            case '>': put("&gt;", 4); break;
+            case '"': put("&quot;", 6); break;
+            default: put(s[i]);
+            }
+        }
+    }
+
+    uint64_t position() const { return written + used; }
+
+    // Overwrites bytes written earlier (the header), then continues at the end
+    bool patch(uint64_t offset, const std::string& text) {
+        flush();
+        if (std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0) return false;
+        bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        return std::fseek(file, 0, SEEK_END) == 0 && ok;
+    }
+
+    bool close() {
+        flush();
+        bool ok = !failed && std::fclose(file) == 0;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    void flush() {
+        if (used == 0) return;
+        failed |= std::fwrite(buffer, 1, used, file) != used;
+        written += used;
+        used = 0;
+    }
+
+    FILE* file = nullptr;
+    char buffer[kBufferSize];
+    size_t used = 0;
+    uint64_t written = 0;
+    bool failed = false;
+};
+
+// Writes the pages one after another. Scratch buffers are reused between
+// elements and sized by the longest stroke, not by the document.
+class SvgPageWriter {
+public:
+    SvgPageWriter(SvgWriter& out, const SvgExportOptions& options, SvgExportStats& stats)
+        : out(out), options(options), stats(stats), precision(std::clamp(options.precision, 0, kMaxPrecision)) {
+        for (int i = 0; i < precision; ++i) scale *= 10.0f;
+        ImFont* font = ImGui::GetFont();
+        font_size = font->FontSize;
+        ascent = font->Ascent;
+    }
+
+    // Canvas-space rectangle of the page; false for an empty page without a region
+    bool page_bounds(const CanvasState& page, ImVec2& min, ImVec2& max) const {
+        if (options.use_region) {
+            min = ImVec2(std::min(options.region_min.x, options.region_max.x),
+                         std::min(options.region_min.y, options.region_max.y));
+            max = ImVec2(std::max(options.region_min.x, options.region_max.x),
+                         std::max(options.region_min.y, options.region_max.y));
+            return true;
+        }
+        bool any = false;
+        for (const auto& el : page.elements) {
+            ImVec2 emin, emax;
+            if (!el->get_bounds(emin, emax)) continue;
+            if (!any) {
+                min = emin;
+                max = emax;
+                any = true;
+                continue;
+            }
+            min.x = std::min(min.x, emin.x);
+            min.y = std::min(min.y, emin.y);
+            max.x = std::max(max.x, emax.x);
+            max.y = std::max(max.y, emax.y);
+        }
+        if (!any) return false;
+        min = min - ImVec2(options.margin, options.margin);
+        max = max + ImVec2(options.margin, options.margin);
+        return true;
+    }
+
+    // One nested <svg> at vertical offset top: it clips the page and gives
+    // it page-local coordinates. Returns the page size
+    ImVec2 write_page(const CanvasState& page, float top) {
+        ImVec2 min, max;
+        if (!page_bounds(page, min, max)) {
+            min = ImVec2(0.0f, 0.0f);
+            max = ImVec2(kEmptyPage, kEmptyPage);
+        }
+        origin = min;
+        const int64_t w = quantize(max.x - min.x), h = quantize(max.y - min.y);
+        out.put("<svg y=\"");
+        number(quantize(top));
+        out.put("\" width=\"");
+        number(w);
+        out.put("\" height=\"");
+        number(h);
+        out.put("\" viewBox=\"0 0 ");
+        number(w);
+        out.put(' ');
+        number(h);
+        out.put("\">\n");
+        if (options.draw_background) {
+            out.put("<rect width=\"100%\" height=\"100%\" fill=\"");
+            color(options.background);
+            out.put('"');
+            opacity("fill-opacity", options.background.w);
+            out.put("/>\n");
+        }
+
+        for (const auto& el : page.elements) {
+            ImVec2 emin, emax;
+            if (!el->get_bounds(emin, emax)) continue;
+            if (emax.x < min.x || emax.y < min.y || emin.x > max.x || emin.y > max.y) continue;
+            if (auto stroke = dynamic_cast<const Stroke*>(el.get())) {
+                write_stroke(*stroke);
+            } else if (auto text = dynamic_cast<const TextLabel*>(el.get())) {
+                close_group();
+                write_text(*text);
+            } else if (auto image = dynamic_cast<const ImageElement*>(el.get())) {
+                close_group();
+                write_image(*image);
+            } else {
+                continue;
+            }
+            stats.elements++;
+        }
+        close_group();
+        out.put("</svg>\n");
+        stats.pages++;
+        return max - min;
+    }
+
+    size_t scratch_bytes() const {
+        return points.capacity() * sizeof(ImVec2) + keep.capacity() + ranges.capacity() * sizeof(ranges[0]) +
+               chunk.capacity() + encoded.capacity();
+    }
+
+    int64_t quantize(float v) const { return std::llround(double(v) * scale); }
+
+    void number(int64_t q) {
+        char buf[32];
+        out.put(buf, FormatFixed(q, precision, buf));
+    }
+
+private:
+    void coordinate(float v, float o) { number(quantize(v - o)); }
+
+    void color(const ImVec4& c) {
+        auto byte = [](float f) { return static_cast<unsigned>(std::clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        const unsigned r = byte(c.x), g = byte(c.y), b = byte(c.z);
+        static const char hex[] = "0123456789abcdef";
+        out.put('#');
+        if (r % 17 == 0 && g % 17 == 0 && b % 17 == 0) {
+            out.put(hex[r / 17]);
+            out.put(hex[g / 17]);
+            out.put(hex[b / 17]);
+            return;
+        }
+        for (unsigned v : {r, g, b}) {
+            out.put(hex[v >> 4]);
+            out.put(hex[v & 15]);
+        }
+    }
+
+    void opacity(const char* name, float a) {
+        if (a >= 1.0f) return;
+        char buf[32];
+        out.put(' ');
+        out.put(name);
+        out.put("=\"");
+        out.put(buf, FormatFixed(std::llround(std::max(a, 0.0f) * 100.0f), 2, buf));
+        out.put('"');
+    }
+
+    void close_group() {
+        if (!group_open) return;
+        out.put("</g>\n");
+        group_open = false;
+    }
+
+    // Ramer-Douglas-Peucker without recursion: keep[i] marks the points that
+    // stay. Distances are to the segment, so closed loops are handled too
+    void simplify(float tolerance) {
+        const size_t n = points.size();
+        keep.assign(n, tolerance > 0.0f ? 0 : 1);
+        keep[0] = keep[n - 1] = 1;
+        if (tolerance <= 0.0f || n < 3) return;
+        const float tol2 = tolerance * tolerance;
+        ranges.clear();
+        ranges.emplace_back(0, static_cast<uint32_t>(n - 1));
+        while (!ranges.empty()) {
+            auto [a, b] = ranges.back();
+            ranges.pop_back();
+            if (b <= a + 1) continue;
+            const ImVec2 pa = points[a], d = points[b] - pa;
+            const float len2 = d.x * d.x + d.y * d.y;
+            float worst = -1.0f;
+            uint32_t worst_i = a;
+            for (uint32_t i = a + 1; i < b; ++i) {
+                ImVec2 v = points[i] - pa;
+                float t = len2 > 0.0f ? std::clamp((v.x * d.x + v.y * d.y) / len2, 0.0f, 1.0f) : 0.0f;
+                ImVec2 e = v - d * t;
+                float dist2 = e.x * e.x + e.y * e.y;
+                if (dist2 > worst) {
+                    worst = dist2;
+                    worst_i = i;
+                }
+            }
+            if (worst <= tol2) continue;
+            keep[worst_i] = 1;
+            ranges.emplace_back(a, worst_i);
+            ranges.emplace_back(worst_i, b);
+        }
+    }
+
+    // Strokes with the same pen share a <g> with the style. Path data is
+    // one absolute moveto and relative linetos; deltas are taken between
+    // quantized points, so rounding does not accumulate along the stroke
+    void write_stroke(const Stroke& stroke) {
+        stroke.decode_points(points);
+        if (points.empty()) return;
+        stats.strokes++;
+        stats.input_points += points.size();
+
+        const ImU32 col = ImColor(stroke.color);
+        const int64_t width = std::max<int64_t>(1, quantize(stroke.thickness));
+        if (!group_open || col != group_color || width != group_width) {
+            close_group();
+            out.put("<g fill=\"none\" stroke=\"");
+            color(stroke.color);
+            out.put('"');
+            opacity("stroke-opacity", stroke.color.w);
+            out.put(" stroke-width=\"");
+            number(width);
+            out.put("\">\n");
+            group_open = true;
+            group_color = col;
+            group_width = width;
+        }
+
+        simplify(options.simplify_tolerance);
+        char buf[32];
+        bool after_number = false, had_dot = false;
+        auto path_number = [&](int64_t q) {
+            size_t n = FormatFixed(q, precision, buf);
+            // "1.5.5" and "1-2" are two numbers for an SVG parser
+            if (after_number && buf[0] != '-' && !(buf[0] == '.' && had_dot)) out.put(' ');
+            out.put(buf, n);
+            after_number = true;
+            had_dot = std::memchr(buf, '.', n) != nullptr;
+        };
+
+        int64_t x = quantize(points[0].x - origin.x), y = quantize(points[0].y - origin.y);
+        out.put("<path d=\"M");
+        path_number(x);
+        path_number(y);
+        out.put('l');
+        after_number = false;
+        size_t segments = 0;
+        for (size_t i = 1; i < points.size(); ++i) {
+            if (!keep[i]) continue;
+            int64_t nx = quantize(points[i].x - origin.x), ny = quantize(points[i].y - origin.y);
+            if (nx == x && ny == y) continue;
+            path_number(nx - x);
+            path_number(ny - y);
+            x = nx;
+            y = ny;
+            segments++;
+        }
+        // A single point stays a dot: a zero-length segment gets round caps
+        if (segments == 0) {
+            path_number(0);
+            path_number(0);
+        }
+        out.put("\"/>\n");
+        stats.output_points += segments + 1;
+    }
+
+    // ImGui::Text draws from the top-left corner; SVG text sits on the baseline
+    void write_text(const TextLabel& label) {
+        stats.labels++;
+        out.put("<text font-size=\"");
+        number(quantize(font_size));
+        out.put("\" fill=\"");
+        color(label.color);
+        out.put('"');
+        opacity("fill-opacity", label.color.w);
+        out.put('>');
+        const char* s = label.text.c_str();
+        const char* end = s + label.text.size();
+        for (int line = 0; s <= end; ++line) {
+            const char* eol = static_cast<const char*>(std::memchr(s, '\n', static_cast<size_t>(end - s)));
+            if (!eol) eol = end;
+            out.put("<tspan x=\"");
+            coordinate(label.position.x, origin.x);
+            out.put("\" y=\"");
+            coordinate(label.position.y + float(line) * font_size + ascent, origin.y);
+            out.put("\">");
+            out.put_escaped(s, static_cast<size_t>(eol - s));
+            out.put("</tspan>");
+            s = eol + 1;
+        }
+        out.put("</text>\n");
+    }
+
+    void write_image(const ImageElement& image) {
+        stats.images++;
+        const ImVec2 size = image.display_size();
+        out.put("<image x=\"");
+        coordinate(image.position.x, origin.x);
+        out.put("\" y=\"");
+        coordinate(image.position.y, origin.y);
+        out.put("\" width=\"");
+        number(quantize(size.x));
+        out.put("\" height=\"");
+        number(quantize(size.y));
+        out.put("\" preserveAspectRatio=\"none\" xlink:href=\"");
+        FILE* file = options.embed_images ? std::fopen(image.path.c_str(), "rb") : nullptr;
+        if (!file) {
+            out.put_escaped(image.path.data(), image.path.size());
+            out.put("\"/>\n");
+            return;
+        }
+        // The file is streamed through a fixed chunk, whatever its size
+        out.put("data:image/png;base64,");
+        chunk.resize(kImageChunk);
+        encoded.resize(kImageChunk / 3 * 4);
+        size_t n;
+        while ((n = std::fread(chunk.data(), 1, chunk.size(), file)) > 0) {
+            size_t o = 0;
+            for (size_t i = 0; i < n; i += 3) {
+                uint32_t v = uint32_t(chunk[i]) << 16;
+                if (i + 1 < n) v |= uint32_t(chunk[i + 1]) << 8;
+                if (i + 2 < n) v |= chunk[i + 2];
+                encoded[o++] = kBase64[(v >> 18) & 63];
+                encoded[o++] = kBase64[(v >> 12) & 63];
+                encoded[o++] = i + 1 < n ? kBase64[(v >> 6) & 63] : '=';
+                encoded[o++] = i + 2 < n ? kBase64[v & 63] : '=';
+            }
+            out.put(encoded.data(), o);
+        }
+        std::fclose(file);
+        out.put("\"/>\n");
+    }
+
+    SvgWriter& out;
+    const SvgExportOptions& options;
+    SvgExportStats& stats;
+    const int precision;
+    float scale = 1.0f;
+    float font_size = 13.0f;
+    float ascent = 0.0f;
+    ImVec2 origin;
+
+    bool group_open = false;
+    ImU32 group_color = 0;
+    int64_t group_width = 0;
+
+    std::vector<ImVec2> points;
+    std::vector<uint8_t> keep;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    std::vector<uint8_t> chunk;
+    std::vector<char> encoded;
+};
+
+// Pages come from `page(i)`, valid until the next call; null fails the export
+bool ExportPages(size_t count, const std::function<const CanvasState*(size_t)>& page, const std::string& path,
+                 const SvgExportOptions& options, SvgExportStats* stats_out) {
+    auto start = std::chrono::steady_clock::now();
+    SvgExportStats stats;
+    SvgWriter out;
+    if (!out.open(path)) {
+        std::cerr << "SVG export: cannot open " << path << "\n";
+        return false;
+    }
+    SvgPageWriter pages(out, options, stats);
+
+    out.put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg");
+    const uint64_t size_offset = out.position();
+    out.put(std::string(kHeaderRoom, ' ').c_str());
+    out.put("xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+            "stroke-linecap=\"round\" stroke-linejoin=\"round\" font-family=\"ProggyClean,monospace\" "
+            "xml:space=\"preserve\">\n");
+
+    float top = 0.0f, width = 0.0f;
+    bool ok = true;
+    for (size_t i = 0; i < count; ++i) {
+        const CanvasState* canvas = page(i);
+        if (!canvas) {
+            std::cerr << "SVG export: cannot read page " << i + 1 << "\n";
+            ok = false;
+            break;
+        }
+        if (i > 0) top += options.page_gap;
+        ImVec2 size = pages.write_page(*canvas, top);
+        width = std::max(width, size.x);
+        top += size.y;
+    }
+    out.put("</svg>\n");
+
+    // Document size goes into the room left after "<svg"
+    char size_attrs[kHeaderRoom + 1];
+    char w[32], h[32];
+    w[FormatFixed(pages.quantize(width), std::clamp(options.precision, 0, kMaxPrecision), w)] = 0;
+    h[FormatFixed(pages.quantize(top), std::clamp(options.precision, 0, kMaxPrecision), h)] = 0;
+    std::snprintf(size_attrs, sizeof(size_attrs), " width=\"%s\" height=\"%s\" viewBox=\"0 0 %s %s\"", w, h, w, h);
+    ok = out.patch(size_offset, size_attrs) && ok;
+    stats.file_bytes = out.position();
+    ok = out.close() && ok;
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.elements_per_second = stats.seconds > 0.0 ? double(stats.elements) / stats.seconds : 0.0;
+    stats.buffer_bytes = kBufferSize + pages.scratch_bytes();
+    if (stats_out) *stats_out = stats;
+    std::cerr << "SVG export: " << path << " " << stats.pages << " pages, " << stats.elements << " elements in "
+              << stats.seconds << "s (" << static_cast<size_t>(stats.elements_per_second) << " elements/s), "
+              << stats.file_bytes << " bytes" << (ok ? "" : " (write error)") << "\n";
+    return ok;
+}
+
+} // namespace
+
+bool ExportCanvasSvg(const CanvasState& canvas, const std::string& path, const SvgExportOptions& options,
+                     SvgExportStats* stats) {
+    if (canvas.elements.empty() && !options.use_region) {
+        std::cerr << "SVG export: canvas is empty\n";
+        return false;
+    }
+    return ExportPages(1, [&](size_t) { return &canvas; }, path, options, stats);
+}
+
+bool ExportNotebookSvg(const Notebook& notebook, const CanvasState& canvas, const std::string& path,
+                       const SvgExportOptions& options, SvgExportStats* stats) {
+    CanvasState loaded;
+    return ExportPages(notebook.page_count(), [&](size_t i) -> const CanvasState* {
+        if (i == notebook.current()) return &canvas;
+        // The previous page is released before the next one is parsed
+        loaded.elements.clear();
+        PageBytes bytes = notebook.data(i).load();
+        if (!bytes || !ParsePage(*bytes, loaded)) return nullptr;
+        return &loaded;
+    }, path, options, stats);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <imgui.h>
+#include "core/CanvasState.hpp"
+#include "core/Notebook.hpp"
+
+struct SvgExportOptions
+{
+    // Export a canvas-space region instead of the page bounds (elements
+    // outside it are skipped, the ones crossing its edge are clipped)
+    bool use_region = false;
+    ImVec2 region_min = ImVec2(0.0f, 0.0f);
+    ImVec2 region_max = ImVec2(0.0f, 0.0f);
+
+    float margin = 16.0f;             // canvas units added around the page bounds
+    int precision = 1;                // decimal places of coordinates, 0..4
+    float simplify_tolerance = 0.25f; // max deviation of simplified strokes (canvas units), 0 = every point
+    bool embed_images = true;         // PNG data inline (base64), otherwise a link to the file
+    bool draw_background = true;
+    ImVec4 background = ImVec4(40 / 255.0f, 40 / 255.0f, 50 / 255.0f, 1.0f);
+    float page_gap = 32.0f;           // notebooks: space between stacked pages
+};
+
+struct SvgExportStats
+{
+    size_t pages = 0;
+    size_t elements = 0; // written elements
+    size_t strokes = 0;
+    size_t labels = 0;
+    size_t images = 0;
+    size_t input_points = 0;
+    size_t output_points = 0; // after simplification and merging of equal coordinates
+    size_t buffer_bytes = 0;  // peak memory of the writer and per-element scratch buffers
+    size_t file_bytes = 0;
+    double seconds = 0.0;
+    double elements_per_second = 0.0;
+};
+
+// Streams the canvas into an SVG file: strokes become simplified paths
+// (Ramer-Douglas-Peucker) with relative, fixed-precision coordinates, labels
+// become text. Output goes through a fixed-size buffer, so memory does not
+// depend on the document size. UI thread only (label bounds use the font).
+bool ExportCanvasSvg(const CanvasState &canvas, const std::string &path, const SvgExportOptions &options,
+                     SvgExportStats *stats = nullptr);
+
+// All pages of the notebook stacked top to bottom in one SVG, one nested
+// <svg> per page. `canvas` is the page being edited; the others are loaded
+// and parsed one at a time, so only a single page is in memory.
+bool ExportNotebookSvg(const Notebook &notebook, const CanvasState &canvas, const std::string &path,
+                       const SvgExportOptions &options, SvgExportStats *stats = nullptr);
@@ -0,0 +1,510 @@
+#include "import/PngReader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Length codes 257..285 and distance codes (RFC 1951, 3.2.5)
+constexpr uint16_t kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                    6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order of the code length code lengths in a dynamic block header
+constexpr uint8_t kClenOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// LSB-first bit reader. Reading past the end yields zeros and is reported
+// by overrun() once more than the refill slack was consumed.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : p(data), end(data + size) {}
+
+    uint32_t peek(int n) {
+        refill();
+        return static_cast<uint32_t>(bits & ((uint64_t(1) << n) - 1));
+    }
+    void drop(int n) {
+        bits >>= n;
+        count -= n;
+    }
+    uint32_t get(int n) {
+        uint32_t v = peek(n);
+        drop(n);
+        return v;
+    }
+    void align_to_byte() { drop(count & 7); }
+    // Byte-aligned copy for stored blocks; call after align_to_byte()
+    bool copy_bytes(uint8_t* out, size_t n) {
+        // Drain whole bytes still in the bit buffer first
+        while (n > 0 && count >= 8) {
+            *out++ = static_cast<uint8_t>(get(8));
+            --n;
+        }
+        if (static_cast<size_t>(end - p) < n) return false;
+        std::memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+    bool overrun() const { return padding > 8; }
+
+private:
+    void refill() {
+        while (count <= 56) {
+            uint64_t byte = 0;
+            if (p < end) byte = *p++;
+            else ++padding;
+            bits |= byte << count;
+            count += 8;
+        }
+    }
+
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t bits = 0;
+    int count = 0;
+    int padding = 0;
+};
+
+// Canonical Huffman decoder: codes up to kFastBits long resolve with one
+// table lookup, longer ones walk the code lengths.
+struct Huffman {
+    static constexpr int kFastBits = 10;
+    uint16_t fast[1 << kFastBits];   // (symbol << 4) | length, 0 = not in the table
+    uint16_t counts[16];
+    uint16_t symbols[288];
+
+    bool build(const uint8_t* lengths, int n) {
+        std::memset(counts, 0, sizeof(counts));
+        for (int i = 0; i < n; ++i) counts[lengths[i]]++;
+        counts[0] = 0;
+        // Over-subscribed sets are invalid; incomplete ones are allowed (single distance code)
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left = (left << 1) - counts[len];
+            if (left < 0) return false;
+        }
+        uint16_t offsets[16];
+        offsets[1] = 0;
+        for (int len = 1; len < 15; ++len) offsets[len + 1] = offsets[len] + counts[len];
+        for (int i = 0; i < n; ++i)
+            if (lengths[i]) symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+
+        std::memset(fast, 0, sizeof(fast));
+        uint32_t code = 0;
+        int index = 0;
+        for (int len = 1; len <= kFastBits; ++len) {
+            for (int k = 0; k < counts[len]; ++k, ++code, ++index) {
+                uint32_t reversed = 0;
+                for (int b = 0; b < len; ++b) reversed |= ((code >> b) & 1u) << (len - 1 - b);
+                for (uint32_t r = reversed; r < (1u << kFastBits); r += 1u << len)
+                    fast[r] = static_cast<uint16_t>((symbols[index] << 4) | len);
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    int decode(BitReader& br) const {
+        uint16_t entry = fast[br.peek(kFastBits)];
+        if (entry) {
+            br.drop(entry & 15);
+            return entry >> 4;
+        }
+        // Slow path, bit by bit from the start of the code
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            code |= static_cast<int>(br.get(1));
+            int count = counts[len];
+            if (code - first < count) return symbols[index + code - first];
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+bool build_fixed(Huffman& lit, Huffman& dist) {
+    uint8_t lengths[288];
+    std::fill(lengths, lengths + 144, 8);
+    std::fill(lengths + 144, lengths + 256, 9);
+    std::fill(lengths + 256, lengths + 280, 7);
+    std::fill(lengths + 280, lengths + 288, 8);
+    uint8_t dist_lengths[30];
+    std::fill(dist_lengths, dist_lengths + 30, 5);
+    return lit.build(lengths, 288) && dist.build(dist_lengths, 30);
+}
+
+bool build_dynamic(BitReader& br, Huffman& lit, Huffman& dist) {
+    int hlit = static_cast<int>(br.get(5)) + 257;
+    int hdist = static_cast<int>(br.get(5)) + 1;
+    int hclen = static_cast<int>(br.get(4)) + 4;
+    if (hlit > 286 || hdist > 30) return false;
+
+    uint8_t clen_lengths[19] = {};
+    for (int i = 0; i < hclen; ++i) clen_lengths[kClenOrder[i]] = static_cast<uint8_t>(br.get(3));
+    Huffman clen;
+    if (!clen.build(clen_lengths, 19)) return false;
+
+    uint8_t lengths[286 + 30];
+    int n = 0;
+    while (n < hlit + hdist) {
+        int sym = clen.decode(br);
+        if (sym < 0) return false;
+        if (sym < 16) {
+            lengths[n++] = static_cast<uint8_t>(sym);
+            continue;
+        }
+        uint8_t value = 0;
+        int repeat;
+        if (sym == 16) {
+            if (n == 0) return false;
+            value = lengths[n - 1];
+            repeat = 3 + static_cast<int>(br.get(2));
+        } else if (sym == 17) {
+            repeat = 3 + static_cast<int>(br.get(3));
+        } else {
+            repeat = 11 + static_cast<int>(br.get(7));
+        }
+        if (n + repeat > hlit + hdist) return false;
+        std::fill(lengths + n, lengths + n + repeat, value);
+        n += repeat;
+    }
+    if (lengths[256] == 0) return false; // no end-of-block code
+    return lit.build(lengths, hlit) && dist.build(lengths + hlit, hdist);
+}
+
+uint32_t read_be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+void set_error(std::string* error, const char* message) {
+    if (error) *error = message;
+}
+
+int paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// Reverses the scanline filter in place; prev is the previous unfiltered row or nullptr.
+bool unfilter(uint8_t filter, uint8_t* row, const uint8_t* prev, size_t size, size_t bpp) {
+    switch (filter) {
+        case 0: break;
+        case 1:
+            for (size_t i = bpp; i < size; ++i) row[i] = uint8_t(row[i] + row[i - bpp]);
+            break;
+        case 2:
+            if (prev)
+                for (size_t i = 0; i < size; ++i) row[i] = uint8_t(row[i] + prev[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < size; ++i) {
+                int left = i >= bpp ? row[i - bpp] : 0;
+                int up = prev ? prev[i] : 0;
+                row[i] = uint8_t(row[i] + ((left + up) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < size; ++i) {
+                int left = i >= bpp ? row[i - bpp] : 0;
+                int up = prev ? prev[i] : 0;
+                int up_left = prev && i >= bpp ? prev[i - bpp] : 0;
+                row[i] = uint8_t(row[i] + paeth(left, up, up_left));
+            }
+            break;
+        default: return false;
+    }
+    return true;
+}
+
+struct PngHeader {
+    uint32_t width = 0, height = 0;
+    int depth = 0, color_type = 0, interlace = 0;
+    int channels = 0;
+    uint8_t palette[256][4] = {};
+    int palette_size = 0;
+    bool has_key = false;   // tRNS color key for gray/RGB
+    uint16_t key[3] = {};
+
+    size_t row_bytes(uint32_t w) const { return (size_t(w) * channels * depth + 7) / 8; }
+};
+
+// Sample i of a row at the header's bit depth, unscaled
+inline uint16_t sample(const uint8_t* row, size_t i, int depth) {
+    switch (depth) {
+        case 8: return row[i];
+        case 16: return uint16_t((row[i * 2] << 8) | row[i * 2 + 1]);
+        default: {
+            size_t bit = i * depth;
+            return uint16_t((row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1));
+        }
+    }
+}
+
+inline uint8_t to8(uint16_t v, int depth) {
+    if (depth == 16) return uint8_t(v >> 8);
+    if (depth == 8) return uint8_t(v);
+    return uint8_t(v * 255 / ((1 << depth) - 1));
+}
+
+// Converts one unfiltered row to RGBA8 pixels x0, x0+dx, ... of the output row
+void convert_row(const PngHeader& h, const uint8_t* row, uint32_t count, uint8_t* out, size_t out_step) {
+    for (uint32_t x = 0; x < count; ++x, out += out_step) {
+        switch (h.color_type) {
+            case 0: {
+                uint16_t g = sample(row, x, h.depth);
+                out[0] = out[1] = out[2] = to8(g, h.depth);
+                out[3] = h.has_key && g == h.key[0] ? 0 : 255;
+                break;
+            }
+            case 2: {
+                uint16_t r = sample(row, x * 3, h.depth), g = sample(row, x * 3 + 1, h.depth),
+                         b = sample(row, x * 3 + 2, h.depth);
+                out[0] = to8(r, h.depth);
+                out[1] = to8(g, h.depth);
+                out[2] = to8(b, h.depth);
+                out[3] = h.has_key && r == h.key[0] && g == h.key[1] && b == h.key[2] ? 0 : 255;
+                break;
+            }
+            case 3: {
+                uint16_t index = sample(row, x, h.depth);
+                const uint8_t* c = h.palette[index < h.palette_size ? index : 0];
+                out[0] = c[0];
+                out[1] = c[1];
+                out[2] = c[2];
+                out[3] = c[3];
+                break;
+            }
+            case 4:
+                out[0] = out[1] = out[2] = to8(sample(row, x * 2, h.depth), h.depth);
+                out[3] = to8(sample(row, x * 2 + 1, h.depth), h.depth);
+                break;
+            case 6:
+                for (int c = 0; c < 4; ++c) out[c] = to8(sample(row, x * 4 + c, h.depth), h.depth);
+                break;
+        }
+    }
+}
+
+struct Pass {
+    uint32_t x0, y0, dx, dy;
+};
+constexpr Pass kAdam7[7] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4},
+                            {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}};
+
+uint32_t pass_size(uint32_t full, uint32_t start, uint32_t step) {
+    return full > start ? (full - start + step - 1) / step : 0;
+}
+
+} // namespace
+
+bool Inflate(const uint8_t* in, size_t size, uint8_t* out, size_t out_size, size_t* produced) {
+    *produced = 0;
+    if (size < 2 || (in[0] & 0x0F) != 8 || ((in[0] << 8) | in[1]) % 31 != 0 || (in[1] & 0x20))
+        return false; // not deflate, bad header check or preset dictionary
+    BitReader br(in + 2, size - 2);
+    size_t pos = 0;
+    Huffman lit, dist;
+    bool last = false;
+    while (!last) {
+        last = br.get(1) != 0;
+        uint32_t type = br.get(2);
+        if (type == 0) {
+            br.align_to_byte();
+            uint32_t len = br.get(16);
+            uint32_t nlen = br.get(16);
+            if ((len ^ 0xFFFF) != nlen || len > out_size - pos) return false;
+            if (!br.copy_bytes(out + pos, len)) return false;
+            pos += len;
+            continue;
+        }
+        if (type == 1) {
+            if (!build_fixed(lit, dist)) return false;
+        } else if (type == 2) {
+            if (!build_dynamic(br, lit, dist)) return false;
+        } else {
+            return false;
+        }
+        for (;;) {
+            int sym = lit.decode(br);
+            if (sym < 0 || br.overrun()) return false;
+            if (sym < 256) {
+                if (pos >= out_size) return false;
+                out[pos++] = static_cast<uint8_t>(sym);
+                continue;
+            }
+            if (sym == 256) break;
+            sym -= 257;
+            if (sym >= 29) return false;
+            size_t length = kLengthBase[sym] + br.get(kLengthExtra[sym]);
+            int dsym = dist.decode(br);
+            if (dsym < 0 || dsym >= 30) return false;
+            size_t distance = kDistBase[dsym] + br.get(kDistExtra[dsym]);
+            if (distance > pos || length > out_size - pos) return false;
+            const uint8_t* from = out + pos - distance;
+            uint8_t* to = out + pos;
+            if (distance >= length) {
+                std::memcpy(to, from, length);
+            } else {
+                for (size_t i = 0; i < length; ++i) to[i] = from[i]; // overlapping run
+            }
+            pos += length;
+        }
+        if (br.overrun()) return false;
+    }
+    *produced = pos;
+    return true;
+}
+
+bool ReadPng(const std::string& path, DecodedImage& out, std::string* error) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        set_error(error, "cannot open file");
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[1 << 16];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + n);
+    std::fclose(file);
+
+    static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (data.size() < 8 || std::memcmp(data.data(), kSignature, 8) != 0) {
+        set_error(error, "not a PNG file");
+        return false;
+    }
+
+    PngHeader h;
+    std::vector<uint8_t> idat;
+    bool have_header = false, have_end = false;
+    size_t pos = 8;
+    while (pos + 12 <= data.size() && !have_end) {
+        uint32_t length = read_be32(&data[pos]);
+        const char* type = reinterpret_cast<const char*>(&data[pos + 4]);
+        if (length > data.size() - pos - 12) {
+            set_error(error, "truncated chunk");
+            return false;
+        }
+        const uint8_t* body = &data[pos + 8];
+        if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+            h.width = read_be32(body);
+            h.height = read_be32(body + 4);
+            h.depth = body[8];
+            h.color_type = body[9];
+            h.interlace = body[12];
+            static const int kChannels[7] = {1, 0, 3, 1, 2, 0, 4};
+            h.channels = h.color_type <= 6 ? kChannels[h.color_type] : 0;
+            bool depth_ok = h.depth == 8 || h.depth == 16 ||
+                            ((h.color_type == 0 || h.color_type == 3) && (h.depth == 1 || h.depth == 2 || h.depth == 4));
+            if (h.channels == 0 || !depth_ok || (h.color_type == 3 && h.depth == 16) || body[10] != 0 ||
+                body[11] != 0 || h.interlace > 1) {
+                set_error(error, "unsupported PNG format");
+                return false;
+            }
+            have_header = true;
+        } else if (std::memcmp(type, "PLTE", 4) == 0) {
+            h.palette_size = static_cast<int>(std::min<uint32_t>(length / 3, 256));
+            for (int i = 0; i < h.palette_size; ++i) {
+                h.palette[i][0] = body[i * 3];
+                h.palette[i][1] = body[i * 3 + 1];
+                h.palette[i][2] = body[i * 3 + 2];
+                h.palette[i][3] = 255;
+            }
+        } else if (std::memcmp(type, "tRNS", 4) == 0) {
+            if (h.color_type == 3) {
+                for (uint32_t i = 0; i < length && i < 256; ++i) h.palette[i][3] = body[i];
+            } else if (h.color_type == 0 && length >= 2) {
+                h.has_key = true;
+                h.key[0] = uint16_t((body[0] << 8) | body[1]);
+            } else if (h.color_type == 2 && length >= 6) {
+                h.has_key = true;
+                for (int c = 0; c < 3; ++c) h.key[c] = uint16_t((body[c * 2] << 8) | body[c * 2 + 1]);
+            }
+        } else if (std::memcmp(type, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), body, body + length);
+        } else if (std::memcmp(type, "IEND", 4) == 0) {
+            have_end = true;
+        }
+        pos += 12 + length;
+    }
+    if (!have_header || idat.empty()) {
+        set_error(error, "missing image data");
+        return false;
+    }
+    if (h.width == 0 || h.height == 0 || size_t(h.width) * h.height > kMaxImagePixels) {
+        set_error(error, "image too large");
+        return false;
+    }
+    data.clear();
+    data.shrink_to_fit();
+
+    // Raw (filtered) size: every row of every pass carries a filter byte
+    const int passes = h.interlace ? 7 : 1;
+    size_t raw_size = 0;
+    for (int p = 0; p < passes; ++p) {
+        Pass pass = h.interlace ? kAdam7[p] : Pass{0, 0, 1, 1};
+        uint32_t pw = pass_size(h.width, pass.x0, pass.dx), ph = pass_size(h.height, pass.y0, pass.dy);
+        if (pw && ph) raw_size += size_t(ph) * (1 + h.row_bytes(pw));
+    }
+    std::vector<uint8_t> raw(raw_size);
+    size_t produced = 0;
+    if (!Inflate(idat.data(), idat.size(), raw.data(), raw.size(), &produced) || produced != raw_size) {
+        set_error(error, "corrupt image data");
+        return false;
+    }
+    idat.clear();
+    idat.shrink_to_fit();
+
+    out.width = static_cast<int>(h.width);
+    out.height = static_cast<int>(h.height);
+    out.rgba.assign(size_t(h.width) * h.height * 4, 0);
+    const size_t bpp = std::max<size_t>(1, size_t(h.channels) * h.depth / 8);
+    uint8_t* cursor = raw.data();
+    for (int p = 0; p < passes; ++p) {
+        Pass pass = h.interlace ? kAdam7[p] : Pass{0, 0, 1, 1};
+        uint32_t pw = pass_size(h.width, pass.x0, pass.dx), ph = pass_size(h.height, pass.y0, pass.dy);
+        if (!pw || !ph) continue;
+        const size_t row_bytes = h.row_bytes(pw);
+        const uint8_t* prev = nullptr;
+        for (uint32_t y = 0; y < ph; ++y) {
+            uint8_t* row = cursor + 1;
+            if (!unfilter(cursor[0], row, prev, row_bytes, bpp)) {
+                set_error(error, "corrupt image data");
+                return false;
+            }
+            uint8_t* dst = &out.rgba[((size_t(pass.y0) + size_t(y) * pass.dy) * h.width + pass.x0) * 4];
+            convert_row(h, row, pw, dst, size_t(pass.dx) * 4);
+            prev = row;
+            cursor += 1 + row_bytes;
+        }
+    }
+    return true;
+}
+
+// Odd sizes clamp the last column/row
+void HalveImage(const uint8_t* src, int sw, int sh, uint8_t* dst, int dw, int dh) {
+    for (int y = 0; y < dh; ++y) {
+        const int y0 = std::min(y * 2, sh - 1), y1 = std::min(y * 2 + 1, sh - 1);
+        for (int x = 0; x < dw; ++x) {
+            const int x0 = std::min(x * 2, sw - 1), x1 = std::min(x * 2 + 1, sw - 1);
+            const uint8_t* p[4] = {src + (size_t(y0) * sw + x0) * 4, src + (size_t(y0) * sw + x1) * 4,
+                                   src + (size_t(y1) * sw + x0) * 4, src + (size_t(y1) * sw + x1) * 4};
+            uint32_t a = p[0][3] + p[1][3] + p[2][3] + p[3][3];
+            uint8_t* out = dst + (size_t(y) * dw + x) * 4;
+            for (int c = 0; c < 3; ++c) {
+                uint32_t sum = p[0][c] * p[0][3] + p[1][c] * p[1][3] + p[2][c] * p[2][3] + p[3][c] * p[3][3];
+                out[c] = a ? uint8_t((sum + a / 2) / a) : uint8_t((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+            }
+            out[3] = uint8_t((a + 2) / 4);
+        }
+    }
+}
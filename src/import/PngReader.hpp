@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "util/MemoryStats.hpp"
+
+// Decompresses a complete zlib stream (stored, fixed and dynamic Huffman
+// blocks) into a caller-sized buffer. Fails instead of writing past
+// out_size; *produced receives the number of bytes written.
+bool Inflate(const uint8_t* in, size_t size, uint8_t* out, size_t out_size, size_t* produced);
+
+using ImagePixels = TrackedVector<uint8_t, MemCategory::Images>;
+
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    ImagePixels rgba; // tightly packed RGBA8, width * 4 bytes per row
+};
+
+// Largest image accepted by ReadPng (pixels), bounds the decode allocation.
+constexpr size_t kMaxImagePixels = size_t(1) << 28;
+
+// Decodes a PNG file to RGBA8: all color types and bit depths, palette and
+// tRNS transparency, Adam7 interlacing. 16-bit samples are truncated.
+// Blocking; meant for worker threads.
+bool ReadPng(const std::string& path, DecodedImage& out, std::string* error = nullptr);
+
+// Halves an RGBA8 image (dw = max(1, sw / 2), dh likewise) with a 2x2 box
+// filter weighted by alpha, so transparent pixels do not darken the edges.
+void HalveImage(const uint8_t* src, int sw, int sh, uint8_t* dst, int dw, int dh);
@@ -1,23 +1,94 @@
 #include "input/CanvasController.hpp"
 #include <algorithm>
+#include <cfloat>
 #include <cmath>
 #include <imgui.h>
 #include "core/CanvasElement.hpp"
+#include "input/EraseGesture.hpp"
+#include "render/ImageStore.hpp"
 #include <memory>
 #include <algorithm>
 
 #include <util/ImVecUtil.hpp>
 #include <iostream>
 
-static bool point_near(const ImVec2 &a, const ImVec2 &b, float r)
+static ImVec2 last_mouse;
+static bool was_alt = false;
+static EraseGesture erase_gesture;
+static ImVec2 last_erase;
+// Курсор в координатах холста на последнем update()
+static ImVec2 last_mouse_world;
+// Буфер обмена холста: копии элементов; геометрия штрихов разделяется
+static std::vector<std::unique_ptr<CanvasElement>> clipboard;
+// Файлы изображений без размера в документе: размер публикует декодер
+// ImageStore (ImageAsset::width/height), UI-поток файл не читает
+static std::vector<std::shared_ptr<ImageAsset>> unsized_images;
+
+// Ставит в ожидание файлы изображений документа, у которых нет размера
+static void track_unsized_images(const CanvasState &canvas)
 {
-    float dx = a.x - b.x;
-    float dy = a.y - b.y;
-    return dx * dx + dy * dy <= r * r;
+    for (const auto &el : canvas.elements)
+    {
+        auto image = dynamic_cast<const ImageElement *>(el.get());
+        if (!image || image->has_size())
+            continue;
+        bool tracked = std::any_of(unsized_images.begin(), unsized_images.end(),
+                                   [&](const auto &asset) { return asset->path() == image->path; });
+        if (!tracked)
+            unsized_images.push_back(ImageStore::shared().acquire(image->path));
+    }
 }
 
-static ImVec2 last_mouse;
-static bool was_alt = false;
+// Декодированные файлы дают размер всем своим изображениям без размера.
+// Правка не попадает в историю: undo вставки уносит элемент уже с размером,
+// а вернувшиеся без размера (undo/redo до декодирования) ставятся в ожидание снова
+static void apply_image_sizes(CanvasState &canvas)
+{
+    for (size_t i = 0; i < unsized_images.size();)
+    {
+        const ImageAsset &asset = *unsized_images[i];
+        if (asset.state() == ImageAsset::State::Decoding)
+        {
+            ++i;
+            continue;
+        }
+        // Нечитаемый файл остаётся заглушкой
+        if (asset.state() == ImageAsset::State::Ready)
+        {
+            for (auto &el : canvas.elements)
+            {
+                auto image = dynamic_cast<ImageElement *>(el.get());
+                if (image && !image->has_size() && image->path == asset.path())
+                {
+                    image->size = ImageElement::FitSize(asset.width(), asset.height());
+                    canvas.note_modified(image);
+                }
+            }
+        }
+        unsized_images.erase(unsized_images.begin() + i);
+    }
+}
+
+// Добавляет копии source со сдвигом delta в конец документа одной записью
+// истории. Штрихи-копии разделяют геометрию с оригиналом
+static void paste_elements(CanvasState &canvas, History &history,
+                           const std::vector<std::unique_ptr<CanvasElement>> &source, const ImVec2 &delta)
+{
+    HistoryPatch patch;
+    for (const auto &el : source)
+    {
+        auto copy = el->duplicate();
+        copy->translate(delta);
+        patch.after.push_back({canvas.elements.size(), copy->id, nullptr});
+        canvas.elements.push_back(std::move(copy));
+        canvas.note_added(canvas.elements.back().get());
+    }
+    if (patch.empty())
+        return;
+    canvas.selected_element = canvas.elements.back().get();
+    canvas.is_editing_text = false;
+    history.push_patch(std::move(patch));
+}
 
 static float clamp_float(float v, float lo, float hi)
 {
@@ -28,11 +99,19 @@ static float clamp_float(float v, float lo, float hi)
     return v;
 }
 
+bool CanvasController::erasing() const
+{
+    return erase_gesture.active();
+}
+
 void CanvasController::update(CanvasState &canvas, History &history, bool &is_drawing, ImGuiIO &io, ToolSettings &tool)
 {
     ImVec2 mouse_screen = io.MousePos;
     ImVec2 canvas_origin = ImGui::GetMainViewport()->Pos;
 
+    if (!unsized_images.empty())
+        apply_image_sizes(canvas);
+
     // --- Zoom around the cursor position ---
     float wheel = io.MouseWheel;
     if (wheel != 0.0f)
@@ -73,6 +152,7 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
 
     // --- Convert screen mouse position to canvas space ---
     ImVec2 mouse_world = (mouse_screen - canvas_origin - canvas.pan) / canvas.zoom;
+    last_mouse_world = mouse_world;
 
     // --- Element selection ---
     if (ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !alt && tool.type == ToolType::Select)
@@ -132,18 +212,27 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
             auto stroke = std::make_unique<Stroke>();
             stroke->color = tool.color;
             stroke->thickness = tool.radius;
-            stroke->points.push_back(mouse_world);
+            stroke->add_point(mouse_world);
             active_stroke = stroke.get();
             canvas.elements.push_back(std::move(stroke));
+            canvas.note_added(active_stroke);
         }
         if (is_drawing)
         {
             if (ImGui::IsMouseDown(ImGuiMouseButton_Left) && active_stroke)
             {
-                active_stroke->points.push_back(mouse_world);
+                uint32_t from = static_cast<uint32_t>(active_stroke->point_count());
+                active_stroke->add_point(mouse_world);
+                canvas.note_appended(active_stroke, from);
             }
             else
             {
+                // Штрих завершён — переводим в компактное хранение
+                if (active_stroke)
+                {
+                    active_stroke->pack();
+                    canvas.note_modified(active_stroke);
+                }
                 is_drawing = false;
                 active_stroke = nullptr;
             }
@@ -151,24 +240,18 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
     }
     else if (!alt && tool.type == ToolType::Eraser)
     {
+        // Стирание перетаскиванием: штрихи режутся по следу ластика
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left))
         {
-            history.push(canvas);
-            auto &elems = canvas.elements;
-            elems.erase(std::remove_if(elems.begin(), elems.end(),
-                                       [&](const std::unique_ptr<CanvasElement> &el)
-                                       {
-                                           auto s = dynamic_cast<Stroke *>(el.get());
-                                           if (!s)
-                                               return false;
-                                           for (const ImVec2 &p : s->points)
-                                           {
-                                               if (point_near(p, mouse_world, tool.radius))
-                                                   return true;
-                                           }
-                                           return false;
-                                       }),
-                        elems.end());
+            erase_gesture.begin(canvas);
+            erase_gesture.erase(canvas, mouse_world, mouse_world, tool.radius);
+            last_erase = mouse_world;
+        }
+        else if (erase_gesture.active() && ImGui::IsMouseDown(ImGuiMouseButton_Left) &&
+                 (mouse_world.x != last_erase.x || mouse_world.y != last_erase.y))
+        {
+            erase_gesture.erase(canvas, last_erase, mouse_world, tool.radius);
+            last_erase = mouse_world;
         }
     }
     else if (!alt && tool.type == ToolType::Text)
@@ -185,9 +268,18 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
             text->size = tool.radius;
             text->text = "Sample Text"; // Пока простой текст, позже можно добавить диалог ввода
             canvas.elements.push_back(std::move(text));
+            canvas.note_added(canvas.elements.back().get());
         }
     }
 
+    // Жест ластика — одна запись истории; завершается отпусканием кнопки,
+    // сменой инструмента или перед undo/redo
+    bool undo_redo = ImGui::IsKeyDown(ImGuiKey_LeftCtrl) &&
+                     (ImGui::IsKeyPressed(ImGuiKey_Z, false) || ImGui::IsKeyPressed(ImGuiKey_Y, false));
+    if (erase_gesture.active() &&
+        (alt || tool.type != ToolType::Eraser || !ImGui::IsMouseDown(ImGuiMouseButton_Left) || undo_redo))
+        history.push_patch(erase_gesture.finish(canvas));
+
     // --- Text editing with keyboard ---
     if (canvas.selected_element && canvas.is_editing_text)
     {
@@ -195,6 +287,7 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
         if (text)
         {
             text->is_focused = true;
+            const std::string text_before = text->text;
 
             // Обработка ввода текста
             for (int i = 0; i < io.InputQueueCharacters.Size; i++)
@@ -320,6 +413,10 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
                 text->cursor_pos = (int)text->text.length();
             }
 
+            // Содержимое изменилось — записываем в журнал
+            if (text->text != text_before)
+                canvas.note_modified(text);
+
             // Escape для выхода из редактирования
             if (ImGui::IsKeyPressed(ImGuiKey_Escape))
             {
@@ -341,25 +438,74 @@ void CanvasController::update(CanvasState &canvas, History &history, bool &is_dr
         }
     }
 
+    // --- Copy / paste / duplicate ---
+    if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && !canvas.is_editing_text && !is_drawing && !erase_gesture.active())
+    {
+        if (ImGui::IsKeyPressed(ImGuiKey_C, false) && canvas.selected_element)
+        {
+            clipboard.clear();
+            clipboard.push_back(canvas.selected_element->clone());
+        }
+        if (ImGui::IsKeyPressed(ImGuiKey_V, false) && !clipboard.empty())
+        {
+            // Центр содержимого буфера — под курсор
+            ImVec2 min(FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX);
+            for (const auto &el : clipboard)
+            {
+                ImVec2 el_min, el_max;
+                if (!el->get_bounds(el_min, el_max))
+                    continue;
+                min = ImVec2(std::min(min.x, el_min.x), std::min(min.y, el_min.y));
+                max = ImVec2(std::max(max.x, el_max.x), std::max(max.y, el_max.y));
+            }
+            ImVec2 delta = min.x <= max.x ? mouse_world - (min + max) * 0.5f : ImVec2(0.0f, 0.0f);
+            paste_elements(canvas, history, clipboard, delta);
+        }
+        if (ImGui::IsKeyPressed(ImGuiKey_D, false) && canvas.selected_element)
+        {
+            // Копия рядом с оригиналом: сдвиг 20px на экране
+            std::vector<std::unique_ptr<CanvasElement>> source;
+            source.push_back(canvas.selected_element->clone());
+            paste_elements(canvas, history, source, ImVec2(20.0f, 20.0f) / canvas.zoom);
+        }
+    }
+
     // --- Undo / Redo handling ---
     if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_Z, false))
     {
-        if (auto prev = history.undo(canvas))
+        if (history.undo(canvas))
         {
-            canvas = *prev;
             // Сбрасываем выбор после undo
             canvas.selected_element = nullptr;
             canvas.is_editing_text = false;
+            track_unsized_images(canvas);
         }
     }
     if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_Y, false))
     {
-        if (auto next = history.redo(canvas))
+        if (history.redo(canvas))
         {
-            canvas = *next;
             // Сбрасываем выбор после redo
             canvas.selected_element = nullptr;
             canvas.is_editing_text = false;
+            track_unsized_images(canvas);
         }
     }
 }
+
+void CanvasController::add_images(CanvasState &canvas, History &history, const std::vector<std::string> &paths)
+{
+    // Файлы здесь не читаются: изображения встают заглушкой, размер
+    // появится после декодирования в пуле потоков (apply_image_sizes)
+    std::vector<std::unique_ptr<CanvasElement>> images;
+    ImVec2 pos = last_mouse_world;
+    for (const std::string &path : paths)
+    {
+        auto image = std::make_unique<ImageElement>(path, ImVec2(0.0f, 0.0f));
+        image->position = pos;
+        pos += ImVec2(24.0f, 24.0f) / canvas.zoom;
+        images.push_back(std::move(image));
+    }
+    paste_elements(canvas, history, images, ImVec2(0.0f, 0.0f));
+    track_unsized_images(canvas);
+}
@@ -3,8 +3,15 @@
 #include "core/History.hpp"
 #include "core/Tool.hpp"
 #include <imgui.h>
+#include <string>
+#include <vector>
 
 class CanvasController {
 public:
     void update(CanvasState& canvas, History& history, bool& is_drawing, ImGuiIO& io, ToolSettings& tool);
+    // Идёт жест ластика: он держит указатели на штрихи документа и допишет
+    // патч в текущую историю, поэтому документ до отпускания не подменяется
+    bool erasing() const;
+    // Файлы, брошенные на окно: изображения под курсором каскадом, одной записью истории
+    void add_images(CanvasState& canvas, History& history, const std::vector<std::string>& paths);
 };
@@ -0,0 +1,147 @@
+#include "input/EraseGesture.hpp"
+#include "core/StrokeErase.hpp"
+
+#include <algorithm>
+
+void EraseGesture::begin(const CanvasState &canvas)
+{
+    is_active = true;
+    grid.clear();
+    order.clear();
+    originals.clear();
+    created.clear();
+    slots.clear();
+
+    order.reserve(canvas.elements.size());
+    for (size_t i = 0; i < canvas.elements.size(); ++i)
+    {
+        CanvasElement *el = canvas.elements[i].get();
+        order.push_back(el->id);
+        if (dynamic_cast<Stroke *>(el))
+        {
+            ImVec2 min, max;
+            el->get_bounds(min, max);
+            grid.insert(el, min, max);
+            slots.emplace(el, i);
+        }
+    }
+}
+
+size_t EraseGesture::slot_of(const CanvasState &canvas, const CanvasElement *el)
+{
+    // Жест только удаляет элементы и дописывает куски в конец, поэтому
+    // штрих мог сдвинуться лишь к началу документа
+    size_t &hint = slots[el];
+    const auto &elements = canvas.elements;
+    size_t i = std::min(hint, elements.size() - 1);
+    while (i > 0 && elements[i].get() != el)
+        --i;
+    if (elements[i].get() != el)
+    {
+        auto it = std::find_if(elements.begin(), elements.end(), [&](const auto &p) { return p.get() == el; });
+        i = static_cast<size_t>(it - elements.begin());
+    }
+    hint = i;
+    return i;
+}
+
+void EraseGesture::erase(CanvasState &canvas, const ImVec2 &a, const ImVec2 &b, float radius)
+{
+    // Bounds в сетке уже включают толщину штриха
+    ImVec2 qmin(std::min(a.x, b.x) - radius, std::min(a.y, b.y) - radius);
+    ImVec2 qmax(std::max(a.x, b.x) + radius, std::max(a.y, b.y) + radius);
+    grid.query(qmin, qmax, candidates);
+
+    struct Cut
+    {
+        CanvasElement *element;
+        std::vector<std::unique_ptr<Stroke>> pieces;
+    };
+    std::vector<Cut> cuts;
+    std::vector<std::unique_ptr<Stroke>> pieces;
+    for (CanvasElement *el : candidates)
+    {
+        pieces.clear();
+        if (CutStroke(*static_cast<Stroke *>(el), a, b, radius, pieces))
+            cuts.push_back({el, std::move(pieces)});
+    }
+    if (cuts.empty())
+        return;
+
+    // Первый кусок занимает слот исходного штриха, остальные дописываются в
+    // конец. Слоты полностью стёртых штрихов убираются одним сдвигом в конце
+    std::vector<CanvasElement *> added;
+    bool vanished = false;
+    for (Cut &cut : cuts)
+    {
+        CanvasElement *el = cut.element;
+        const size_t slot = slot_of(canvas, el);
+        ImVec2 min, max;
+        el->get_bounds(min, max);
+        grid.remove(el, min, max);
+        slots.erase(el);
+        if (canvas.selected_element == el)
+            canvas.selected_element = nullptr;
+        canvas.note_removed(el->id);
+        // Исходный штрих сохраняется для патча, промежуточный кусок жеста — нет
+        std::unique_ptr<CanvasElement> old = std::move(canvas.elements[slot]);
+        if (created.erase(old->id) == 0)
+            originals.emplace(old->id, std::move(old));
+
+        vanished |= cut.pieces.empty();
+        for (size_t k = 0; k < cut.pieces.size(); ++k)
+        {
+            CanvasElement *p = cut.pieces[k].get();
+            p->get_bounds(min, max);
+            grid.insert(p, min, max);
+            created.insert(p->id);
+            added.push_back(p);
+            if (k == 0)
+            {
+                canvas.elements[slot] = std::move(cut.pieces[k]);
+                slots.emplace(p, slot);
+            }
+            else
+            {
+                slots.emplace(p, canvas.elements.size());
+                canvas.elements.push_back(std::move(cut.pieces[k]));
+            }
+        }
+    }
+    if (vanished)
+        canvas.elements.erase(std::remove(canvas.elements.begin(), canvas.elements.end(), nullptr),
+                              canvas.elements.end());
+    for (CanvasElement *p : added)
+        canvas.note_added(p, slot_of(canvas, p));
+}
+
+HistoryPatch EraseGesture::finish(const CanvasState &canvas)
+{
+    HistoryPatch patch;
+    if (!originals.empty())
+    {
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            auto it = originals.find(order[i]);
+            if (it != originals.end())
+                patch.before.push_back({i, order[i], std::move(it->second)});
+        }
+    }
+    if (!created.empty())
+    {
+        for (size_t i = 0; i < canvas.elements.size(); ++i)
+        {
+            uint64_t id = canvas.elements[i]->id;
+            if (created.count(id))
+                patch.after.push_back({i, id, nullptr});
+        }
+    }
+
+    is_active = false;
+    grid.clear();
+    order.clear();
+    originals.clear();
+    created.clear();
+    slots.clear();
+    return patch;
+}
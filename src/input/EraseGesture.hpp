@@ -0,0 +1,37 @@
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "core/CanvasState.hpp"
+#include "core/History.hpp"
+#include "core/SpatialGrid.hpp"
+
+// Стирание перетаскиванием: от нажатия до отпускания кнопки.
+// Штрихи режутся по следу ластика на уцелевшие куски; кандидаты берутся из
+// сетки по bounding box, построенной при нажатии. Разрезанный штрих
+// заменяется на месте: первый кусок встаёт в его слот, остальные — в конец
+// документа, так что кадр стирания не перестраивает elements. Весь жест
+// сводится в один HistoryPatch: исходные штрихи и итоговые куски с их позициями
+class EraseGesture
+{
+public:
+    bool active() const { return is_active; }
+
+    void begin(const CanvasState &canvas);
+    // Стирает вдоль пути ластика от a до b (координаты холста)
+    void erase(CanvasState &canvas, const ImVec2 &a, const ImVec2 &b, float radius);
+    // Патч для History; пустой, если ничего не стёрто
+    HistoryPatch finish(const CanvasState &canvas);
+
+private:
+    size_t slot_of(const CanvasState &canvas, const CanvasElement *el);
+
+    bool is_active = false;
+    SpatialGrid grid;
+    std::unordered_map<const CanvasElement *, size_t> slots; // штрих -> позиция в elements (подсказка)
+    std::vector<uint64_t> order; // id элементов документа на момент нажатия
+    std::unordered_map<uint64_t, std::unique_ptr<CanvasElement>> originals; // задетые исходные штрихи
+    std::unordered_set<uint64_t> created; // куски, созданные жестом и ещё живые
+    std::vector<CanvasElement *> candidates;
+};
@@ -2,23 +2,58 @@
 #include "ui/ImGuiLayer.hpp"
 #include "core/CanvasState.hpp"
 #include "core/History.hpp"
+#include "core/Notebook.hpp"
 #include "core/Tool.hpp"
 #include "input/CanvasController.hpp"
 #include "render/CanvasRenderer.hpp"
+#include "render/ImageStore.hpp"
+#include "render/ThumbnailCache.hpp"
 #include "ui/ToolPanel.hpp"
+#include "ui/ReplicationPanel.hpp"
+#include "ui/SearchPanel.hpp"
+#include "ui/PageNavigator.hpp"
+#include "core/ChangeLog.hpp"
+#include "core/TextIndex.hpp"
+#include "net/Replication.hpp"
+#include "util/FrameScheduler.hpp"
+#include "util/MemoryStats.hpp"
+#include "ui/MemoryPanel.hpp"
+#include "util/Startup.hpp"
+#include "util/ThreadPool.hpp"
 
 #include <imgui.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <csignal>
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <string>
+#include <vector>
+
+// Startup budget from process start to the first presented frame.
+static constexpr double kFirstFrameTargetMs = 300.0;
 
 // Global focus flag
 static bool g_window_focused = true;
 
+// Paths dropped onto the window since the last frame
+static std::vector<std::string> g_dropped_files;
+
+static void drop_callback(GLFWwindow*, int count, const char** paths) {
+    for (int i = 0; i < count; ++i) g_dropped_files.emplace_back(paths[i]);
+}
+
+// Set by SIGUSR1, the memory report is printed on the next frame
+static std::atomic<bool> g_memory_dump_requested{false};
+
+static void memory_dump_signal(int) {
+    g_memory_dump_requested.store(true);
+}
+
 // Return current system time as string for logging prefix.
 static std::string now_str() {
     using namespace std::chrono;
@@ -45,23 +80,115 @@ void focus_callback(GLFWwindow* window, int focused) {
     }
 }
 
-int main() {
-    GLFWwindow* window = InitWindow();
+// Log replication throughput/latency every few seconds.
+static void log_replication(const char* role, const ReplicationStats& stats) {
+    std::cerr << "[" << now_str() << "] Replication " << role << ": seq=" << stats.seq
+              << " " << std::fixed << std::setprecision(1) << stats.bytes_per_sec / 1024.0 << "KB/s "
+              << stats.ops_per_sec << " ops/s";
+    if (stats.latency_avg_ms > 0.0) {
+        std::cerr << " latency avg=" << std::setprecision(2) << stats.latency_avg_ms
+                  << "ms max=" << stats.latency_max_ms << "ms";
+    }
+    std::cerr << std::defaultfloat << "\n";
+}
+
+int main(int argc, char** argv) {
+    StartupProfile startup;
+
+    // [notebook]           notebook file to open
+    // --publish [socket]  stream this canvas to mirrors
+    // --mirror [socket]   read-only view of a publishing instance
+    bool publish = false;
+    bool mirror = false;
+    std::string socket_path = kDefaultReplicationSocket;
+    std::string notebook_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--publish" || arg == "--mirror") {
+            (arg == "--publish" ? publish : mirror) = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') socket_path = argv[++i];
+        } else if (arg[0] != '-') {
+            notebook_path = arg;
+        }
+    }
+
+    GLFWwindow* window = InitWindow(1280, 720, mirror ? "myNotes (mirror)" : "myNotes");
     if (!window) return -1;
+    startup.mark("window");
 
     // Set focus callback and initial vsync
     glfwSetWindowFocusCallback(window, focus_callback);
+    glfwSetDropCallback(window, drop_callback);
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1); // enable vsync initially
 
-    InitImGui(window);
+    // Frame budget follows the display; background work fits into what is left of it
+    FrameScheduler& scheduler = FrameScheduler::shared();
+    scheduler.set_refresh_rate(DisplayRefreshRate(window));
+    ImageStore& images = ImageStore::shared();
+
+    FontAtlasInfo font_atlas = InitImGui(window);
     ImGuiIO& io = ImGui::GetIO();
+    startup.mark(font_atlas.from_cache ? "imgui (cached fonts)" : "imgui (fonts baked)");
+
+    // The thumbnail prune job and the first canvas frame already use the
+    // workers, so the pool starts here and its cost shows in the profile
+    ThreadPool::shared();
+    startup.mark("thread pool");
 
     CanvasState canvas;
     History history;
+    Notebook notebook;
+    ThumbnailCache thumbnails;
+    if (!notebook_path.empty() && !mirror) {
+        // Only the page table and the current page are read, whatever the page count
+        std::string error;
+        if (notebook.open(notebook_path, canvas, history, &error)) {
+            startup.mark("notebook (" + std::to_string(notebook.page_count()) + " pages)");
+        } else {
+            std::cerr << "[" << now_str() << "] Cannot open " << notebook_path << ": " << error << "\n";
+        }
+    }
     CanvasController controller;
     ToolSettings tool;
     bool is_drawing = false;
+    TextIndex text_index;
+    bool text_index_ready = false;
+
+    // Not needed to show the first frame: started afterwards, one per frame
+    DeferredInit deferred;
+    auto post_text_index = [&] {
+        scheduler.post("text index", [&](FrameScheduler::Clock::time_point deadline) {
+            return text_index.process(deadline);
+        });
+    };
+    deferred.add("text index", [&] {
+        // Only starts the walk over the document; the labels are indexed by
+        // the scheduler job in the time left over from each frame
+        text_index.rebuild(canvas);
+        text_index_ready = true;
+        post_text_index();
+    });
+
+    // Footprints that are cheaper to measure on demand than to track
+    SetMemorySource(MemCategory::Text, [&] {
+        size_t bytes = 0;
+        for (const auto& el : canvas.elements) {
+            if (auto text = dynamic_cast<const TextLabel*>(el.get())) bytes += text->text_heap_bytes();
+        }
+        return bytes;
+    });
+    SetMemorySource(MemCategory::Index, [&] { return text_index.memory_bytes(); });
+    SetMemorySource(MemCategory::Pages, [&] { return notebook.memory_bytes(); });
+    std::signal(SIGUSR1, memory_dump_signal);
+    bool first_frame = true;
+
+    ReplicationServer replication_server;
+    ReplicationClient replication_client;
+    if (publish) replication_server.start(socket_path);
+    if (mirror) replication_client.connect(socket_path);
+    const char* replication_role = publish ? "publisher" : "mirror";
+    auto last_replication_log = std::chrono::steady_clock::now();
 
     // Timing helpers
     auto last_loop_time = std::chrono::steady_clock::now();
@@ -82,21 +209,57 @@ int main() {
                       << "ms focused=" << (g_window_focused ? "yes" : "no") << "\n";
         }
         last_loop_time = loop_start;
+        scheduler.begin_frame();
 
         // Start ImGui frame.
         NewFrame();
 
         // Measure controller/update time.
         auto before_update = std::chrono::steady_clock::now();
-        controller.update(canvas, history, is_drawing, io, tool);
+        if (mirror) {
+            // The mirror only follows the publisher, local input is ignored
+            replication_client.poll(canvas);
+        } else {
+            controller.update(canvas, history, is_drawing, io, tool);
+            if (!g_dropped_files.empty()) {
+                controller.add_images(canvas, history, g_dropped_files);
+                g_dropped_files.clear();
+            }
+        }
         auto after_update = std::chrono::steady_clock::now();
         auto update_dur = std::chrono::duration_cast<std::chrono::milliseconds>(after_update - before_update);
         if (update_dur.count() > 50) {
             std::cerr << "[" << now_str() << "] Notice: controller.update took " << update_dur.count() << "ms\n";
         }
 
+        // Hand this frame's document changes to subscribers (one batch per frame)
+        notebook.track_changes(canvas);
+        FrameChanges frame_changes = CollectChanges(canvas);
+        if (publish) replication_server.publish(canvas, frame_changes);
+        if (text_index_ready) {
+            // Indexing is time-sliced, a large snapshot is spread over several frames
+            text_index.enqueue(frame_changes);
+            if (text_index.pending()) post_text_index();
+        }
+
+        const ReplicationStats& replication_stats =
+            publish ? replication_server.stats() : replication_client.stats();
+        if (replication_stats.active && loop_start - last_replication_log >= std::chrono::seconds(5)) {
+            log_replication(replication_role, replication_stats);
+            last_replication_log = loop_start;
+        }
+
+        // Finished decodes become drawable; the page strip and the canvas then queue the texture levels they want
+        images.begin_frame();
+        thumbnails.begin_frame();
+        UpdatePageThumbnails(notebook, thumbnails, canvas, is_drawing);
+
         // Submit UI (tool panel always, canvas drawing is gated below)
-        RenderToolPanel(canvas, history, tool);
+        if (!mirror) RenderToolPanel(canvas, history, tool, notebook);
+        // Page switches replace canvas.elements: not while a stroke or an erase gesture is in progress
+        if (!mirror) RenderPageNavigator(notebook, thumbnails, canvas, history, !is_drawing && !controller.erasing());
+        RenderSearchPanel(canvas, text_index);
+        RenderReplicationPanel(replication_role, replication_stats);
 
         // Determine if full canvas render should happen.
         bool do_full_canvas = g_window_focused;
@@ -110,11 +273,24 @@ int main() {
         }
 
         if (do_full_canvas) {
-            RenderCanvas(canvas);
+            RenderCanvas(canvas, RenderQualityForLevel(scheduler.quality_level()));
+        }
+        if (images.has_pending_uploads()) {
+            scheduler.post("image upload", [&](FrameScheduler::Clock::time_point deadline) {
+                return images.upload(deadline);
+            });
         }
 
+        // Background jobs take the rest of the frame budget
+        scheduler.run_jobs();
+
         // Finalize ImGui frame.
         ImGui::Render();
+        MemSetMeasured(MemCategory::Render, ImGuiMemoryBytes() + CanvasBatchMemoryBytes());
+        if (g_memory_dump_requested.exchange(false)) {
+            std::cerr << "[" << now_str() << "] ";
+            DumpMemoryReport();
+        }
 
         // Framebuffer size check.
         int display_w = 0, display_h = 0;
@@ -134,6 +310,7 @@ int main() {
         RenderImGui();
 
         // Swap buffers with timing log.
+        scheduler.end_frame();
         auto swap_before = std::chrono::steady_clock::now();
         glfwSwapBuffers(window);
         auto swap_after = std::chrono::steady_clock::now();
@@ -141,6 +318,18 @@ int main() {
         if (swap_dur.count() > 100) {
             std::cerr << "[" << now_str() << "] Warning: SwapBuffers took " << swap_dur.count() << "ms\n";
         }
+
+        if (first_frame) {
+            first_frame = false;
+            startup.mark("first frame");
+            std::cerr << "[" << now_str() << "] " << startup.report(kFirstFrameTargetMs) << "\n";
+        } else if (deferred.pending()) {
+            std::string name;
+            double ms = 0.0;
+            deferred.run_next(&name, &ms);
+            std::cerr << "[" << now_str() << "] Deferred init: " << name << " " << std::fixed
+                      << std::setprecision(1) << ms << "ms" << std::defaultfloat << "\n";
+        }
     }
 
     std::cerr << "[" << now_str() << "] Application exiting\n";
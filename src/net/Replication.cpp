@@ -0,0 +1,563 @@
+#include "net/Replication.hpp"
+#include "core/Serialize.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Message framing: u32 payload size, u8 type, payload
+enum MessageType : uint8_t {
+    MsgSubscribe = 1, // client -> server: u32 protocol, u64 session, u64 last applied seq (0 = none)
+    MsgSnapshot = 2,  // u64 session, u64 seq, view, u32 count, elements
+    MsgBatch = 3,     // u64 session, u64 seq, u64 publish time (ns), u8 has view [view], u32 op count, ops
+    MsgReject = 4,    // u32 server protocol
+};
+
+enum OpType : uint8_t {
+    OpRemove = 1, // u64 id
+    OpAdd = 2,    // u32 index, element
+    OpModify = 3, // element
+    OpAppend = 4, // u64 id, u32 from, u32 count, count * ImVec2
+};
+
+constexpr size_t kHeaderSize = 5;
+constexpr size_t kMaxBacklogBatches = 512;
+constexpr size_t kMaxBacklogBytes = 16u << 20;
+constexpr size_t kMaxClientQueue = 64u << 20; // slower subscribers are dropped and resync
+constexpr size_t kMaxMessage = 256u << 20;
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+// Random non-zero id of a publisher run
+uint64_t new_session_id() {
+    std::random_device rd;
+    uint64_t id = (uint64_t(rd()) << 32) ^ rd() ^ now_ns();
+    return id != 0 ? id : 1;
+}
+
+bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool make_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Starts a message in out; finish_message() patches the size.
+size_t begin_message(std::vector<uint8_t>& out, uint8_t type) {
+    size_t start = out.size();
+    out.resize(start + kHeaderSize);
+    out[start + 4] = type;
+    return start;
+}
+
+void finish_message(std::vector<uint8_t>& out, size_t start) {
+    uint32_t size = static_cast<uint32_t>(out.size() - start - kHeaderSize);
+    std::memcpy(out.data() + start, &size, sizeof(size));
+}
+
+void write_view(ByteWriter& w, const ImVec2& pan, float zoom) {
+    w.put(pan.x);
+    w.put(pan.y);
+    w.put(zoom);
+}
+
+std::vector<uint8_t> encode_snapshot(const CanvasState& canvas, uint64_t session, uint64_t seq) {
+    std::vector<uint8_t> out;
+    size_t start = begin_message(out, MsgSnapshot);
+    ByteWriter w(out);
+    w.put(session);
+    w.put(seq);
+    write_view(w, canvas.pan, canvas.zoom);
+    w.put<uint32_t>(static_cast<uint32_t>(canvas.elements.size()));
+    for (const auto& el : canvas.elements) WriteElement(w, *el);
+    finish_message(out, start);
+    return out;
+}
+
+// Reads framed messages from a non-blocking socket into buffer.
+// Returns false when the peer closed the connection or on error.
+bool receive(int fd, std::vector<uint8_t>& buffer, size_t& received) {
+    uint8_t chunk[64 * 1024];
+    for (;;) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n > 0) {
+            buffer.insert(buffer.end(), chunk, chunk + n);
+            received += static_cast<size_t>(n);
+            continue;
+        }
+        if (n == 0) return false;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+        if (errno == EINTR) continue;
+        return false;
+    }
+}
+
+// Splits complete messages off the front of buffer.
+template <typename Fn>
+bool for_each_message(std::vector<uint8_t>& buffer, Fn&& fn) {
+    size_t pos = 0;
+    bool ok = true;
+    while (ok && buffer.size() - pos >= kHeaderSize) {
+        uint32_t size;
+        std::memcpy(&size, buffer.data() + pos, sizeof(size));
+        if (size > kMaxMessage) {
+            ok = false;
+            break;
+        }
+        if (buffer.size() - pos - kHeaderSize < size) break;
+        ok = fn(buffer[pos + 4], buffer.data() + pos + kHeaderSize, size);
+        pos += kHeaderSize + size;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + pos);
+    return ok;
+}
+
+} // namespace
+
+// ---------- RateMeter ----------
+
+void RateMeter::add(double b, double o, double n) {
+    bytes += b;
+    ops += o;
+    batches += n;
+}
+
+void RateMeter::add_latency(double ms) {
+    latency_sum += ms;
+    latency_max = std::max(latency_max, ms);
+    latency_count++;
+}
+
+void RateMeter::update(ReplicationStats& stats) {
+    auto now = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(now - window_start).count();
+    if (sec < 1.0) return;
+    stats.bytes_per_sec = bytes / sec;
+    stats.ops_per_sec = ops / sec;
+    stats.batches_per_sec = batches / sec;
+    if (latency_count > 0) {
+        stats.latency_avg_ms = latency_sum / latency_count;
+        stats.latency_max_ms = latency_max;
+    }
+    *this = RateMeter();
+}
+
+// ---------- ReplicationServer ----------
+
+ReplicationServer::~ReplicationServer() {
+    for (Client& c : clients) ::close(c.fd);
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        ::unlink(socket_path.c_str());
+    }
+}
+
+bool ReplicationServer::start(const std::string& path) {
+    sockaddr_un addr;
+    if (!make_address(path, addr)) {
+        std::cerr << "Replication: socket path too long: " << path << "\n";
+        return false;
+    }
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "Replication: socket() failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    ::unlink(path.c_str()); // stale socket of a previous run
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, 8) != 0 || !set_nonblocking(listen_fd)) {
+        std::cerr << "Replication: cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    socket_path = path;
+    session = new_session_id();
+    stats_.active = true;
+    std::cerr << "Replication: publishing on " << path << "\n";
+    return true;
+}
+
+void ReplicationServer::accept_clients() {
+    for (;;) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) break;
+        if (!set_nonblocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        Client c;
+        c.fd = fd;
+        clients.push_back(std::move(c));
+    }
+}
+
+void ReplicationServer::send(Client& client, const std::vector<uint8_t>& message) {
+    client.out.insert(client.out.end(), message.begin(), message.end());
+    stats_.total_bytes += message.size();
+    meter.add(static_cast<double>(message.size()), 0.0, 0.0);
+}
+
+void ReplicationServer::flush(Client& client) {
+    while (client.fd >= 0 && client.out_pos < client.out.size()) {
+        ssize_t n = ::send(client.fd, client.out.data() + client.out_pos, client.out.size() - client.out_pos, MSG_NOSIGNAL);
+        if (n > 0) {
+            client.out_pos += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        ::close(client.fd);
+        client.fd = -1;
+    }
+    if (client.out_pos == client.out.size()) {
+        client.out.clear();
+        client.out_pos = 0;
+    } else if (client.out_pos > (1u << 20)) {
+        client.out.erase(client.out.begin(), client.out.begin() + client.out_pos);
+        client.out_pos = 0;
+    }
+    if (client.fd >= 0 && client.out.size() - client.out_pos > kMaxClientQueue) {
+        std::cerr << "Replication: subscriber too slow, dropping\n";
+        ::close(client.fd);
+        client.fd = -1;
+    }
+}
+
+void ReplicationServer::handle_input(Client& client, const CanvasState& canvas) {
+    size_t received = 0;
+    if (!receive(client.fd, client.in, received)) {
+        ::close(client.fd);
+        client.fd = -1;
+        return;
+    }
+    bool ok = for_each_message(client.in, [&](uint8_t type, const uint8_t* data, size_t size) {
+        if (type != MsgSubscribe) return false;
+        ByteReader r(data, size);
+        uint32_t protocol = r.get<uint32_t>();
+        if (protocol != kReplicationProtocol) {
+            std::vector<uint8_t> reject;
+            size_t start = begin_message(reject, MsgReject);
+            ByteWriter(reject).put(kReplicationProtocol);
+            finish_message(reject, start);
+            send(client, reject);
+            return false;
+        }
+        uint64_t client_session = r.get<uint64_t>();
+        uint64_t last_seq = r.get<uint64_t>();
+        if (r.failed()) return false;
+
+        // Catch up from the backlog when it still covers everything after
+        // last_seq; sequences of another session say nothing about the document
+        bool caught_up = false;
+        if (client_session == session && last_seq > 0 && last_seq <= seq) {
+            if (last_seq == seq) {
+                caught_up = true;
+            } else if (!backlog.empty() && backlog.front().first <= last_seq + 1) {
+                for (const auto& [batch_seq, message] : backlog) {
+                    if (batch_seq > last_seq) send(client, message);
+                }
+                caught_up = true;
+            }
+        }
+        if (!caught_up) {
+            send(client, encode_snapshot(canvas, session, seq));
+            stats_.snapshots++;
+        }
+        client.subscribed = true;
+        return true;
+    });
+    if (!ok && client.fd >= 0) {
+        flush(client);
+        ::close(client.fd);
+        client.fd = -1;
+    }
+}
+
+void ReplicationServer::publish(const CanvasState& canvas, const FrameChanges& changes) {
+    if (listen_fd < 0) return;
+
+    bool view_changed = canvas.pan.x != last_pan.x || canvas.pan.y != last_pan.y || canvas.zoom != last_zoom;
+    if (!changes.empty() || view_changed) {
+        // One batch per frame, applied by the mirror in this exact order
+        std::vector<uint8_t> message;
+        size_t start = begin_message(message, MsgBatch);
+        ByteWriter w(message);
+        w.put(session);
+        w.put(++seq);
+        w.put(now_ns());
+        w.put<uint8_t>(view_changed ? 1 : 0);
+        if (view_changed) write_view(w, canvas.pan, canvas.zoom);
+        uint32_t ops = static_cast<uint32_t>(changes.removed.size() + changes.added.size() +
+                                             changes.modified.size() + changes.appended.size());
+        w.put(ops);
+        for (uint64_t id : changes.removed) {
+            w.put<uint8_t>(OpRemove);
+            w.put(id);
+        }
+        for (const auto& [index, el] : changes.added) {
+            w.put<uint8_t>(OpAdd);
+            w.put(index);
+            WriteElement(w, *el);
+        }
+        for (const CanvasElement* el : changes.modified) {
+            w.put<uint8_t>(OpModify);
+            WriteElement(w, *el);
+        }
+        for (const auto& [el, from] : changes.appended) {
+            auto stroke = dynamic_cast<const Stroke*>(el);
+            if (!stroke || stroke->is_packed()) {
+                // Only the active stroke grows; anything else is sent whole
+                w.put<uint8_t>(OpModify);
+                WriteElement(w, *el);
+                continue;
+            }
+            uint32_t total = static_cast<uint32_t>(stroke->points.size());
+            uint32_t first = std::min(from, total);
+            uint32_t count = total - first;
+            w.put<uint8_t>(OpAppend);
+            w.put(stroke->id);
+            w.put(first);
+            w.put(count);
+            w.put_bytes(stroke->points.data() + first, count * sizeof(ImVec2));
+        }
+        finish_message(message, start);
+
+        last_pan = canvas.pan;
+        last_zoom = canvas.zoom;
+        meter.add(0.0, ops, 1.0);
+        stats_.seq = seq;
+
+        for (Client& c : clients) {
+            if (c.fd >= 0 && c.subscribed) send(c, message);
+        }
+        backlog_bytes += message.size();
+        backlog.emplace_back(seq, std::move(message));
+        while (backlog.size() > kMaxBacklogBatches || backlog_bytes > kMaxBacklogBytes) {
+            backlog_bytes -= backlog.front().second.size();
+            backlog.pop_front();
+        }
+    }
+
+    // New subscribers see the state after this frame's batch
+    accept_clients();
+    for (Client& c : clients) {
+        if (c.fd >= 0) handle_input(c, canvas);
+        if (c.fd >= 0) flush(c);
+    }
+    clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& c) { return c.fd < 0; }),
+                  clients.end());
+
+    stats_.subscribers = clients.size();
+    meter.update(stats_);
+}
+
+// ---------- ReplicationClient ----------
+
+ReplicationClient::~ReplicationClient() {
+    disconnect();
+}
+
+bool ReplicationClient::connect(const std::string& path) {
+    socket_path = path;
+    stats_.active = true;
+    return open_socket();
+}
+
+bool ReplicationClient::open_socket() {
+    next_retry = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr)) return false;
+    fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || !set_nonblocking(fd)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // Subscribe: ask for catch-up from the last applied batch
+    std::vector<uint8_t> message;
+    size_t start = begin_message(message, MsgSubscribe);
+    ByteWriter w(message);
+    w.put(kReplicationProtocol);
+    w.put(session);
+    w.put(seq);
+    finish_message(message, start);
+    if (::send(fd, message.data(), message.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(message.size())) {
+        disconnect();
+        return false;
+    }
+    in.clear();
+    std::cerr << "Replication: mirroring " << socket_path << " from seq " << seq << "\n";
+    return true;
+}
+
+void ReplicationClient::disconnect() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+void ReplicationClient::poll(CanvasState& canvas) {
+    if (fd < 0) {
+        if (!socket_path.empty() && std::chrono::steady_clock::now() >= next_retry) open_socket();
+        meter.update(stats_);
+        return;
+    }
+
+    size_t received = 0;
+    bool alive = receive(fd, in, received);
+    stats_.total_bytes += received;
+    meter.add(static_cast<double>(received), 0.0, 0.0);
+
+    bool ok = for_each_message(in, [&](uint8_t type, const uint8_t* data, size_t size) {
+        return apply_message(type, data, size, canvas);
+    });
+    if (!alive || !ok) {
+        if (!ok) std::cerr << "Replication: stream out of sync, resubscribing\n";
+        disconnect();
+    }
+    meter.update(stats_);
+}
+
+bool ReplicationClient::apply_message(uint8_t type, const uint8_t* data, size_t size, CanvasState& canvas) {
+    switch (type) {
+    case MsgSnapshot:
+        return apply_snapshot(data, size, canvas);
+    case MsgBatch:
+        return apply_batch(data, size, canvas);
+    case MsgReject: {
+        ByteReader r(data, size);
+        std::cerr << "Replication: publisher speaks protocol " << r.get<uint32_t>() << ", we speak "
+                  << kReplicationProtocol << "\n";
+        socket_path.clear(); // do not retry
+        return false;
+    }
+    default:
+        return false;
+    }
+}
+
+bool ReplicationClient::apply_snapshot(const uint8_t* data, size_t size, CanvasState& canvas) {
+    ByteReader r(data, size);
+    uint64_t snapshot_session = r.get<uint64_t>();
+    uint64_t snapshot_seq = r.get<uint64_t>();
+    CanvasState snapshot;
+    snapshot.pan.x = r.get<float>();
+    snapshot.pan.y = r.get<float>();
+    snapshot.zoom = r.get<float>();
+    uint32_t count = r.get<uint32_t>();
+    if (r.failed() || count > r.remaining()) return false;
+    snapshot.elements.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        auto el = ReadElement(r);
+        if (!el) return false;
+        snapshot.elements.push_back(std::move(el));
+    }
+    // Ids of another session may collide with the mirrored ones: no revision diff
+    canvas.replace(std::move(snapshot));
+
+    by_id.clear();
+    for (const auto& el : canvas.elements) by_id[el->id] = el.get();
+    session = snapshot_session;
+    seq = snapshot_seq;
+    stats_.seq = seq;
+    stats_.snapshots++;
+    return true;
+}
+
+bool ReplicationClient::apply_batch(const uint8_t* data, size_t size, CanvasState& canvas) {
+    ByteReader r(data, size);
+    uint64_t batch_session = r.get<uint64_t>();
+    uint64_t batch_seq = r.get<uint64_t>();
+    uint64_t sent = r.get<uint64_t>();
+    if (r.failed() || batch_session != session) return false;
+    if (batch_seq <= seq) return true; // already applied (overlap after catch-up)
+    if (batch_seq != seq + 1) return false;
+
+    if (r.get<uint8_t>()) {
+        canvas.pan.x = r.get<float>();
+        canvas.pan.y = r.get<float>();
+        canvas.zoom = r.get<float>();
+    }
+    uint32_t ops = r.get<uint32_t>();
+
+    auto erase_element = [&](CanvasElement* el) {
+        if (canvas.selected_element == el) canvas.selected_element = nullptr;
+        auto& elems = canvas.elements;
+        elems.erase(std::find_if(elems.begin(), elems.end(), [&](const auto& e) { return e.get() == el; }));
+    };
+
+    for (uint32_t i = 0; i < ops && !r.failed(); ++i) {
+        uint8_t op = r.get<uint8_t>();
+        if (op == OpRemove) {
+            uint64_t id = r.get<uint64_t>();
+            auto it = by_id.find(id);
+            if (it == by_id.end()) return false;
+            erase_element(it->second);
+            by_id.erase(it);
+            canvas.note_removed(id);
+        } else if (op == OpAdd) {
+            uint32_t index = r.get<uint32_t>();
+            auto el = ReadElement(r);
+            if (!el) return false;
+            CanvasElement* raw = el.get();
+            index = std::min<uint32_t>(index, static_cast<uint32_t>(canvas.elements.size()));
+            canvas.elements.insert(canvas.elements.begin() + index, std::move(el));
+            by_id[raw->id] = raw;
+            canvas.note_added(raw, index);
+        } else if (op == OpModify) {
+            auto el = ReadElement(r);
+            if (!el) return false;
+            auto it = by_id.find(el->id);
+            if (it == by_id.end()) return false;
+            auto slot = std::find_if(canvas.elements.begin(), canvas.elements.end(),
+                                     [&](const auto& e) { return e.get() == it->second; });
+            if (canvas.selected_element == it->second) canvas.selected_element = el.get();
+            it->second = el.get();
+            *slot = std::move(el);
+            canvas.changes.push_back({ChangeKind::Modified, it->first, it->second});
+        } else if (op == OpAppend) {
+            uint64_t id = r.get<uint64_t>();
+            uint32_t from = r.get<uint32_t>();
+            uint32_t count = r.get<uint32_t>();
+            auto it = by_id.find(id);
+            auto stroke = it != by_id.end() ? dynamic_cast<Stroke*>(it->second) : nullptr;
+            if (!stroke || stroke->point_count() != from || count > r.remaining() / sizeof(ImVec2)) return false;
+            for (uint32_t k = 0; k < count; ++k) {
+                ImVec2 p;
+                r.get_bytes(&p, sizeof(p));
+                stroke->add_point(p);
+            }
+            canvas.changes.push_back({ChangeKind::Appended, id, stroke, from});
+        } else {
+            return false;
+        }
+    }
+    if (r.failed()) return false;
+
+    seq = batch_seq;
+    stats_.seq = seq;
+    meter.add(0.0, ops, 1.0);
+    meter.add_latency((now_ns() - sent) / 1e6);
+    return true;
+}
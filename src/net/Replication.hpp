@@ -0,0 +1,117 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/CanvasState.hpp"
+#include "core/ChangeLog.hpp"
+
+// Live mirroring of a canvas into other local processes (presenter or
+// projector view) over a Unix-domain socket.
+//
+// The publisher turns each frame's FrameChanges into one versioned batch
+// of compact operations (remove / add / modify / append points / view) and
+// streams it to subscribers. A subscriber sends the last batch sequence it
+// applied; it is caught up from the backlog of recent batches, or gets a
+// full snapshot when it is new or too far behind. Sequences are only
+// meaningful within one publisher session: every publisher start picks a
+// random session id, and a subscriber from another session (the publisher
+// restarted) always gets a snapshot.
+
+constexpr uint32_t kReplicationProtocol = 2;
+constexpr const char* kDefaultReplicationSocket = "/tmp/myNotes.sock";
+
+struct ReplicationStats {
+    bool active = false;
+    uint64_t seq = 0;              // last batch sequence published / applied
+    size_t subscribers = 0;        // publisher only
+    double bytes_per_sec = 0.0;    // sent (publisher) or received (mirror)
+    double ops_per_sec = 0.0;
+    double batches_per_sec = 0.0;
+    double latency_avg_ms = 0.0;   // mirror only: publish -> applied
+    double latency_max_ms = 0.0;
+    uint64_t total_bytes = 0;
+    uint64_t snapshots = 0;        // full snapshots sent / received
+};
+
+// Per-second rates for the stats above
+class RateMeter {
+public:
+    void add(double bytes, double ops, double batches);
+    void add_latency(double ms);
+    void update(ReplicationStats& stats);
+
+private:
+    std::chrono::steady_clock::time_point window_start = std::chrono::steady_clock::now();
+    double bytes = 0.0, ops = 0.0, batches = 0.0;
+    double latency_sum = 0.0, latency_max = 0.0;
+    size_t latency_count = 0;
+};
+
+class ReplicationServer {
+public:
+    ~ReplicationServer();
+
+    bool start(const std::string& path = kDefaultReplicationSocket);
+    // Once per frame, after the controller has run.
+    void publish(const CanvasState& canvas, const FrameChanges& changes);
+    const ReplicationStats& stats() const { return stats_; }
+
+private:
+    struct Client {
+        int fd = -1;
+        bool subscribed = false;
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        size_t out_pos = 0;
+    };
+
+    void accept_clients();
+    void handle_input(Client& client, const CanvasState& canvas);
+    void send(Client& client, const std::vector<uint8_t>& message);
+    void flush(Client& client);
+
+    int listen_fd = -1;
+    std::string socket_path;
+    std::vector<Client> clients;
+    uint64_t session = 0;
+    uint64_t seq = 0;
+    std::deque<std::pair<uint64_t, std::vector<uint8_t>>> backlog; // recent batches for catch-up
+    size_t backlog_bytes = 0;
+    ImVec2 last_pan = ImVec2(0.0f, 0.0f);
+    float last_zoom = 1.0f;
+    ReplicationStats stats_;
+    RateMeter meter;
+};
+
+class ReplicationClient {
+public:
+    ~ReplicationClient();
+
+    bool connect(const std::string& path = kDefaultReplicationSocket);
+    // Applies everything received since the last call. Reconnects (and
+    // asks for catch-up from the last applied batch) when the link drops.
+    void poll(CanvasState& canvas);
+    const ReplicationStats& stats() const { return stats_; }
+    bool connected() const { return fd >= 0; }
+
+private:
+    bool open_socket();
+    void disconnect();
+    bool apply_message(uint8_t type, const uint8_t* data, size_t size, CanvasState& canvas);
+    bool apply_snapshot(const uint8_t* data, size_t size, CanvasState& canvas);
+    bool apply_batch(const uint8_t* data, size_t size, CanvasState& canvas);
+
+    int fd = -1;
+    std::string socket_path;
+    std::vector<uint8_t> in;
+    uint64_t session = 0; // publisher session of seq, 0 = nothing applied yet
+    uint64_t seq = 0;
+    std::unordered_map<uint64_t, CanvasElement*> by_id;
+    std::chrono::steady_clock::time_point next_retry;
+    ReplicationStats stats_;
+    RateMeter meter;
+};
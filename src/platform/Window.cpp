@@ -43,3 +43,11 @@ void ShutdownWindow(GLFWwindow* window) {
     if (window) glfwDestroyWindow(window);
     glfwTerminate();
 }
+
+int DisplayRefreshRate(GLFWwindow* window) {
+    // Windowed mode has no monitor of its own, use the primary one
+    GLFWmonitor* monitor = window ? glfwGetWindowMonitor(window) : nullptr;
+    if (!monitor) monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    return (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+}
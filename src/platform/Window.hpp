@@ -6,3 +6,6 @@
 
 GLFWwindow* InitWindow(int width = 1280, int height = 720, const char* title = "myNotes");
 void ShutdownWindow(GLFWwindow* window);
+
+// Refresh rate (Hz) of the monitor the window is on, 60 if unknown.
+int DisplayRefreshRate(GLFWwindow* window);
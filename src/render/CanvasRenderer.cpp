@@ -1,11 +1,330 @@
 #include "render/CanvasRenderer.hpp"
 #include <imgui.h>
 #include "core/CanvasElement.hpp"
+#include "render/ImageStore.hpp"
+#include "render/StrokeRenderer.hpp"
+#include "render/StrokeTessellator.hpp"
+#include "util/ThreadPool.hpp"
 #include <util/ImVecUtil.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <random>
 
-void RenderCanvas(const CanvasState& canvas) {
+namespace {
+
+// Меньше этого (в точках штрихов) геометрия строится на UI-потоке: на
+// редкой странице запуск пакетов и копирование дороже самой работы
+constexpr size_t kMinParallelCost = 32 * 1024;
+constexpr size_t kMinBatchCost = 4 * 1024;
+// Пакетов больше, чем потоков: длинные штрихи не оставляют потоки без дела
+constexpr size_t kBatchesPerThread = 4;
+// Постоянная часть стоимости элемента, в точках
+constexpr size_t kElementCost = 16;
+
+using Clock = std::chrono::steady_clock;
+
+double MsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Место в draw list окна под один диапазон вершин пакета
+struct MergeCopy {
+    const ImDrawList* src = nullptr;
+    unsigned int src_vtx = 0, vtx_count = 0;
+    unsigned int src_idx = 0, idx_count = 0;
+    size_t dst_vtx = 0, dst_idx = 0; // смещения: буферы dst ещё могут переехать
+    unsigned int base = 0;           // первый индекс диапазона в dst
+};
+
+struct RenderBatch {
+    size_t begin = 0, end = 0; // диапазон в CanvasBatches::visible
+    std::unique_ptr<ImDrawList> list;
+    StrokeTessStats stats;
+};
+
+// Списки пакетов живут между кадрами: буферы ImDrawList не сжимаются, и
+// после первых кадров рабочие потоки почти не выделяют память
+struct CanvasBatches {
+    std::vector<const CanvasElement*> visible;
+    std::vector<RenderBatch> batches;
+    std::vector<MergeCopy> copies;
+    CanvasRenderStats stats;
+};
+
+CanvasBatches& Batches() {
+    static CanvasBatches batches;
+    return batches;
+}
+
+struct CanvasPass {
+    const CanvasState& canvas;
+    const RenderQuality& quality;
+    ImVec2 origin;
+    ImVec2 clip_min, clip_max;
+    bool degraded = false;
+};
+
+// Изображение по текстуре из ImageStore; пока она не готова — заглушка элемента
+void DrawImage(const CanvasPass& pass, ImDrawList* draw_list, const ImageElement& image) {
+    const CanvasState& canvas = pass.canvas;
+    ImVec2 min = pass.origin + canvas.pan + image.position * canvas.zoom;
+    ImVec2 max = min + image.display_size() * canvas.zoom;
+    // Невидимые изображения не запрашивают текстуры и не держат их в памяти
+    if (max.x < pass.clip_min.x || max.y < pass.clip_min.y || min.x > pass.clip_max.x || min.y > pass.clip_max.y)
+        return;
+    ImageStore& store = ImageStore::shared();
+    const std::shared_ptr<ImageAsset>& asset = store.asset_for(image.path);
+    ImTextureID texture = store.texture_for(asset, max - min);
+    if (texture != ImTextureID())
+        draw_list->AddImage(texture, min, max);
+    else
+        image.render_placeholder(draw_list, min, canvas.zoom, asset->state() == ImageAsset::State::Failed);
+}
+
+void DrawElement(const CanvasPass& pass, ImDrawList* draw_list, const CanvasElement* element) {
+    const CanvasState& canvas = pass.canvas;
+    const RenderQuality& quality = pass.quality;
+    const ImVec2 canvas_origin = pass.origin;
+    if (pass.degraded && element != canvas.selected_element) {
+        ImVec2 min, max;
+        element->get_bounds(min, max);
+        ImVec2 smin = canvas_origin + canvas.pan + min * canvas.zoom;
+        ImVec2 smax = canvas_origin + canvas.pan + max * canvas.zoom;
+        if (auto text = dynamic_cast<const TextLabel*>(element)) {
+            // Greeking: мелкий текст заменяется полосой его цвета
+            if (smax.y - smin.y < quality.greek_below) {
+                ImVec4 c = text->color;
+                c.w *= 0.4f;
+                float mid = (smin.y + smax.y) * 0.5f;
+                float half = std::max((smax.y - smin.y) * 0.25f, 0.5f);
+                draw_list->AddRectFilled(ImVec2(smin.x, mid - half), ImVec2(smax.x, mid + half), ImColor(c));
+                return;
+            }
+        } else if (auto stroke = dynamic_cast<const Stroke*>(element)) {
+            if (std::max(smax.x - smin.x, smax.y - smin.y) < quality.stroke_dot_below) {
+                draw_list->AddRectFilled(smin, smax, ImColor(stroke->color));
+                return;
+            }
+        }
+    }
+    if (auto stroke = dynamic_cast<const Stroke*>(element))
+        DrawStroke(draw_list, *stroke, canvas_origin, canvas.pan, canvas.zoom);
+    else if (auto image = dynamic_cast<const ImageElement*>(element))
+        DrawImage(pass, draw_list, *image);
+    else
+        element->render(draw_list, canvas_origin, canvas.pan, canvas.zoom);
+
+    // Highlight selected element
+    if (element == canvas.selected_element) {
+        // Draw selection rectangle
+        if (auto text = dynamic_cast<const TextLabel*>(element)) {
+            ImVec2 screen_pos = canvas_origin + canvas.pan + text->position * canvas.zoom;
+            ImVec2 text_size = ImGui::CalcTextSize(text->text.c_str());
+            text_size.x *= canvas.zoom;
+            text_size.y *= canvas.zoom;
+
+            draw_list->AddRect(
+                screen_pos,
+                ImVec2(screen_pos.x + text_size.x, screen_pos.y + text_size.y),
+                IM_COL32(255, 255, 0, 255),
+                0.0f, 0, 2.0f
+            );
+        }
+    }
+}
+
+// Резервирует в dst место под геометрию src, не копируя её (копирование —
+// CopyMerged, параллельно). В пакетах только штрихи: белый пиксель атласа
+// шрифта и clip rect окна, поэтому команды src различаются лишь VtxOffset,
+// и геометрия ложится в текущую команду dst. Диапазон одного VtxOffset
+// адресуется 16-битными индексами; PrimReserve при переполнении dst
+// начинает новую команду
+void ReserveMerged(ImDrawList* dst, const ImDrawList& src, std::vector<MergeCopy>& copies) {
+    const int cmd_count = src.CmdBuffer.Size;
+    for (int c = 0; c < cmd_count;) {
+        const ImDrawCmd& first = src.CmdBuffer[c];
+        unsigned int idx_count = first.ElemCount;
+        int next = c + 1;
+        while (next < cmd_count && src.CmdBuffer[next].VtxOffset == first.VtxOffset)
+            idx_count += src.CmdBuffer[next++].ElemCount;
+        const unsigned int vtx_end =
+            next < cmd_count ? src.CmdBuffer[next].VtxOffset : static_cast<unsigned int>(src.VtxBuffer.Size);
+        c = next;
+        if (idx_count == 0 || vtx_end == first.VtxOffset)
+            continue;
+
+        MergeCopy copy;
+        copy.src = &src;
+        copy.src_vtx = first.VtxOffset;
+        copy.vtx_count = vtx_end - first.VtxOffset;
+        copy.src_idx = first.IdxOffset;
+        copy.idx_count = idx_count;
+        dst->PrimReserve(static_cast<int>(copy.idx_count), static_cast<int>(copy.vtx_count));
+        copy.dst_vtx = static_cast<size_t>(dst->_VtxWritePtr - dst->VtxBuffer.Data);
+        copy.dst_idx = static_cast<size_t>(dst->_IdxWritePtr - dst->IdxBuffer.Data);
+        copy.base = dst->_VtxCurrentIdx;
+        dst->_VtxWritePtr += copy.vtx_count;
+        dst->_IdxWritePtr += copy.idx_count;
+        dst->_VtxCurrentIdx += copy.vtx_count;
+        copies.push_back(copy);
+    }
+}
+
+void CopyMerged(ImDrawList* dst, const MergeCopy& copy) {
+    std::memcpy(dst->VtxBuffer.Data + copy.dst_vtx, copy.src->VtxBuffer.Data + copy.src_vtx,
+                copy.vtx_count * sizeof(ImDrawVert));
+    const ImDrawIdx* in = copy.src->IdxBuffer.Data + copy.src_idx;
+    ImDrawIdx* out = dst->IdxBuffer.Data + copy.dst_idx;
+    for (unsigned int i = 0; i < copy.idx_count; ++i)
+        out[i] = static_cast<ImDrawIdx>(in[i] + copy.base);
+}
+
+// Все элементы холста в draw_list по z-порядку. Штрихи вне clip rect
+// отбрасываются по bounding box. main_thread_elements = false пропускает
+// элементы, которым нужен UI-поток (бенчмарк рисует вне окна холста)
+void DrawCanvasElements(const CanvasPass& pass, ImDrawList* draw_list, unsigned max_threads,
+                        bool main_thread_elements, CanvasRenderStats& stats) {
+    CanvasBatches& b = Batches();
+    const CanvasState& canvas = pass.canvas;
+    stats = CanvasRenderStats();
+
+    b.visible.clear();
+    size_t total_cost = 0;
+    for (const auto& element : canvas.elements) {
+        if (!element->renders_off_main_thread()) {
+            if (main_thread_elements)
+                b.visible.push_back(element.get());
+            continue;
+        }
+        ImVec2 min, max;
+        if (element.get() != canvas.selected_element) {
+            if (!element->get_bounds(min, max)) {
+                stats.culled++;
+                continue;
+            }
+            ImVec2 smin = pass.origin + canvas.pan + min * canvas.zoom;
+            ImVec2 smax = pass.origin + canvas.pan + max * canvas.zoom;
+            if (smax.x < pass.clip_min.x || smax.y < pass.clip_min.y || smin.x > pass.clip_max.x ||
+                smin.y > pass.clip_max.y) {
+                stats.culled++;
+                continue;
+            }
+        }
+        b.visible.push_back(element.get());
+        auto stroke = dynamic_cast<const Stroke*>(element.get());
+        total_cost += kElementCost + (stroke ? stroke->point_count() : 0);
+    }
+    stats.visible = b.visible.size();
+
+    ThreadPool& pool = ThreadPool::shared();
+    unsigned threads = pool.size() + 1;
+    if (max_threads > 0)
+        threads = std::min(threads, max_threads);
+    auto start = Clock::now();
+    if (threads <= 1 || total_cost < kMinParallelCost) {
+        for (const CanvasElement* element : b.visible)
+            DrawElement(pass, draw_list, element);
+        stats.build_ms = MsSince(start);
+        return;
+    }
+
+    // Пакеты примерно равной стоимости из соседних штрихов; элемент UI-потока
+    // завершает пакет и рисуется между ними
+    const size_t target = std::max(kMinBatchCost, total_cost / (threads * kBatchesPerThread));
+    size_t count = 0;
+    auto open_batch = [&](size_t begin) {
+        if (b.batches.size() <= count)
+            b.batches.emplace_back();
+        RenderBatch& batch = b.batches[count++];
+        batch.begin = batch.end = begin;
+    };
+    size_t cost = 0;
+    bool open = false;
+    for (size_t i = 0; i < b.visible.size(); ++i) {
+        const CanvasElement* element = b.visible[i];
+        if (!element->renders_off_main_thread()) {
+            open = false;
+            continue;
+        }
+        if (!open || cost >= target) {
+            open_batch(i);
+            open = true;
+            cost = 0;
+        }
+        b.batches[count - 1].end = i + 1;
+        auto stroke = dynamic_cast<const Stroke*>(element);
+        cost += kElementCost + (stroke ? stroke->point_count() : 0);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        RenderBatch& batch = b.batches[i];
+        if (!batch.list)
+            batch.list = std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData());
+        batch.list->_ResetForNewFrame();
+        batch.stats.reset();
+    }
+
+    // Рабочие потоки пишут только в свой список и свои счётчики
+    pool.parallel_for(count, [&](size_t i) {
+        RenderBatch& batch = b.batches[i];
+        ScopedStrokeStats scope(batch.stats);
+        for (size_t e = batch.begin; e < batch.end; ++e)
+            DrawElement(pass, batch.list.get(), b.visible[e]);
+    }, threads);
+    stats.build_ms = MsSince(start);
+    stats.batches = count;
+    stats.threads = std::min<unsigned>(threads, static_cast<unsigned>(count));
+
+    // Сборка по z-порядку: место под пакеты резервируется последовательно
+    // (элементы UI-потока рисуются между ними сразу), копирование — на пуле
+    start = Clock::now();
+    size_t vtx_total = 0, idx_total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        vtx_total += static_cast<size_t>(b.batches[i].list->VtxBuffer.Size);
+        idx_total += static_cast<size_t>(b.batches[i].list->IdxBuffer.Size);
+    }
+    draw_list->VtxBuffer.reserve(draw_list->VtxBuffer.Size + static_cast<int>(vtx_total));
+    draw_list->IdxBuffer.reserve(draw_list->IdxBuffer.Size + static_cast<int>(idx_total));
+    b.copies.clear();
+    size_t next = 0;
+    for (size_t i = 0; i < b.visible.size();) {
+        if (next < count && b.batches[next].begin == i) {
+            const RenderBatch& batch = b.batches[next++];
+            ReserveMerged(draw_list, *batch.list, b.copies);
+            FrameStrokeStats() += batch.stats;
+            i = batch.end;
+            continue;
+        }
+        DrawElement(pass, draw_list, b.visible[i++]);
+    }
+    pool.parallel_for(b.copies.size(), [&](size_t i) { CopyMerged(draw_list, b.copies[i]); }, threads);
+    stats.merge_ms = MsSince(start);
+}
+
+} // namespace
+
+RenderQuality RenderQualityForLevel(int level) {
+    RenderQuality q;
+    if (level >= 1) {
+        q.stroke_lod_step = 2.0f;
+        q.greek_below = 6.0f;
+    }
+    if (level >= 2) {
+        q.stroke_lod_step = 4.0f;
+        q.stroke_dot_below = 3.0f;
+        q.greek_below = 10.0f;
+    }
+    return q;
+}
+
+const CanvasRenderStats& LastCanvasRenderStats() {
+    return Batches().stats;
+}
+
+void RenderCanvas(const CanvasState& canvas, const RenderQuality& quality) {
     // Setup a full-viewport invisible ImGui window for the canvas background and strokes
     ImGui::SetNextWindowPos(ImGui::GetMainViewport()->Pos);
     ImGui::SetNextWindowSize(ImGui::GetMainViewport()->Size);
@@ -29,29 +348,79 @@ void RenderCanvas(const CanvasState& canvas) {
     );
 
     // Render each element (strokes, text, etc.)
-    for (const auto& element : canvas.elements) {
-        element->render(draw_list, canvas_origin, canvas.pan, canvas.zoom);
-        
-        // Highlight selected element
-        if (element.get() == canvas.selected_element) {
-            // Draw selection rectangle
-            if (auto text = dynamic_cast<TextLabel*>(element.get())) {
-                ImVec2 screen_pos = canvas_origin + canvas.pan + text->position * canvas.zoom;
-                ImVec2 text_size = ImGui::CalcTextSize(text->text.c_str());
-                text_size.x *= canvas.zoom;
-                text_size.y *= canvas.zoom;
-                
-                draw_list->AddRect(
-                    screen_pos,
-                    ImVec2(screen_pos.x + text_size.x, screen_pos.y + text_size.y),
-                    IM_COL32(255, 255, 0, 255),
-                    0.0f, 0, 2.0f
-                );
-            }
-        }
-    }
+    FrameStrokeStats().reset();
+    FrameStrokeOptions().lod_step = quality.stroke_lod_step;
+    CanvasPass pass{canvas, quality, canvas_origin, draw_list->GetClipRectMin(), draw_list->GetClipRectMax(),
+                    quality.greek_below > 0.0f || quality.stroke_dot_below > 0.0f};
+    DrawCanvasElements(pass, draw_list, 0, true, Batches().stats);
 
     // Capture mouse interaction region over entire canvas
     ImGui::InvisibleButton("canvas_full", canvas_size, ImGuiButtonFlags_MouseButtonLeft);
     ImGui::End();
 }
+
+size_t CanvasBatchMemoryBytes() {
+    size_t bytes = 0;
+    for (const RenderBatch& batch : Batches().batches) {
+        if (!batch.list)
+            continue;
+        const ImDrawList& list = *batch.list;
+        bytes += sizeof(ImDrawList) + list.CmdBuffer.Capacity * sizeof(ImDrawCmd) +
+                 list.IdxBuffer.Capacity * sizeof(ImDrawIdx) + list.VtxBuffer.Capacity * sizeof(ImDrawVert);
+    }
+    return bytes;
+}
+
+RenderBenchmark RunRenderBenchmark(size_t strokes) {
+    // Рукописные штрихи по 48 точек на экране 1920x1080, упакованные, как
+    // завершённые штрихи документа
+    const ImVec2 view(1920.0f, 1080.0f);
+    CanvasState page;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> start_x(0.0f, view.x), start_y(0.0f, view.y), step(-3.0f, 3.0f);
+    for (size_t s = 0; s < strokes; ++s) {
+        auto stroke = std::make_unique<Stroke>();
+        ImVec2 p(start_x(rng), start_y(rng));
+        for (int i = 0; i < 48; ++i) {
+            stroke->add_point(p);
+            p.x += 2.0f + step(rng);
+            p.y += step(rng);
+        }
+        stroke->pack();
+        page.elements.push_back(std::move(stroke));
+    }
+
+    RenderBenchmark result;
+    result.strokes = strokes;
+    ImDrawList scratch(ImGui::GetDrawListSharedData());
+    const RenderQuality quality;
+    const float lod_step = FrameStrokeOptions().lod_step;
+    FrameStrokeOptions().lod_step = 0.0f;
+    CanvasPass pass{page, quality, ImVec2(0.0f, 0.0f), ImVec2(0.0f, 0.0f), view, false};
+
+    const unsigned max_threads = ThreadPool::shared().size() + 1;
+    for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+        RenderBenchmarkRun run;
+        run.threads = threads;
+        run.ms = 1e30;
+        // Первый проход прогревает буферы пакетов
+        for (int rep = 0; rep < 6; ++rep) {
+            StrokeTessStats tess;
+            ScopedStrokeStats scope(tess);
+            CanvasRenderStats stats;
+            scratch._ResetForNewFrame();
+            auto start = Clock::now();
+            DrawCanvasElements(pass, &scratch, threads, false, stats);
+            double ms = MsSince(start);
+            if (rep > 0)
+                run.ms = std::min(run.ms, ms);
+            run.batches = stats.batches;
+            result.vertices = tess.vertices;
+        }
+        result.runs.push_back(run);
+        if (threads >= max_threads)
+            break;
+    }
+    FrameStrokeOptions().lod_step = lod_step;
+    return result;
+}
@@ -1,4 +1,50 @@
 #pragma once
+#include <cstddef>
+#include <vector>
 #include "core/CanvasState.hpp"
 
-void RenderCanvas(const CanvasState& canvas);
+// Детализация отрисовки; снижается регулятором кадра при перегрузке
+struct RenderQuality {
+    float stroke_lod_step = 0.0f; // прореживание точек штриха (px), 0 — полное качество
+    float stroke_dot_below = 0.0f; // штрихи меньше этого (px) рисуются точкой
+    float greek_below = 0.0f;      // текст ниже этой высоты (px) рисуется полосой
+};
+
+RenderQuality RenderQualityForLevel(int level);
+
+// Отрисовка холста последнего кадра
+struct CanvasRenderStats {
+    size_t visible = 0;  // элементы в кадре
+    size_t culled = 0;   // штрихи вне окна, не рисовались
+    size_t batches = 0;  // пакеты, построенные параллельно; 0 — всё на UI-потоке
+    unsigned threads = 1;
+    double build_ms = 0.0; // построение геометрии (параллельная часть)
+    double merge_ms = 0.0; // сборка пакетов в draw list окна
+};
+
+const CanvasRenderStats& LastCanvasRenderStats();
+
+// Штрихи видимой части холста делятся на пакеты, которые строятся в
+// собственные ImDrawList на пуле потоков и затем по порядку копируются в
+// draw list окна холста. Элементы, которым нужен UI-поток (текст,
+// изображения), рисуются сразу в окно на своём месте по z-порядку
+void RenderCanvas(const CanvasState& canvas, const RenderQuality& quality = RenderQuality());
+
+// Память draw list'ов пакетов (переиспользуются между кадрами)
+size_t CanvasBatchMemoryBytes();
+
+struct RenderBenchmarkRun {
+    unsigned threads = 0;
+    size_t batches = 0;
+    double ms = 0.0; // лучшее время построения и сборки геометрии
+};
+
+struct RenderBenchmark {
+    size_t strokes = 0;
+    size_t vertices = 0; // за один проход
+    std::vector<RenderBenchmarkRun> runs;
+};
+
+// Построение геометрии синтетической плотной страницы (рукописные штрихи
+// на весь экран) на 1, 2, 4... потоках, до размера пула. Только UI-поток
+RenderBenchmark RunRenderBenchmark(size_t strokes = 20000);
@@ -0,0 +1,394 @@
+#include "render/ImageStore.hpp"
+#include "util/MemoryStats.hpp"
+#include "util/ThreadPool.hpp"
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// Levels above this size are not kept: a bound on single texture
+// allocations; deeper zoom magnifies the largest kept level.
+constexpr int kMaxTextureSize = 4096;
+// Stand-in level shown while the wanted one is missing
+constexpr int kPreviewSize = 128;
+// CPU copies nobody asked for during this many frames are dropped
+constexpr uint64_t kKeepFrames = 120;
+// Assets of image elements not drawn for this many frames are released
+constexpr uint64_t kHoldFrames = 600;
+// Upload granularity; the deadline is checked between strips
+constexpr size_t kStripBytes = 256 * 1024;
+// A single level may take at most this fraction of the GPU budget
+constexpr size_t kMaxLevelShare = 4;
+
+size_t level_bytes(int width, int height) {
+    return size_t(width) * size_t(height) * 4;
+}
+
+// Level whose texels are closest to screen pixels without being smaller
+// than them, and no larger than max_bytes (a share of the GPU budget)
+int target_level(int width, int height, int first_level, int levels, float screen_px, size_t max_bytes) {
+    const float side = static_cast<float>(std::max(width, height));
+    int level = 0;
+    if (screen_px > 0.0f && side > screen_px)
+        level = static_cast<int>(std::floor(std::log2(side / screen_px)));
+    level = std::clamp(level, first_level, levels - 1);
+    while (level + 1 < levels && level_bytes(std::max(1, width >> level), std::max(1, height >> level)) > max_bytes)
+        ++level;
+    return level;
+}
+
+} // namespace
+
+ImageAsset::~ImageAsset() {
+    std::vector<uint32_t> textures;
+    size_t bytes = 0;
+    for (const Level& level : levels) {
+        if (level.texture) {
+            textures.push_back(level.texture);
+            bytes += level_bytes(level.width, level.height);
+        }
+    }
+    if (!textures.empty()) ImageStore::shared().release_textures(textures, bytes);
+}
+
+ImageStore& ImageStore::shared() {
+    // Never destroyed: assets can outlive main (clipboard, pending decode jobs)
+    static ImageStore* store = new ImageStore();
+    return *store;
+}
+
+std::shared_ptr<ImageAsset> ImageStore::acquire(const std::string& path) {
+    std::shared_ptr<ImageAsset> asset;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::weak_ptr<ImageAsset>& slot = assets[path];
+        asset = slot.lock();
+        if (asset) return asset;
+        asset = std::make_shared<ImageAsset>(path);
+        slot = asset;
+    }
+    decode_async(asset);
+    return asset;
+}
+
+const std::shared_ptr<ImageAsset>& ImageStore::asset_for(const std::string& path) {
+    Held& entry = held[path];
+    if (!entry.asset) entry.asset = acquire(path);
+    entry.last_used = frame;
+    return entry.asset;
+}
+
+void ImageStore::decode_async(const std::shared_ptr<ImageAsset>& asset) {
+    decodes.fetch_add(1, std::memory_order_relaxed);
+    std::weak_ptr<ImageAsset> weak = asset;
+    const size_t max_level_bytes = gpu_budget / kMaxLevelShare;
+    ThreadPool::shared().submit([weak, max_level_bytes] {
+        std::shared_ptr<ImageAsset> asset = weak.lock();
+        if (!asset) return; // removed before its turn came
+
+        DecodedImage image;
+        std::string error;
+        if (!ReadPng(asset->file, image, &error)) {
+            std::lock_guard<std::mutex> lock(asset->mutex);
+            asset->failure = asset->file + ": " + error;
+            asset->has_decoded = true;
+            asset->status.store(static_cast<int>(ImageAsset::State::Failed), std::memory_order_release);
+            return;
+        }
+
+        // Full chain down to 1x1; each level is built from the previous one
+        std::vector<ImageAsset::Level> levels;
+        int first_level = 0, preview_level = 0;
+        int lw = image.width, lh = image.height;
+        levels.emplace_back();
+        levels[0].width = lw;
+        levels[0].height = lh;
+        levels[0].pixels = std::move(image.rgba);
+        while (lw > 1 || lh > 1) {
+            const ImageAsset::Level& prev = levels.back();
+            ImageAsset::Level next;
+            next.width = std::max(1, lw / 2);
+            next.height = std::max(1, lh / 2);
+            next.pixels.resize(level_bytes(next.width, next.height));
+            HalveImage(prev.pixels.data(), prev.width, prev.height, next.pixels.data(), next.width, next.height);
+            lw = next.width;
+            lh = next.height;
+            levels.push_back(std::move(next));
+        }
+        const int count = static_cast<int>(levels.size());
+        while (first_level + 1 < count && std::max(levels[first_level].width, levels[first_level].height) > kMaxTextureSize)
+            ++first_level;
+        preview_level = first_level;
+        while (preview_level + 1 < count &&
+               std::max(levels[preview_level].width, levels[preview_level].height) > kPreviewSize)
+            ++preview_level;
+
+        // Keep only what is about to be drawn: the level for the requested
+        // size and the preview; the rest is freed here, off the UI thread
+        const float want = asset->want_px.load(std::memory_order_relaxed);
+        const int target = want > 0.0f ? target_level(levels[0].width, levels[0].height, first_level, count, want,
+                                                       max_level_bytes)
+                                        : preview_level;
+        for (int k = 0; k < count; ++k) {
+            if (k != target && k != preview_level) levels[k].pixels = ImagePixels();
+        }
+
+        asset->w.store(levels[0].width, std::memory_order_release);
+        asset->h.store(levels[0].height, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(asset->mutex);
+        asset->decoded = std::move(levels);
+        asset->decoded_first_level = first_level;
+        asset->decoded_preview_level = preview_level;
+        asset->has_decoded = true;
+        asset->status.store(static_cast<int>(ImageAsset::State::Ready), std::memory_order_release);
+    });
+}
+
+void ImageStore::adopt(ImageAsset& asset) {
+    std::vector<ImageAsset::Level> decoded;
+    {
+        std::lock_guard<std::mutex> lock(asset.mutex);
+        if (!asset.has_decoded) return;
+        decoded.swap(asset.decoded);
+        asset.has_decoded = false;
+        if (asset.levels.empty()) {
+            asset.first_level = asset.decoded_first_level;
+            asset.preview_level = asset.decoded_preview_level;
+        }
+    }
+    asset.decode_queued = false;
+    // Kept levels were wanted when the decode finished; the stale trim starts counting now
+    for (ImageAsset::Level& level : decoded) {
+        if (!level.pixels.empty()) level.last_wanted = frame;
+    }
+    if (asset.levels.empty()) {
+        asset.levels = std::move(decoded);
+        return;
+    }
+    // Re-decode after eviction: refill only levels that lost their pixels
+    for (size_t k = 0; k < decoded.size() && k < asset.levels.size(); ++k) {
+        ImageAsset::Level& level = asset.levels[k];
+        if (!level.texture && level.pixels.empty() && !decoded[k].pixels.empty()) {
+            level.pixels = std::move(decoded[k].pixels);
+            level.last_wanted = frame;
+        }
+    }
+}
+
+std::vector<std::shared_ptr<ImageAsset>> ImageStore::live_assets() const {
+    std::vector<std::shared_ptr<ImageAsset>> live;
+    std::lock_guard<std::mutex> lock(mutex);
+    live.reserve(assets.size());
+    for (const auto& entry : assets) {
+        if (auto asset = entry.second.lock()) live.push_back(std::move(asset));
+    }
+    return live;
+}
+
+void ImageStore::begin_frame() {
+    ++frame;
+    uploaded_bytes = 0;
+    requests.clear();
+    requests_sorted = false;
+    // Before the lock: a released asset hands its textures back through release_textures
+    for (auto it = held.begin(); it != held.end();) {
+        if (frame - it->second.last_used > kHoldFrames) it = held.erase(it);
+        else ++it;
+    }
+
+    std::vector<uint32_t> dead;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dead.swap(released);
+        gpu_bytes -= std::min(gpu_bytes, released_bytes);
+        released_bytes = 0;
+        for (auto it = assets.begin(); it != assets.end();) {
+            if (it->second.expired()) it = assets.erase(it);
+            else ++it;
+        }
+    }
+    if (!dead.empty()) glDeleteTextures(static_cast<GLsizei>(dead.size()), dead.data());
+
+    // Destructors of assets released meanwhile run when `live` goes out of
+    // scope, outside the lock (they call release_textures)
+    std::vector<std::shared_ptr<ImageAsset>> live = live_assets();
+    for (const auto& asset : live) {
+        adopt(*asset);
+        for (int k = 0; k < static_cast<int>(asset->levels.size()); ++k) {
+            ImageAsset::Level& level = asset->levels[k];
+            if (!level.pixels.empty() && !level.texture && k != asset->preview_level &&
+                frame - level.last_wanted > kKeepFrames)
+                level.pixels = ImagePixels();
+        }
+    }
+    MemSetMeasured(MemCategory::Textures, gpu_bytes);
+}
+
+void ImageStore::request(const std::shared_ptr<ImageAsset>& asset, int index) {
+    ImageAsset::Level& level = asset->levels[index];
+    if (level.last_wanted == frame) return; // already handled this frame
+    level.last_wanted = frame;
+    if (level.resident()) return;
+    if (!level.pixels.empty()) {
+        requests.push_back({asset, index});
+        requests_sorted = false;
+    } else if (!level.texture && !asset->decode_queued) {
+        // Pixels were dropped after an earlier upload and the texture evicted since
+        asset->decode_queued = true;
+        decode_async(asset);
+    }
+}
+
+ImTextureID ImageStore::texture_for(const std::shared_ptr<ImageAsset>& asset, const ImVec2& screen_size) {
+    const float px = std::max(screen_size.x, screen_size.y);
+    asset->want_px.store(px, std::memory_order_relaxed);
+    if (asset->levels.empty()) return ImTextureID();
+
+    const int count = static_cast<int>(asset->levels.size());
+    const int target = target_level(asset->levels[0].width, asset->levels[0].height, asset->first_level, count, px,
+                                    gpu_budget / kMaxLevelShare);
+    request(asset, asset->preview_level);
+    request(asset, target);
+    asset->levels[asset->preview_level].last_used = frame;
+
+    // Wanted level, else the nearest coarser one, else the nearest finer one
+    int use = -1;
+    for (int k = target; k < count && use < 0; ++k) {
+        if (asset->levels[k].resident()) use = k;
+    }
+    for (int k = target - 1; k >= asset->first_level && use < 0; --k) {
+        if (asset->levels[k].resident()) use = k;
+    }
+    if (use < 0) return ImTextureID();
+    ImageAsset::Level& level = asset->levels[use];
+    level.last_used = frame;
+    return (ImTextureID)(intptr_t)level.texture;
+}
+
+void ImageStore::free_texture(ImageAsset::Level& level) {
+    glDeleteTextures(1, &level.texture);
+    gpu_bytes -= std::min(gpu_bytes, level_bytes(level.width, level.height));
+    level.texture = 0;
+    level.uploaded_rows = 0;
+}
+
+bool ImageStore::make_room(size_t bytes, bool for_preview) {
+    if (bytes > gpu_budget) return false;
+    if (gpu_bytes + bytes <= gpu_budget) return true;
+
+    // Least recently drawn first. Levels drawn this frame are kept, except
+    // that a missing preview may displace other images' finer levels:
+    // every visible image should show at least its preview
+    struct Candidate {
+        uint64_t last_used;
+        ImageAsset::Level* level;
+    };
+    std::vector<std::shared_ptr<ImageAsset>> live = live_assets();
+    std::vector<Candidate> candidates;
+    for (const auto& asset : live) {
+        for (int k = 0; k < static_cast<int>(asset->levels.size()); ++k) {
+            ImageAsset::Level& level = asset->levels[k];
+            if (!level.texture) continue;
+            if (level.last_used < frame || (for_preview && k != asset->preview_level))
+                candidates.push_back({level.last_used, &level});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.last_used < b.last_used; });
+    for (const Candidate& c : candidates) {
+        if (gpu_bytes + bytes <= gpu_budget) break;
+        free_texture(*c.level);
+        ++evicted_levels;
+    }
+    return gpu_bytes + bytes <= gpu_budget;
+}
+
+bool ImageStore::upload(Clock::time_point deadline) {
+    if (!requests_sorted) {
+        // Previews first (cheap, replace placeholders), then smallest levels
+        std::stable_sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+            const bool ap = a.level == a.asset->preview_level, bp = b.level == b.asset->preview_level;
+            if (ap != bp) return ap;
+            const ImageAsset::Level& la = a.asset->levels[a.level];
+            const ImageAsset::Level& lb = b.asset->levels[b.level];
+            return level_bytes(la.width, la.height) < level_bytes(lb.width, lb.height);
+        });
+        requests_sorted = true;
+    }
+
+    GLint previous = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t done = 0;
+    bool finished = true;
+    for (; done < requests.size(); ++done) {
+        ImageAsset::Level& level = requests[done].asset->levels[requests[done].level];
+        if (level.resident() || level.pixels.empty()) continue;
+        if (!level.texture) {
+            // Does not fit even after eviction: skipped this frame, a coarser level stands in
+            const bool preview = requests[done].level == requests[done].asset->preview_level;
+            if (!make_room(level_bytes(level.width, level.height), preview)) continue;
+            glGenTextures(1, &level.texture);
+            glBindTexture(GL_TEXTURE_2D, level.texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            gpu_bytes += level_bytes(level.width, level.height);
+            level.uploaded_rows = 0;
+        } else {
+            glBindTexture(GL_TEXTURE_2D, level.texture);
+        }
+
+        const size_t row_bytes = size_t(level.width) * 4;
+        const int strip = static_cast<int>(std::max<size_t>(1, kStripBytes / row_bytes));
+        while (level.uploaded_rows < level.height) {
+            if (Clock::now() >= deadline) break;
+            const int rows = std::min(strip, level.height - level.uploaded_rows);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, level.uploaded_rows, level.width, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+                            level.pixels.data() + size_t(level.uploaded_rows) * row_bytes);
+            level.uploaded_rows += rows;
+            uploaded_bytes += size_t(rows) * row_bytes;
+        }
+        if (level.uploaded_rows < level.height) {
+            finished = false;
+            break;
+        }
+        // Resident now; the CPU copy is decoded again if the texture is ever evicted
+        level.pixels = ImagePixels();
+        level.last_used = frame;
+    }
+    requests.erase(requests.begin(), requests.begin() + static_cast<std::ptrdiff_t>(done));
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous));
+    MemSetMeasured(MemCategory::Textures, gpu_bytes);
+    return finished;
+}
+
+void ImageStore::release_textures(const std::vector<uint32_t>& textures, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    released.insert(released.end(), textures.begin(), textures.end());
+    released_bytes += bytes;
+}
+
+ImageStoreStats ImageStore::stats() const {
+    ImageStoreStats s;
+    std::vector<std::shared_ptr<ImageAsset>> live = live_assets();
+    s.images = live.size();
+    for (const auto& asset : live) {
+        ImageAsset::State state = asset->state();
+        if (state == ImageAsset::State::Failed) s.failed++;
+        else if (asset->decode_queued) s.decoding++;
+        for (const ImageAsset::Level& level : asset->levels) s.resident_levels += level.resident() ? 1 : 0;
+    }
+    s.decodes = decodes.load(std::memory_order_relaxed);
+    s.gpu_bytes = gpu_bytes;
+    s.gpu_budget = gpu_budget;
+    s.uploaded_bytes = uploaded_bytes;
+    s.evicted_levels = evicted_levels;
+    s.pending_uploads = requests.size();
+    return s;
+}
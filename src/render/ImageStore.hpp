@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <imgui.h>
+#include "import/PngReader.hpp"
+
+// Image file shared by every element that shows it. Decoded on the thread
+// pool into a mip chain; each level becomes its own texture on demand.
+class ImageAsset {
+public:
+    enum class State : int { Decoding, Ready, Failed };
+
+    explicit ImageAsset(std::string path) : file(std::move(path)) {}
+    ~ImageAsset();
+
+    const std::string& path() const { return file; }
+    State state() const { return static_cast<State>(status.load(std::memory_order_acquire)); }
+    // Full-resolution size, 0 until the first decode finished
+    int width() const { return w.load(std::memory_order_acquire); }
+    int height() const { return h.load(std::memory_order_acquire); }
+    // Valid once state() is Failed
+    const std::string& error() const { return failure; }
+
+private:
+    friend class ImageStore;
+
+    struct Level {
+        int width = 0;
+        int height = 0;
+        ImagePixels pixels;     // CPU copy until the texture is complete
+        uint32_t texture = 0;   // GL texture name, 0 = not resident
+        int uploaded_rows = 0;  // texture is usable once all rows are in
+        uint64_t last_used = 0; // frame the texture was last drawn
+        uint64_t last_wanted = 0;
+
+        bool resident() const { return texture != 0 && uploaded_rows == height; }
+    };
+
+    std::string file;
+    std::atomic<int> status{static_cast<int>(State::Decoding)};
+    std::atomic<int> w{0}, h{0};
+    std::string failure;
+    // Largest on-screen size requested, read by the decoder to decide which levels to keep
+    std::atomic<float> want_px{0.0f};
+
+    // Main thread only
+    std::vector<Level> levels; // 0 = full resolution
+    int first_level = 0;       // finer levels exceed the texture size limit
+    int preview_level = 0;     // small level kept resident as a stand-in
+    bool decode_queued = true;
+
+    // Handoff from the decoding worker
+    std::mutex mutex;
+    std::vector<Level> decoded;
+    int decoded_first_level = 0;
+    int decoded_preview_level = 0;
+    bool has_decoded = false;
+};
+
+struct ImageStoreStats {
+    size_t images = 0;
+    size_t decoding = 0;
+    size_t failed = 0;
+    size_t decodes = 0;          // total decode jobs, re-decodes after eviction included
+    size_t gpu_bytes = 0;
+    size_t gpu_budget = 0;
+    size_t resident_levels = 0;
+    size_t uploaded_bytes = 0;   // during the last frame
+    size_t evicted_levels = 0;   // total
+    size_t pending_uploads = 0;
+};
+
+// Decoding, mip selection and texture residency for image elements.
+//  - acquire() starts decoding on the thread pool, the UI thread never decodes.
+//  - asset_for() is acquire() for image elements, which hold only the file
+//    path: the asset stays alive while the element is drawn.
+//  - texture_for() picks the level matching the on-screen size and falls back
+//    to whatever level is resident; the wanted level is queued for upload
+//    (or re-decoded if its pixels were dropped).
+//  - upload() streams queued levels in row strips until a deadline, as a
+//    FrameScheduler job, and evicts least recently drawn levels to stay
+//    within the GPU budget.
+// Everything except acquire() runs on the main thread with the GL context current.
+class ImageStore {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static ImageStore& shared();
+
+    std::shared_ptr<ImageAsset> acquire(const std::string& path);
+    // Asset of an image element being drawn; released once no element
+    // asked for it during kHoldFrames frames. Main thread only.
+    const std::shared_ptr<ImageAsset>& asset_for(const std::string& path);
+
+    void set_gpu_budget(size_t bytes) { gpu_budget = bytes; }
+
+    // Once per frame before rendering: adopts finished decodes, frees
+    // released textures and stale CPU copies.
+    void begin_frame();
+
+    // Texture showing `asset` at `screen_size` pixels, or a null ImTextureID
+    // while nothing usable is resident (draw a placeholder then).
+    ImTextureID texture_for(const std::shared_ptr<ImageAsset>& asset, const ImVec2& screen_size);
+
+    bool has_pending_uploads() const { return !requests.empty(); }
+    // Returns true once every queued level is uploaded (or cannot fit).
+    bool upload(Clock::time_point deadline);
+
+    ImageStoreStats stats() const;
+
+    // Called from ~ImageAsset on any thread; textures are deleted on the next begin_frame().
+    void release_textures(const std::vector<uint32_t>& textures, size_t bytes);
+
+private:
+    struct Request {
+        std::shared_ptr<ImageAsset> asset;
+        int level;
+    };
+
+    struct Held {
+        std::shared_ptr<ImageAsset> asset;
+        uint64_t last_used = 0;
+    };
+
+    void decode_async(const std::shared_ptr<ImageAsset>& asset);
+    void adopt(ImageAsset& asset);
+    void request(const std::shared_ptr<ImageAsset>& asset, int level);
+    bool make_room(size_t bytes, bool for_preview);
+    void free_texture(ImageAsset::Level& level);
+    std::vector<std::shared_ptr<ImageAsset>> live_assets() const;
+
+    mutable std::mutex mutex; // assets and released
+    std::unordered_map<std::string, std::weak_ptr<ImageAsset>> assets;
+    std::vector<uint32_t> released;
+    size_t released_bytes = 0;
+    std::atomic<size_t> decodes{0};
+
+    // Main thread only
+    uint64_t frame = 0;
+    std::unordered_map<std::string, Held> held;
+    std::vector<Request> requests;
+    bool requests_sorted = false;
+    size_t gpu_bytes = 0;
+    size_t gpu_budget = size_t(512) << 20;
+    size_t uploaded_bytes = 0;
+    size_t evicted_levels = 0;
+};
@@ -0,0 +1,412 @@
+#include "render/SoftwareRasterizer.hpp"
+#include "core/CanvasElement.hpp"
+#include "util/ThreadPool.hpp"
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+struct Tile {
+    int x0, y0, width, height; // in image pixels
+    uint8_t* rgba;
+    size_t stride;
+};
+
+uint8_t to_byte(float v) {
+    return static_cast<uint8_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Source-over blend of a straight-alpha color with coverage a (0..1)
+inline void blend(uint8_t* px, const ImVec4& color, float a) {
+    if (a <= 0.0f) return;
+    float inv = 1.0f - a;
+    px[0] = static_cast<uint8_t>(color.x * 255.0f * a + px[0] * inv + 0.5f);
+    px[1] = static_cast<uint8_t>(color.y * 255.0f * a + px[1] * inv + 0.5f);
+    px[2] = static_cast<uint8_t>(color.z * 255.0f * a + px[2] * inv + 0.5f);
+    px[3] = static_cast<uint8_t>(255.0f * a + px[3] * inv + 0.5f);
+}
+
+float segment_distance(float px, float py, const ImVec2& a, const ImVec2& b) {
+    float abx = b.x - a.x, aby = b.y - a.y;
+    float apx = px - a.x, apy = py - a.y;
+    float len2 = abx * abx + aby * aby;
+    float t = len2 > 0.0f ? std::clamp((apx * abx + apy * aby) / len2, 0.0f, 1.0f) : 0.0f;
+    float dx = apx - abx * t, dy = apy - aby * t;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Anti-aliased capsule coverage accumulated per stroke (max over segments),
+// then composited once so overlapping segments do not darken the joints.
+void raster_stroke(const Stroke& stroke, const RasterView& view, const Tile& tile) {
+    if (stroke.point_count() < 2) return;
+
+    const float width_px = stroke.thickness * view.scale;
+    const float radius = std::max(width_px * 0.5f, 0.5f);
+    const float alpha = stroke.color.w * std::min(width_px, 1.0f); // hairlines fade instead of thinning
+
+    // Stroke bounding box in tile pixels, clipped to the tile: coverage is
+    // cleared and accumulated only there, so the cost follows the stroke size
+    const ImVec2 to_tile = (ImVec2(0.0f, 0.0f) - view.world_min) * view.scale - ImVec2(float(tile.x0), float(tile.y0));
+    const ImVec2 smin = to_tile + stroke.bounds_min * view.scale;
+    const ImVec2 smax = to_tile + stroke.bounds_max * view.scale;
+    const int bx0 = std::max(0, static_cast<int>(std::floor(smin.x - radius - 1.0f)));
+    const int by0 = std::max(0, static_cast<int>(std::floor(smin.y - radius - 1.0f)));
+    const int bx1 = std::min(tile.width - 1, static_cast<int>(std::ceil(smax.x + radius + 1.0f)));
+    const int by1 = std::min(tile.height - 1, static_cast<int>(std::ceil(smax.y + radius + 1.0f)));
+    if (bx0 > bx1 || by0 > by1) return;
+    const size_t box_width = size_t(bx1 - bx0 + 1);
+
+    // Tile-local pixel coordinates, decoded in one pass
+    thread_local std::vector<ImVec2> pts;
+    stroke.decode_points(pts, to_tile, view.scale);
+
+    thread_local std::vector<float> coverage;
+    coverage.assign(box_width * size_t(by1 - by0 + 1), 0.0f);
+
+    int cov_x0 = bx1 + 1, cov_y0 = by1 + 1, cov_x1 = -1, cov_y1 = -1;
+
+    ImVec2 prev = pts[0];
+    for (size_t i = 1; i < pts.size(); ++i) {
+        const ImVec2 cur = pts[i];
+        int x0 = std::max(bx0, static_cast<int>(std::floor(std::min(prev.x, cur.x) - radius - 1.0f)));
+        int y0 = std::max(by0, static_cast<int>(std::floor(std::min(prev.y, cur.y) - radius - 1.0f)));
+        int x1 = std::min(bx1, static_cast<int>(std::ceil(std::max(prev.x, cur.x) + radius + 1.0f)));
+        int y1 = std::min(by1, static_cast<int>(std::ceil(std::max(prev.y, cur.y) + radius + 1.0f)));
+        if (x0 <= x1 && y0 <= y1) {
+            cov_x0 = std::min(cov_x0, x0);
+            cov_y0 = std::min(cov_y0, y0);
+            cov_x1 = std::max(cov_x1, x1);
+            cov_y1 = std::max(cov_y1, y1);
+            for (int y = y0; y <= y1; ++y) {
+                float* row = coverage.data() + size_t(y - by0) * box_width;
+                for (int x = x0; x <= x1; ++x) {
+                    float d = segment_distance(x + 0.5f, y + 0.5f, prev, cur);
+                    float c = radius + 0.5f - d;
+                    if (c > row[x - bx0]) row[x - bx0] = std::min(c, 1.0f);
+                }
+            }
+        }
+        prev = cur;
+    }
+
+    for (int y = cov_y0; y <= cov_y1; ++y) {
+        const float* row = coverage.data() + size_t(y - by0) * box_width;
+        uint8_t* px = tile.rgba + size_t(y) * tile.stride + size_t(cov_x0) * 4;
+        for (int x = cov_x0; x <= cov_x1; ++x, px += 4) {
+            blend(px, stroke.color, row[x - bx0] * alpha);
+        }
+    }
+}
+
+// Decodes one UTF-8 sequence, returns the number of bytes consumed.
+int decode_utf8(const char* s, const char* end, unsigned int& out) {
+    unsigned char c = static_cast<unsigned char>(s[0]);
+    int len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 1;
+    if (s + len > end) len = 1;
+    if (len == 1) {
+        out = c < 0x80 ? c : 0xFFFD;
+        return 1;
+    }
+    out = c & (0x7F >> len);
+    for (int i = 1; i < len; ++i) out = (out << 6) | (static_cast<unsigned char>(s[i]) & 0x3F);
+    return len;
+}
+
+float sample_alpha(const RasterFont::Data& font, float u, float v) {
+    float fx = u * font.width - 0.5f;
+    float fy = v * font.height - 0.5f;
+    int x0 = static_cast<int>(std::floor(fx));
+    int y0 = static_cast<int>(std::floor(fy));
+    float tx = fx - x0, ty = fy - y0;
+    auto at = [&](int x, int y) -> float {
+        x = std::clamp(x, 0, font.width - 1);
+        y = std::clamp(y, 0, font.height - 1);
+        return font.alpha[size_t(y) * size_t(font.width) + size_t(x)];
+    };
+    float top = at(x0, y0) + (at(x0 + 1, y0) - at(x0, y0)) * tx;
+    float bottom = at(x0, y0 + 1) + (at(x0 + 1, y0 + 1) - at(x0, y0 + 1)) * tx;
+    return (top + (bottom - top) * ty) * (1.0f / 255.0f);
+}
+
+// Same layout as ImGui::Text: glyph quads from the font atlas, one line per '\n'.
+void raster_text(const TextLabel& label, const RasterFont& font, const RasterView& view, const Tile& tile) {
+    if (!font.valid()) return;
+
+    const float s = view.scale;
+    const ImVec2 origin = (label.position - view.world_min) * s - ImVec2(float(tile.x0), float(tile.y0));
+    float pen_x = origin.x;
+    float pen_y = origin.y;
+
+    const char* p = label.text.c_str();
+    const char* end = p + label.text.size();
+    while (p < end) {
+        unsigned int c = 0;
+        p += decode_utf8(p, end, c);
+        if (c == '\n') {
+            pen_x = origin.x;
+            pen_y += font.size() * s;
+            continue;
+        }
+        const RasterGlyph* g = font.find(c);
+        if (!g) continue;
+
+        float gx0 = pen_x + g->x0 * s, gy0 = pen_y + g->y0 * s;
+        float gx1 = pen_x + g->x1 * s, gy1 = pen_y + g->y1 * s;
+        pen_x += g->advance * s;
+        if (gx1 <= gx0 || gy1 <= gy0) continue;
+
+        int x0 = std::max(0, static_cast<int>(std::floor(gx0)));
+        int y0 = std::max(0, static_cast<int>(std::floor(gy0)));
+        int x1 = std::min(tile.width - 1, static_cast<int>(std::ceil(gx1)));
+        int y1 = std::min(tile.height - 1, static_cast<int>(std::ceil(gy1)));
+        for (int y = y0; y <= y1; ++y) {
+            float py = y + 0.5f;
+            if (py < gy0 || py > gy1) continue;
+            float v = g->v0 + (py - gy0) / (gy1 - gy0) * (g->v1 - g->v0);
+            uint8_t* px = tile.rgba + size_t(y) * tile.stride + size_t(x0) * 4;
+            for (int x = x0; x <= x1; ++x, px += 4) {
+                float fx = x + 0.5f;
+                if (fx < gx0 || fx > gx1) continue;
+                float u = g->u0 + (fx - gx0) / (gx1 - gx0) * (g->u1 - g->u0);
+                blend(px, label.color, sample_alpha(*font.data, u, v) * label.color.w);
+            }
+        }
+    }
+}
+
+// Bilinear sample at texel coordinates (x, y), weighted by alpha so that
+// transparent texels do not bleed their color into the edges
+ImVec4 sample_image(const RasterImage& image, float x, float y) {
+    int x0 = static_cast<int>(std::floor(x));
+    int y0 = static_cast<int>(std::floor(y));
+    float tx = x - x0, ty = y - y0;
+    ImVec4 sum(0.0f, 0.0f, 0.0f, 0.0f);
+    auto add = [&](int sx, int sy, float w) {
+        sx = std::clamp(sx, 0, image.width - 1);
+        sy = std::clamp(sy, 0, image.height - 1);
+        const uint8_t* p = image.rgba.data() + (size_t(sy) * size_t(image.width) + size_t(sx)) * 4;
+        const float a = p[3] * w;
+        sum.x += p[0] * a;
+        sum.y += p[1] * a;
+        sum.z += p[2] * a;
+        sum.w += a;
+    };
+    add(x0, y0, (1.0f - tx) * (1.0f - ty));
+    add(x0 + 1, y0, tx * (1.0f - ty));
+    add(x0, y0 + 1, (1.0f - tx) * ty);
+    add(x0 + 1, y0 + 1, tx * ty);
+    if (sum.w <= 0.0f) return ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
+    const float k = 1.0f / (sum.w * 255.0f);
+    return ImVec4(sum.x * k, sum.y * k, sum.z * k, sum.w * (1.0f / 255.0f));
+}
+
+// The decoded image scaled to its rectangle, or the placeholder the canvas
+// shows in its place (frame, and a red cross if the file could not be read)
+void raster_image(const ImageElement& element, const RasterImage* image, bool failed, const RasterView& view,
+                  const Tile& tile) {
+    const ImVec2 rmin = (element.position - view.world_min) * view.scale - ImVec2(float(tile.x0), float(tile.y0));
+    const ImVec2 rmax = rmin + element.display_size() * view.scale;
+    const int x0 = std::max(0, static_cast<int>(std::floor(rmin.x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(rmin.y)));
+    const int x1 = std::min(tile.width - 1, static_cast<int>(std::ceil(rmax.x)));
+    const int y1 = std::min(tile.height - 1, static_cast<int>(std::ceil(rmax.y)));
+    if (x0 > x1 || y0 > y1 || rmax.x <= rmin.x || rmax.y <= rmin.y) return;
+
+    const ImVec4 fill(60 / 255.0f, 60 / 255.0f, 70 / 255.0f, 1.0f);
+    const ImVec4 frame(110 / 255.0f, 110 / 255.0f, 125 / 255.0f, 1.0f);
+    const ImVec4 cross(200 / 255.0f, 70 / 255.0f, 70 / 255.0f, 1.0f);
+    const float half_line = std::max(view.scale, 0.5f); // 2 canvas units wide, as on screen
+    const ImVec2 texel_scale = image ? ImVec2(image->width / (rmax.x - rmin.x), image->height / (rmax.y - rmin.y))
+                                     : ImVec2(0.0f, 0.0f);
+    for (int y = y0; y <= y1; ++y) {
+        const float py = y + 0.5f;
+        if (py < rmin.y || py >= rmax.y) continue;
+        uint8_t* px = tile.rgba + size_t(y) * tile.stride + size_t(x0) * 4;
+        for (int x = x0; x <= x1; ++x, px += 4) {
+            const float fx = x + 0.5f;
+            if (fx < rmin.x || fx >= rmax.x) continue;
+            if (image) {
+                const ImVec4 s = sample_image(*image, (fx - rmin.x) * texel_scale.x - 0.5f,
+                                              (py - rmin.y) * texel_scale.y - 0.5f);
+                blend(px, s, s.w);
+                continue;
+            }
+            const bool edge = fx - rmin.x < 1.0f || rmax.x - fx < 1.0f || py - rmin.y < 1.0f || rmax.y - py < 1.0f;
+            blend(px, edge ? frame : fill, 1.0f);
+            if (failed) {
+                const float d = std::min(segment_distance(fx, py, rmin, rmax),
+                                         segment_distance(fx, py, ImVec2(rmin.x, rmax.y), ImVec2(rmax.x, rmin.y)));
+                blend(px, cross, std::clamp(half_line + 0.5f - d, 0.0f, 1.0f));
+            }
+        }
+    }
+}
+
+// Smallest level of the halving chain that is still at least target_w x target_h;
+// levels are built on demand and shared by the items that use them
+std::shared_ptr<const RasterImage> reduce_image(std::vector<std::shared_ptr<RasterImage>>& chain, int target_w,
+                                                int target_h) {
+    size_t level = 0;
+    for (;;) {
+        const RasterImage& cur = *chain[level];
+        const int hw = std::max(1, cur.width / 2), hh = std::max(1, cur.height / 2);
+        if ((hw == cur.width && hh == cur.height) || hw < target_w || hh < target_h) break;
+        if (level + 1 == chain.size()) {
+            auto next = std::make_shared<RasterImage>();
+            next->width = hw;
+            next->height = hh;
+            next->rgba.resize(size_t(hw) * size_t(hh) * 4);
+            HalveImage(cur.rgba.data(), cur.width, cur.height, next->rgba.data(), hw, hh);
+            chain.push_back(std::move(next));
+        }
+        ++level;
+    }
+    return chain[level];
+}
+
+} // namespace
+
+const RasterGlyph* RasterFont::find(unsigned int c) const {
+    if (!data) return nullptr;
+    int index = c < data->lookup.size() ? data->lookup[c] : -1;
+    if (index < 0) index = data->fallback;
+    return index >= 0 ? &data->glyphs[size_t(index)] : nullptr;
+}
+
+ImVec2 RasterFont::text_size(const std::string& text) const {
+    // Line breaks as in ImGui::CalcTextSize: a trailing '\n' adds no line, '\r' is skipped
+    const float line_height = size();
+    ImVec2 out(0.0f, 0.0f);
+    float line_width = 0.0f;
+    const char* p = text.c_str();
+    const char* end = p + text.size();
+    while (p < end) {
+        unsigned int c = 0;
+        p += decode_utf8(p, end, c);
+        if (c == '\n') {
+            out.x = std::max(out.x, line_width);
+            out.y += line_height;
+            line_width = 0.0f;
+            continue;
+        }
+        if (c == '\r') continue;
+        if (const RasterGlyph* g = find(c)) line_width += g->advance;
+    }
+    out.x = std::max(out.x, line_width);
+    if (line_width > 0.0f || out.y == 0.0f) out.y += line_height;
+    return out;
+}
+
+RasterFont CaptureRasterFont() {
+    auto data = std::make_shared<RasterFont::Data>();
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels = nullptr;
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &data->width, &data->height);
+    ImFont* font = ImGui::GetFont();
+    if (pixels && font) {
+        data->alpha.assign(pixels, pixels + size_t(data->width) * size_t(data->height));
+        data->size = font->FontSize;
+        data->glyphs.reserve(size_t(font->Glyphs.Size));
+        for (const ImFontGlyph& g : font->Glyphs) {
+            const unsigned int c = g.Codepoint;
+            if (c >= data->lookup.size()) data->lookup.resize(c + 1, -1);
+            data->lookup[c] = static_cast<int>(data->glyphs.size());
+            data->glyphs.push_back({g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1, g.AdvanceX});
+        }
+        const unsigned int fallback = font->FallbackChar;
+        if (fallback < data->lookup.size()) data->fallback = data->lookup[fallback];
+    }
+    RasterFont out;
+    out.data = std::move(data);
+    return out;
+}
+
+bool RasterBounds(const CanvasElement& element, const RasterFont& font, ImVec2& min, ImVec2& max) {
+    if (auto text = dynamic_cast<const TextLabel*>(&element)) {
+        min = text->position;
+        max = text->position + font.text_size(text->text);
+        return true;
+    }
+    return element.get_bounds(min, max);
+}
+
+std::vector<RasterItem> CollectRasterItems(const CanvasState& canvas, const RasterFont& font) {
+    std::vector<RasterItem> items;
+    items.reserve(canvas.elements.size());
+    for (const auto& el : canvas.elements) {
+        RasterItem item;
+        item.element = el.get();
+        if (RasterBounds(*el, font, item.min, item.max)) items.push_back(item);
+    }
+    return items;
+}
+
+size_t LoadRasterImages(std::vector<RasterItem>& items, float scale) {
+    std::unordered_map<std::string, std::vector<RasterItem*>> by_file;
+    size_t count = 0;
+    for (RasterItem& item : items) {
+        if (auto image = dynamic_cast<const ImageElement*>(item.element)) {
+            by_file[image->path].push_back(&item);
+            count++;
+        }
+    }
+    if (by_file.empty()) return 0;
+
+    std::vector<std::pair<const std::string*, std::vector<RasterItem*>*>> files;
+    files.reserve(by_file.size());
+    for (auto& [path, file_items] : by_file) files.emplace_back(&path, &file_items);
+    ThreadPool::shared().parallel_for(files.size(), [&](size_t i) {
+        const std::vector<RasterItem*>& file_items = *files[i].second;
+        DecodedImage decoded;
+        if (!ReadPng(*files[i].first, decoded)) {
+            for (RasterItem* item : file_items) item->image_failed = true;
+            return;
+        }
+        std::vector<std::shared_ptr<RasterImage>> chain(1, std::make_shared<RasterImage>());
+        chain[0]->width = decoded.width;
+        chain[0]->height = decoded.height;
+        chain[0]->rgba = std::move(decoded.rgba);
+        for (RasterItem* item : file_items) {
+            const ImVec2 size = static_cast<const ImageElement*>(item->element)->display_size() * scale;
+            item->image = reduce_image(chain, static_cast<int>(std::ceil(size.x)), static_cast<int>(std::ceil(size.y)));
+        }
+    });
+    return count;
+}
+
+void RasterizeTile(const std::vector<RasterItem>& items, const RasterFont& font, const RasterView& view,
+                   const ImVec4& background, int tile_x, int tile_y, int width, int height,
+                   uint8_t* rgba, size_t stride) {
+    const uint8_t bg[4] = {to_byte(background.x), to_byte(background.y), to_byte(background.z), to_byte(background.w)};
+    for (int y = 0; y < height; ++y) {
+        uint8_t* px = rgba + size_t(y) * stride;
+        for (int x = 0; x < width; ++x, px += 4) {
+            px[0] = bg[0];
+            px[1] = bg[1];
+            px[2] = bg[2];
+            px[3] = bg[3];
+        }
+    }
+
+    // Tile rectangle in canvas space for culling
+    const ImVec2 tile_min = view.world_min + ImVec2(float(tile_x), float(tile_y)) / view.scale;
+    const ImVec2 tile_max = view.world_min + ImVec2(float(tile_x + width), float(tile_y + height)) / view.scale;
+    const Tile tile{tile_x, tile_y, width, height, rgba, stride};
+
+    for (const RasterItem& item : items) {
+        if (item.max.x < tile_min.x || item.min.x > tile_max.x ||
+            item.max.y < tile_min.y || item.min.y > tile_max.y)
+            continue;
+
+        if (auto stroke = dynamic_cast<const Stroke*>(item.element)) {
+            raster_stroke(*stroke, view, tile);
+        } else if (auto text = dynamic_cast<const TextLabel*>(item.element)) {
+            raster_text(*text, font, view, tile);
+        } else if (auto image = dynamic_cast<const ImageElement*>(item.element)) {
+            raster_image(*image, item.image.get(), item.image_failed, view, tile);
+        }
+    }
+}
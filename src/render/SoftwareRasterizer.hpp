@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <imgui.h>
+#include "core/CanvasState.hpp"
+#include "import/PngReader.hpp"
+
+// CPU rasterizer used for headless export. It does not touch OpenGL or the
+// ImGui draw lists, so tiles can be rendered from any thread in parallel.
+
+// Maps canvas coordinates onto image pixels: pixel = (world - world_min) * scale
+struct RasterView
+{
+    ImVec2 world_min = ImVec2(0.0f, 0.0f);
+    float scale = 1.0f;
+};
+
+// Pixels of an image element: the decoded file, halved while it stays at
+// least as large as the image in the output. Shared by items of one file.
+struct RasterImage
+{
+    int width = 0;
+    int height = 0;
+    ImagePixels rgba; // straight alpha
+};
+
+// Element with its precomputed canvas-space bounds (used for per-tile culling)
+struct RasterItem
+{
+    const CanvasElement *element = nullptr;
+    ImVec2 min, max;
+    // Image elements, set by LoadRasterImages; without pixels the placeholder is drawn
+    std::shared_ptr<const RasterImage> image;
+    bool image_failed = false;
+};
+
+struct RasterGlyph
+{
+    float x0, y0, x1, y1; // quad relative to the pen, in font pixels
+    float u0, v0, u1, v1;
+    float advance;
+};
+
+// Copy of the default font: glyph metrics and atlas pixels. Must be captured
+// on the UI thread (it may trigger an atlas build); afterwards it does not
+// refer to the ImGui context, so workers may keep it past ImGui shutdown.
+// Copies share the data.
+struct RasterFont
+{
+    struct Data
+    {
+        float size = 0.0f;
+        std::vector<RasterGlyph> glyphs;
+        std::vector<int> lookup; // codepoint -> index in glyphs, -1 = none
+        int fallback = -1;
+        std::vector<uint8_t> alpha;
+        int width = 0;
+        int height = 0;
+    };
+    std::shared_ptr<const Data> data;
+
+    bool valid() const { return data && !data->alpha.empty(); }
+    float size() const { return data ? data->size : 0.0f; }
+    // Glyph of the codepoint, the fallback glyph if the font has none
+    const RasterGlyph *find(unsigned int c) const;
+    // Size of the text laid out as RasterizeTile draws it (same as ImGui::CalcTextSize)
+    ImVec2 text_size(const std::string &text) const;
+};
+
+RasterFont CaptureRasterFont();
+
+// Canvas-space bounds as the rasterizer draws the element: labels are
+// measured with `font`, not with the live ImGui context. Any thread.
+bool RasterBounds(const CanvasElement &element, const RasterFont &font, ImVec2 &min, ImVec2 &max);
+
+// Collects all elements with valid bounds, in z-order.
+std::vector<RasterItem> CollectRasterItems(const CanvasState &canvas, const RasterFont &font);
+
+// Decodes the files of image items (ReadPng) for drawing at `scale` image
+// pixels per canvas unit. Each file is decoded once, files in parallel on the
+// shared pool with the calling thread taking part. Blocking; returns the
+// number of image items.
+size_t LoadRasterImages(std::vector<RasterItem> &items, float scale);
+
+// Renders one tile. Pixel (0,0) of the tile is image pixel (tile_x, tile_y).
+// rgba points at the top-left pixel of the tile inside a buffer with the given stride.
+void RasterizeTile(const std::vector<RasterItem> &items, const RasterFont &font, const RasterView &view,
+                   const ImVec4 &background, int tile_x, int tile_y, int width, int height,
+                   uint8_t *rgba, size_t stride);
@@ -0,0 +1,160 @@
+#include "render/StrokeRenderer.hpp"
+#include "core/PointCodec.hpp"
+#include "render/StrokeTessellator.hpp"
+#include <util/ImVecUtil.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Render cache of a geometry: one mesh slot keyed by mesh scale, width and
+// level of detail. Instances are usually pasted at scale 1, so per frame the
+// mesh is built once for all copies
+class GeometryMesh : public StrokeRenderCache {
+public:
+    static std::unique_ptr<StrokeRenderCache> Make() { return std::make_unique<GeometryMesh>(); }
+
+    // Mesh in local coordinates times `mesh_scale`, built on a key change
+    std::shared_ptr<const StrokeMesh> get(const StrokeGeometry& geometry, float mesh_scale, float width,
+                                          float lod_step) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cached && matches(mesh_scale, width, lod_step))
+            return cached;
+        thread_local std::vector<ImVec2> pts;
+        pts.resize(geometry.point_count());
+        DecodePoints(geometry.packed().data(), pts.size(), geometry.bounds_min() * mesh_scale,
+                     geometry.packed_scale() * mesh_scale, pts.data());
+        auto built = std::make_shared<StrokeMesh>();
+        // Frame counters count the replay (DrawStrokeMesh), not the build
+        TessellateStrokeMesh(pts.data(), pts.size(), width, *built, nullptr);
+        store(std::move(built), mesh_scale, width, lod_step);
+        return cached;
+    }
+
+    // Cached mesh without building, for plain (not instanced) strokes:
+    // nullptr when the key differs, and the slot is freed then since a plain
+    // stroke never rebuilds its mesh
+    std::shared_ptr<const StrokeMesh> find(float mesh_scale, float width, float lod_step) {
+        if (!has_mesh.load(std::memory_order_relaxed))
+            return nullptr;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cached && matches(mesh_scale, width, lod_step))
+            return cached;
+        store(nullptr, 0.0f, 0.0f, 0.0f);
+        return nullptr;
+    }
+
+    void adopt(std::shared_ptr<const StrokeMesh> built, float mesh_scale, float width, float lod_step) {
+        std::lock_guard<std::mutex> lock(mutex);
+        store(std::move(built), mesh_scale, width, lod_step);
+    }
+
+    size_t memory_bytes() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sizeof(GeometryMesh) + (cached ? cached->memory_bytes() : 0);
+    }
+
+private:
+    bool matches(float mesh_scale, float width, float lod_step) const {
+        return key_scale == mesh_scale && key_width == width && key_lod == lod_step;
+    }
+
+    void store(std::shared_ptr<const StrokeMesh> built, float mesh_scale, float width, float lod_step) {
+        cached = std::move(built);
+        key_scale = mesh_scale;
+        key_width = width;
+        key_lod = lod_step;
+        has_mesh.store(cached != nullptr, std::memory_order_relaxed);
+    }
+
+    mutable std::mutex mutex;
+    std::atomic<bool> has_mesh{false}; // lock-free miss for strokes without a mesh
+    std::shared_ptr<const StrokeMesh> cached;
+    float key_scale = 0.0f;
+    float key_width = 0.0f;
+    float key_lod = 0.0f;
+};
+
+// Render cache of the stroke being drawn (Stroke::wet)
+struct WetMesh : StrokeRenderCache {
+    WetStrokeMesh mesh;
+
+    WetMesh(float mesh_scale, float width, float lod_step) : mesh(mesh_scale, width, lod_step) {}
+    size_t memory_bytes() const override { return sizeof(WetMesh) - sizeof(WetStrokeMesh) + mesh.memory_bytes(); }
+};
+
+GeometryMesh& MeshOf(const StrokeGeometry& geometry) {
+    return static_cast<GeometryMesh&>(geometry.render_cache(&GeometryMesh::Make));
+}
+
+// The wet mesh of a stroke packed since the last frame goes to the geometry
+// cache, completed with the points added after it was last drawn
+void AdoptWetMesh(const Stroke& stroke) {
+    WetStrokeMesh& wet = static_cast<WetMesh&>(*stroke.wet.mesh).mesh;
+    const StrokeGeometry& geometry = *stroke.geometry;
+    const size_t count = stroke.point_count();
+    if (wet.point_count() <= count) {
+        thread_local std::vector<ImVec2> rest;
+        rest.resize(count - wet.point_count());
+        // Mesh space is the canvas times mesh_scale (the stroke is not moved
+        // since pack(), translate() drops the wet mesh)
+        DecodePoints(geometry.packed().data() + wet.point_count() * 2, rest.size(),
+                     geometry.bounds_min() * wet.mesh_scale(), geometry.packed_scale() * wet.mesh_scale(),
+                     rest.data());
+        wet.append(rest.data(), rest.size(), nullptr);
+        MeshOf(geometry).adopt(wet.finish(), wet.mesh_scale(), wet.width(), wet.lod_step());
+    }
+    stroke.wet.mesh.reset();
+}
+
+} // namespace
+
+void DrawStroke(ImDrawList* draw_list, const Stroke& stroke, const ImVec2& origin, const ImVec2& pan, float zoom) {
+    if (stroke.point_count() == 0)
+        return;
+    const float lod_step = FrameStrokeOptions().lod_step;
+    const float width = stroke.thickness * zoom;
+    const ImU32 col = ImColor(stroke.color);
+    if (stroke.is_packed()) {
+        const StrokeGeometry& geometry = *stroke.geometry;
+        if (stroke.wet.mesh)
+            AdoptWetMesh(stroke);
+        const float mesh_scale = zoom * stroke.scale;
+        const ImVec2 offset = origin + pan + stroke.offset * zoom;
+        if (geometry.instanced()) {
+            // Instances: the mesh in local coordinates is built once for all
+            // copies and moved by offset and color
+            DrawStrokeMesh(draw_list, *MeshOf(geometry).get(geometry, mesh_scale, width, lod_step), offset, col);
+            return;
+        }
+        // The mesh left from drawing the stroke holds until the zoom changes
+        if (auto cache = static_cast<GeometryMesh*>(geometry.find_render_cache())) {
+            if (auto mesh = cache->find(mesh_scale, width, lod_step)) {
+                DrawStrokeMesh(draw_list, *mesh, offset, col);
+                return;
+            }
+        }
+    } else {
+        // Stroke being drawn: only new points and the tail are tessellated,
+        // the work per frame does not depend on the stroke length
+        auto wet = static_cast<WetMesh*>(stroke.wet.mesh.get());
+        if (!wet || !wet->mesh.matches(zoom, width, lod_step) || wet->mesh.point_count() > stroke.points.size()) {
+            stroke.wet.mesh = std::make_unique<WetMesh>(zoom, width, lod_step);
+            wet = static_cast<WetMesh*>(stroke.wet.mesh.get());
+        }
+        thread_local std::vector<ImVec2> fresh;
+        fresh.clear();
+        for (size_t i = wet->mesh.point_count(); i < stroke.points.size(); ++i)
+            fresh.push_back(stroke.points[i] * zoom);
+        wet->mesh.append(fresh.data(), fresh.size());
+        wet->mesh.draw(draw_list, origin + pan, col);
+        return;
+    }
+    // Decoded straight to screen space, the buffer is reused between frames
+    thread_local std::vector<ImVec2> transformed;
+    stroke.decode_points(transformed, origin + pan, zoom);
+    TessellateStroke(draw_list, transformed.data(), transformed.size(), width, col);
+}
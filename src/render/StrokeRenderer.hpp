@@ -0,0 +1,13 @@
+#pragma once
+#include <imgui.h>
+#include "core/CanvasElement.hpp"
+
+// Canvas drawing of strokes with the stroke tessellator:
+//  - an instanced geometry (copies, pastes) is tessellated once into a mesh
+//    kept in its render cache, and every instance replays it,
+//  - the stroke being drawn extends its wet mesh (WetStrokeMesh) by the new
+//    points only; once packed, the mesh moves to the geometry cache and is
+//    replayed until the zoom, width or level of detail changes,
+//  - everything else is tessellated every frame.
+// May run on a worker thread: a stroke is drawn by one thread per frame.
+void DrawStroke(ImDrawList *draw_list, const Stroke &stroke, const ImVec2 &origin, const ImVec2 &pan, float zoom);
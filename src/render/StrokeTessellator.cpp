@@ -0,0 +1,602 @@
+#include "render/StrokeTessellator.hpp"
+#include <imgui_internal.h> // ImDrawListSharedData
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+constexpr float kFringe = 1.0f;       // AA fringe width in pixels (same as ImGui)
+constexpr float kMinStep = 0.75f;     // samples closer than this (px) are merged
+constexpr float kMaxMiterInvLen2 = 4.0f; // miter length clamped to 2x half-width
+// Points per reservation: 4 vertices each keeps a chunk well below 65536
+constexpr size_t kMaxChunkPoints = 8192;
+
+inline float dot(const ImVec2& a, const ImVec2& b) { return a.x * b.x + a.y * b.y; }
+inline ImVec2 perp(const ImVec2& d) { return ImVec2(-d.y, d.x); }
+
+inline ImVec2 normalize(const ImVec2& v) {
+    float l2 = dot(v, v);
+    return l2 > 0.0f ? v * (1.0f / std::sqrt(l2)) : ImVec2(1.0f, 0.0f);
+}
+
+int arc_segments(float radius, float angle) {
+    // Roughly 0.3px max deviation, bounded for huge brushes
+    int n = static_cast<int>(std::ceil(std::sqrt(std::max(radius, 0.0f)) * 2.5f * angle / kPi));
+    return std::clamp(n, 3, 32);
+}
+
+// Where tessellated geometry goes: straight into a draw list, or into a
+// StrokeMesh for later replay. With `extend` the mesh writer appends to the
+// last block while it has room instead of opening a new one
+struct Target {
+    ImDrawList* dl = nullptr;
+    StrokeMesh* mesh = nullptr;
+    bool extend = false;
+};
+
+// Vertices of one mesh block, addressable with its 16-bit local indices
+constexpr uint32_t kMaxBlockVertices = 0xFFFF;
+
+bool fits_last_block(const StrokeMesh& mesh, int vtx_n) {
+    return !mesh.blocks.empty() && mesh.blocks.back().vtx_count + static_cast<uint32_t>(vtx_n) <= kMaxBlockVertices;
+}
+
+// Direct writer into the buffers reserved with PrimReserve (or appended to the mesh)
+struct Writer {
+    ImDrawList* dl;
+    StrokeMesh* mesh;
+    ImDrawVert* vtx = nullptr;
+    ImDrawIdx* idx = nullptr;
+    ImVec2* mesh_pos = nullptr;
+    uint8_t* mesh_alpha = nullptr;
+    uint16_t* mesh_idx = nullptr;
+    unsigned int base = 0;
+    int vtx_count;
+    int idx_count;
+    ImVec2 uv;
+
+    Writer(const Target& t, int idx_n, int vtx_n) : dl(t.dl), mesh(t.mesh), vtx_count(vtx_n), idx_count(idx_n) {
+        if (mesh) {
+            // Mesh blocks keep block-local indices; DrawStrokeMesh rebases them
+            if (!t.extend || !fits_last_block(*mesh, vtx_n))
+                mesh->blocks.push_back({static_cast<uint32_t>(mesh->pos.size()), 0,
+                                        static_cast<uint32_t>(mesh->idx.size()), 0});
+            StrokeMesh::Block& block = mesh->blocks.back();
+            const uint32_t vtx_at = block.vtx_start + block.vtx_count;
+            const uint32_t idx_at = block.idx_start + block.idx_count;
+            base = block.vtx_count;
+            block.vtx_count += static_cast<uint32_t>(vtx_n);
+            block.idx_count += static_cast<uint32_t>(idx_n);
+            mesh->pos.resize(vtx_at + vtx_n);
+            mesh->alpha.resize(vtx_at + vtx_n);
+            mesh->idx.resize(idx_at + idx_n);
+            mesh_pos = mesh->pos.data() + vtx_at;
+            mesh_alpha = mesh->alpha.data() + vtx_at;
+            mesh_idx = mesh->idx.data() + idx_at;
+            return;
+        }
+        dl->PrimReserve(idx_n, vtx_n);
+        vtx = dl->_VtxWritePtr;
+        idx = dl->_IdxWritePtr;
+        base = dl->_VtxCurrentIdx;
+        uv = dl->_Data->TexUvWhitePixel;
+    }
+    ~Writer() {
+        if (mesh)
+            return;
+        dl->_VtxWritePtr += vtx_count;
+        dl->_IdxWritePtr += idx_count;
+        dl->_VtxCurrentIdx += vtx_count;
+    }
+    void v(int i, const ImVec2& pos, ImU32 col) {
+        if (mesh) {
+            mesh_pos[i] = pos;
+            mesh_alpha[i] = static_cast<uint8_t>(col >> IM_COL32_A_SHIFT);
+            return;
+        }
+        vtx[i].pos = pos;
+        vtx[i].uv = uv;
+        vtx[i].col = col;
+    }
+    // Indices are relative to the first vertex of this writer (negative ones
+    // reach vertices written earlier into the same mesh block)
+    void tri(int& k, int a, int b, int c) {
+        if (mesh) {
+            mesh_idx[k++] = static_cast<uint16_t>(static_cast<int>(base) + a);
+            mesh_idx[k++] = static_cast<uint16_t>(static_cast<int>(base) + b);
+            mesh_idx[k++] = static_cast<uint16_t>(static_cast<int>(base) + c);
+            return;
+        }
+        idx[k++] = static_cast<ImDrawIdx>(base + a);
+        idx[k++] = static_cast<ImDrawIdx>(base + b);
+        idx[k++] = static_cast<ImDrawIdx>(base + c);
+    }
+};
+
+// Fan with AA rim: center + `segments`+1 inner/outer ring vertices along an
+// arc starting at direction `from` and sweeping `angle` radians.
+void emit_arc(const Target& dl, const ImVec2& center, const ImVec2& from, float angle, float core, int segments,
+              ImU32 col, ImU32 col_trans, StrokeTessStats* stats) {
+    const int ring = segments + 1;
+    const int vtx_n = 1 + 2 * ring;
+    const int idx_n = segments * 9;
+    Writer w(dl, idx_n, vtx_n);
+
+    w.v(0, center, col);
+    const float a0 = std::atan2(from.y, from.x);
+    for (int i = 0; i < ring; ++i) {
+        float a = a0 + angle * static_cast<float>(i) / segments;
+        ImVec2 dir(std::cos(a), std::sin(a));
+        w.v(1 + i * 2, center + dir * core, col);
+        w.v(2 + i * 2, center + dir * (core + kFringe), col_trans);
+    }
+    int k = 0;
+    for (int i = 0; i < segments; ++i) {
+        int in0 = 1 + i * 2, out0 = in0 + 1, in1 = in0 + 2, out1 = in0 + 3;
+        w.tri(k, 0, in0, in1);
+        w.tri(k, in0, out0, out1);
+        w.tri(k, in0, out1, in1);
+    }
+    if (stats) {
+        stats->vertices += vtx_n;
+        stats->indices += idx_n;
+    }
+}
+
+} // namespace
+
+namespace {
+thread_local StrokeTessStats* t_scoped_stats = nullptr;
+} // namespace
+
+StrokeTessStats& FrameStrokeStats() {
+    static StrokeTessStats stats;
+    return t_scoped_stats ? *t_scoped_stats : stats;
+}
+
+ScopedStrokeStats::ScopedStrokeStats(StrokeTessStats& stats) : previous(t_scoped_stats) {
+    t_scoped_stats = &stats;
+}
+
+ScopedStrokeStats::~ScopedStrokeStats() {
+    t_scoped_stats = previous;
+}
+
+StrokeTessOptions& FrameStrokeOptions() {
+    static StrokeTessOptions options;
+    return options;
+}
+
+namespace {
+
+// Colors and widths derived from the requested line width
+struct Ink {
+    bool thin;  // sub-pixel lines keep a 1px footprint and fade instead
+    float core; // half-width of the opaque part
+    ImU32 col, col_trans;
+    int per_point, per_segment; // strip vertices per point, indices per segment
+};
+
+Ink make_ink(float width, ImU32 col) {
+    Ink ink;
+    ink.thin = width <= kFringe;
+    if (ink.thin) {
+        ImU32 alpha = static_cast<ImU32>(((col >> IM_COL32_A_SHIFT) & 0xFF) * std::max(width, 0.0f));
+        col = (col & ~IM_COL32_A_MASK) | (alpha << IM_COL32_A_SHIFT);
+    }
+    ink.col = col;
+    ink.col_trans = col & ~IM_COL32_A_MASK;
+    ink.core = ink.thin ? 0.0f : (width - kFringe) * 0.5f;
+    ink.per_point = ink.thin ? 3 : 4;
+    ink.per_segment = ink.thin ? 12 : 18;
+    return ink;
+}
+
+float merge_step(float lod_step) {
+    return std::max(kMinStep, lod_step);
+}
+
+// Strip vertices: one per point with its miter normal. A joint sharper
+// than 90 degrees is split instead: the incoming segment ends and the
+// outgoing one starts with their own normals, and a round join covers the gap.
+struct StripPoint {
+    ImVec2 pos;
+    ImVec2 normal;
+    bool connect; // emit a segment to the next strip point
+};
+
+// Strip points of the interior point `cur`; returns true if it needs a round join
+template <typename Out>
+bool interior_strip(const ImVec2& prev, const ImVec2& cur, const ImVec2& next, Out&& out) {
+    const ImVec2 prev_dir = normalize(cur - prev);
+    const ImVec2 dir = normalize(next - cur);
+    if (dot(prev_dir, dir) < 0.0f) {
+        out(StripPoint{cur, perp(prev_dir), false});
+        out(StripPoint{cur, perp(dir), true});
+        return true;
+    }
+    ImVec2 m = (perp(prev_dir) + perp(dir)) * 0.5f;
+    float inv_len2 = 1.0f / std::max(dot(m, m), 1e-6f);
+    out(StripPoint{cur, m * std::min(inv_len2, kMaxMiterInvLen2), true});
+    return false;
+}
+
+void strip_vertices(Writer& w, int b, const StripPoint& sp, const Ink& ink) {
+    const ImVec2& p = sp.pos;
+    const ImVec2& nm = sp.normal;
+    if (ink.thin) {
+        w.v(b + 0, p + nm * kFringe, ink.col_trans);
+        w.v(b + 1, p, ink.col);
+        w.v(b + 2, p - nm * kFringe, ink.col_trans);
+    } else {
+        w.v(b + 0, p + nm * (ink.core + kFringe), ink.col_trans);
+        w.v(b + 1, p + nm * ink.core, ink.col);
+        w.v(b + 2, p - nm * ink.core, ink.col);
+        w.v(b + 3, p - nm * (ink.core + kFringe), ink.col_trans);
+    }
+}
+
+// Quad strip between the strip vertices starting at `a` and at `b`
+void strip_segment(Writer& w, int& k, int a, int b, const Ink& ink) {
+    if (ink.thin) {
+        w.tri(k, a + 0, b + 0, b + 1);
+        w.tri(k, a + 0, b + 1, a + 1);
+        w.tri(k, a + 1, b + 1, b + 2);
+        w.tri(k, a + 1, b + 2, a + 2);
+    } else {
+        w.tri(k, a + 1, b + 1, b + 2);
+        w.tri(k, a + 1, b + 2, a + 2);
+        w.tri(k, a + 0, b + 0, b + 1);
+        w.tri(k, a + 0, b + 1, a + 1);
+        w.tri(k, a + 2, b + 2, b + 3);
+        w.tri(k, a + 2, b + 3, a + 3);
+    }
+}
+
+// Emits strip[0..n) in chunks sharing their boundary point
+void emit_strip(const Target& target, const StripPoint* strip, size_t strip_n, const Ink& ink, StrokeTessStats* stats) {
+    for (size_t start = 0; start + 1 < strip_n; start += kMaxChunkPoints - 1) {
+        const size_t m = std::min(kMaxChunkPoints, strip_n - start);
+        int segments = 0;
+        for (size_t j = 0; j + 1 < m; ++j)
+            segments += strip[start + j].connect ? 1 : 0;
+        const int vtx_n = static_cast<int>(m) * ink.per_point;
+        const int idx_n = segments * ink.per_segment;
+        Writer w(target, idx_n, vtx_n);
+
+        for (size_t j = 0; j < m; ++j)
+            strip_vertices(w, static_cast<int>(j) * ink.per_point, strip[start + j], ink);
+        int k = 0;
+        for (size_t j = 0; j + 1 < m; ++j) {
+            if (!strip[start + j].connect)
+                continue;
+            const int a = static_cast<int>(j) * ink.per_point;
+            strip_segment(w, k, a, a + ink.per_point, ink);
+        }
+        if (stats) {
+            stats->vertices += vtx_n;
+            stats->indices += idx_n;
+        }
+        if (start + m >= strip_n)
+            break;
+    }
+}
+
+void emit_cap(const Target& target, const ImVec2& p, const ImVec2& normal, bool end, const Ink& ink,
+              StrokeTessStats* stats) {
+    emit_arc(target, p, normal, end ? -kPi : kPi, ink.core, arc_segments(ink.core, kPi), ink.col, ink.col_trans,
+             stats);
+}
+
+void emit_join(const Target& target, const ImVec2& p, const Ink& ink, StrokeTessStats* stats) {
+    emit_arc(target, p, ImVec2(1.0f, 0.0f), 2.0f * kPi, ink.core, arc_segments(ink.core, 2.0f * kPi), ink.col,
+             ink.col_trans, stats);
+}
+
+void Tessellate(const Target& draw_list, const ImVec2* pts, size_t count, float width, ImU32 col,
+                StrokeTessStats* stats) {
+    const Ink ink = make_ink(width, col);
+    const bool thin = ink.thin;
+
+    // Drop duplicate and near-duplicate samples; always keep both end points
+    thread_local std::vector<ImVec2> kept;
+    kept.clear();
+    kept.reserve(count);
+    kept.push_back(pts[0]);
+    const float step = merge_step(FrameStrokeOptions().lod_step);
+    const float step2 = step * step;
+    for (size_t i = 1; i < count; ++i) {
+        ImVec2 d = pts[i] - kept.back();
+        if (dot(d, d) >= step2)
+            kept.push_back(pts[i]);
+    }
+    if (count > 1) {
+        ImVec2 d = pts[count - 1] - kept.back();
+        if (dot(d, d) > 0.0f) {
+            if (kept.size() > 1)
+                kept.back() = pts[count - 1];
+            else
+                kept.push_back(pts[count - 1]);
+        }
+    }
+
+    if (stats) {
+        stats->strokes++;
+        stats->input_points += count;
+        stats->kept_points += kept.size();
+        if (count > 1) {
+            stats->polyline_vertices += count * (thin ? 3 : 4);
+            stats->polyline_indices += (count - 1) * (thin ? 12 : 18);
+        }
+    }
+
+    // A dot: single round disc
+    if (kept.size() == 1) {
+        if (!thin)
+            emit_arc(draw_list, kept[0], ImVec2(1.0f, 0.0f), 2.0f * kPi, ink.core,
+                     arc_segments(ink.core, 2.0f * kPi), ink.col, ink.col_trans, stats);
+        return;
+    }
+
+    const size_t n = kept.size();
+    thread_local std::vector<StripPoint> strip;
+    thread_local std::vector<ImVec2> round_joins;
+    strip.clear();
+    round_joins.clear();
+    strip.reserve(n + 8);
+
+    auto push = [](const StripPoint& sp) { strip.push_back(sp); };
+    const ImVec2 first_normal = perp(normalize(kept[1] - kept[0]));
+    strip.push_back({kept[0], first_normal, true});
+    for (size_t i = 1; i + 1 < n; ++i)
+        if (interior_strip(kept[i - 1], kept[i], kept[i + 1], push) && !thin)
+            round_joins.push_back(kept[i]);
+    const ImVec2 last_normal = perp(normalize(kept[n - 1] - kept[n - 2]));
+    strip.push_back({kept[n - 1], last_normal, false});
+
+    emit_strip(draw_list, strip.data(), strip.size(), ink, stats);
+
+    if (thin)
+        return;
+
+    // Round caps: half discs facing away from the stroke
+    emit_cap(draw_list, kept[0], first_normal, false, ink, stats);
+    emit_cap(draw_list, kept[n - 1], last_normal, true, ink, stats);
+    for (const ImVec2& p : round_joins)
+        emit_join(draw_list, p, ink, stats);
+}
+
+} // namespace
+
+void TessellateStroke(ImDrawList* draw_list, const ImVec2* pts, size_t count, float width, ImU32 col,
+                      StrokeTessStats* stats) {
+    if (count == 0 || (col & IM_COL32_A_MASK) == 0)
+        return;
+    Target target;
+    target.dl = draw_list;
+    Tessellate(target, pts, count, width, col, stats);
+}
+
+void TessellateStrokeMesh(const ImVec2* pts, size_t count, float width, StrokeMesh& mesh, StrokeTessStats* stats) {
+    mesh.pos.clear();
+    mesh.alpha.clear();
+    mesh.idx.clear();
+    mesh.blocks.clear();
+    if (count == 0)
+        return;
+    // Coverage only: the instance color is applied on replay
+    Target target;
+    target.mesh = &mesh;
+    Tessellate(target, pts, count, width, IM_COL32_WHITE, stats);
+}
+
+void DrawStrokeMesh(ImDrawList* draw_list, const StrokeMesh& mesh, const ImVec2& offset, ImU32 col,
+                    StrokeTessStats* stats) {
+    const ImU32 alpha = (col >> IM_COL32_A_SHIFT) & 0xFF;
+    if (alpha == 0 || mesh.blocks.empty())
+        return;
+    const ImU32 rgb = col & ~IM_COL32_A_MASK;
+    ImU32 palette[256];
+    for (ImU32 a = 0; a < 256; ++a)
+        palette[a] = rgb | (((a * alpha + 127) / 255) << IM_COL32_A_SHIFT);
+
+    const ImVec2 uv = draw_list->_Data->TexUvWhitePixel;
+    for (const StrokeMesh::Block& block : mesh.blocks) {
+        draw_list->PrimReserve(static_cast<int>(block.idx_count), static_cast<int>(block.vtx_count));
+        ImDrawVert* vtx = draw_list->_VtxWritePtr;
+        ImDrawIdx* idx = draw_list->_IdxWritePtr;
+        const unsigned int base = draw_list->_VtxCurrentIdx;
+        const ImVec2* pos = mesh.pos.data() + block.vtx_start;
+        const uint8_t* cov = mesh.alpha.data() + block.vtx_start;
+        for (uint32_t i = 0; i < block.vtx_count; ++i) {
+            vtx[i].pos = ImVec2(pos[i].x + offset.x, pos[i].y + offset.y);
+            vtx[i].uv = uv;
+            vtx[i].col = palette[cov[i]];
+        }
+        const uint16_t* src = mesh.idx.data() + block.idx_start;
+        for (uint32_t i = 0; i < block.idx_count; ++i)
+            idx[i] = static_cast<ImDrawIdx>(base + src[i]);
+        draw_list->_VtxWritePtr += block.vtx_count;
+        draw_list->_IdxWritePtr += block.idx_count;
+        draw_list->_VtxCurrentIdx += block.vtx_count;
+    }
+    if (stats) {
+        stats->strokes++;
+        stats->replayed_strokes++;
+        stats->vertices += mesh.pos.size();
+        stats->indices += mesh.idx.size();
+    }
+}
+
+WetStrokeMesh::WetStrokeMesh(float mesh_scale, float width, float lod_step)
+    : key_scale(mesh_scale), key_width(width), key_lod(lod_step) {
+    const float step = merge_step(lod_step);
+    step2 = step * step;
+}
+
+void WetStrokeMesh::append(const ImVec2* pts, size_t count, StrokeTessStats* stats) {
+    if (count == 0)
+        return;
+    // Same sample merging as Tessellate: a point is kept once it is a full
+    // step away from the previous kept one
+    for (size_t i = 0; i < count; ++i) {
+        const ImVec2& p = pts[i];
+        if (kept_n == 0) {
+            push_kept(p);
+        } else {
+            ImVec2 d = p - recent[3];
+            if (dot(d, d) >= step2)
+                push_kept(p);
+        }
+        last_in = p;
+    }
+    points_in += count;
+    const size_t tail_points = rebuild_tail();
+    if (stats)
+        stats->wet_points += count + tail_points;
+}
+
+void WetStrokeMesh::push_kept(const ImVec2& p) {
+    recent[0] = recent[1];
+    recent[1] = recent[2];
+    recent[2] = recent[3];
+    recent[3] = p;
+    kept_n++;
+    // The strip of a kept point depends on both neighbours, and the last
+    // kept point may still be replaced by the final sample
+    if (kept_n >= 3)
+        freeze_next();
+}
+
+void WetStrokeMesh::freeze_next() {
+    // recent[1] is the point being frozen, recent[0] and recent[2] its neighbours
+    const Ink ink = make_ink(key_width, IM_COL32_WHITE);
+    Target target;
+    target.mesh = &frozen;
+    target.extend = true;
+    if (frozen_n == 0) {
+        const ImVec2 normal = perp(normalize(recent[2] - recent[1]));
+        freeze_strip(recent[1], normal, true);
+        if (!ink.thin)
+            emit_cap(target, recent[1], normal, false, ink, nullptr);
+    } else {
+        auto out = [&](const StripPoint& sp) { freeze_strip(sp.pos, sp.normal, sp.connect); };
+        if (interior_strip(recent[0], recent[1], recent[2], out) && !ink.thin)
+            emit_join(target, recent[1], ink, nullptr);
+    }
+    frozen_n++;
+}
+
+void WetStrokeMesh::freeze_strip(const ImVec2& pos, const ImVec2& normal, bool connect) {
+    const Ink ink = make_ink(key_width, IM_COL32_WHITE);
+    Target target;
+    target.mesh = &frozen;
+    target.extend = true;
+    // The segment reuses the vertices of the previous strip point while they
+    // are in the same block, otherwise the point is written again
+    const bool segment = strip_valid && strip_connect;
+    const bool same_block =
+        segment && strip_block + 1 == frozen.blocks.size() && fits_last_block(frozen, ink.per_point);
+    Writer w(target, segment ? ink.per_segment : 0, ink.per_point * (segment && !same_block ? 2 : 1));
+    int prev = static_cast<int>(strip_vtx) - static_cast<int>(w.base);
+    int b = 0;
+    if (segment && !same_block) {
+        strip_vertices(w, 0, StripPoint{strip_pos, strip_normal, true}, ink);
+        prev = 0;
+        b = ink.per_point;
+    }
+    strip_vertices(w, b, StripPoint{pos, normal, connect}, ink);
+    if (segment) {
+        int k = 0;
+        strip_segment(w, k, prev, b, ink);
+    }
+    strip_pos = pos;
+    strip_normal = normal;
+    strip_connect = connect;
+    strip_valid = true;
+    strip_block = static_cast<uint32_t>(frozen.blocks.size() - 1);
+    strip_vtx = w.base + static_cast<unsigned int>(b);
+}
+
+size_t WetStrokeMesh::rebuild_tail() {
+    tail.pos.clear();
+    tail.alpha.clear();
+    tail.idx.clear();
+    tail.blocks.clear();
+    Target target;
+    target.mesh = &tail;
+    target.extend = true;
+
+    if (frozen_n == 0) {
+        // At most two kept points: the whole stroke is the tail
+        ImVec2 pts[3];
+        size_t n = 0;
+        for (size_t i = 4 - kept_n; i < 4; ++i)
+            pts[n++] = recent[i];
+        pts[n++] = last_in;
+        Tessellate(target, pts, n, key_width, IM_COL32_WHITE, nullptr);
+        return n;
+    }
+
+    // From the last frozen strip point through the last kept point to the
+    // latest sample, which stands in for the last kept point as in Tessellate
+    const Ink ink = make_ink(key_width, IM_COL32_WHITE);
+    const ImVec2& prev = recent[1];
+    const ImVec2& mid = recent[2];
+    const ImVec2& last = last_in;
+    StripPoint strip[4];
+    size_t n = 0;
+    strip[n++] = StripPoint{strip_pos, strip_normal, true};
+    auto out = [&](const StripPoint& sp) { strip[n++] = sp; };
+    const bool join = interior_strip(prev, mid, last, out) && !ink.thin;
+    const ImVec2 last_normal = perp(normalize(last - mid));
+    strip[n++] = StripPoint{last, last_normal, false};
+    emit_strip(target, strip, n, ink, nullptr);
+    if (ink.thin)
+        return 3;
+    emit_cap(target, last, last_normal, true, ink, nullptr);
+    if (join)
+        emit_join(target, mid, ink, nullptr);
+    return 3;
+}
+
+void WetStrokeMesh::draw(ImDrawList* draw_list, const ImVec2& offset, ImU32 col, StrokeTessStats* stats) const {
+    DrawStrokeMesh(draw_list, frozen, offset, col, nullptr);
+    DrawStrokeMesh(draw_list, tail, offset, col, nullptr);
+    if (stats) {
+        stats->strokes++;
+        stats->wet_strokes++;
+        stats->input_points += points_in;
+        stats->kept_points += kept_n;
+        stats->vertices += frozen.pos.size() + tail.pos.size();
+        stats->indices += frozen.idx.size() + tail.idx.size();
+    }
+}
+
+std::shared_ptr<const StrokeMesh> WetStrokeMesh::finish() const {
+    auto mesh = std::make_shared<StrokeMesh>();
+    mesh->pos.reserve(frozen.pos.size() + tail.pos.size());
+    mesh->alpha.reserve(frozen.alpha.size() + tail.alpha.size());
+    mesh->idx.reserve(frozen.idx.size() + tail.idx.size());
+    mesh->blocks.reserve(frozen.blocks.size() + tail.blocks.size());
+    mesh->pos.insert(mesh->pos.end(), frozen.pos.begin(), frozen.pos.end());
+    mesh->pos.insert(mesh->pos.end(), tail.pos.begin(), tail.pos.end());
+    mesh->alpha.insert(mesh->alpha.end(), frozen.alpha.begin(), frozen.alpha.end());
+    mesh->alpha.insert(mesh->alpha.end(), tail.alpha.begin(), tail.alpha.end());
+    mesh->idx.insert(mesh->idx.end(), frozen.idx.begin(), frozen.idx.end());
+    mesh->idx.insert(mesh->idx.end(), tail.idx.begin(), tail.idx.end());
+    mesh->blocks.insert(mesh->blocks.end(), frozen.blocks.begin(), frozen.blocks.end());
+    // Indices are block-local, only the block ranges move
+    const uint32_t vtx_shift = static_cast<uint32_t>(frozen.pos.size());
+    const uint32_t idx_shift = static_cast<uint32_t>(frozen.idx.size());
+    for (StrokeMesh::Block block : tail.blocks) {
+        block.vtx_start += vtx_shift;
+        block.idx_start += idx_shift;
+        mesh->blocks.push_back(block);
+    }
+    return mesh;
+}
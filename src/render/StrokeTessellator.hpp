@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <imgui.h>
+#include <memory>
+#include <util/MemoryStats.hpp>
+
+// Anti-aliased polyline tessellation for strokes, a replacement for
+// ImDrawList::AddPolyline:
+//  - near-duplicate samples are dropped before tessellation,
+//  - round caps, round joins only where the miter would be clamped,
+//  - vertices/indices are written straight into PrimReserve'd buffers,
+//  - long strokes are emitted in chunks so a single reservation never
+//    exceeds what a 16-bit ImDrawIdx can address.
+
+struct StrokeTessStats
+{
+    size_t strokes = 0;
+    size_t input_points = 0;
+    size_t kept_points = 0;
+    size_t vertices = 0;
+    size_t indices = 0;
+    // What AddPolyline (anti-aliased, non-textured path) would have produced for the same input
+    size_t polyline_vertices = 0;
+    size_t polyline_indices = 0;
+    // Strokes drawn by replaying a cached mesh instead of tessellating
+    size_t replayed_strokes = 0;
+    // Strokes still being drawn (WetStrokeMesh) and the points tessellated
+    // for them: the new ones plus the rebuilt tail
+    size_t wet_strokes = 0;
+    size_t wet_points = 0;
+
+    void reset() { *this = StrokeTessStats(); }
+
+    StrokeTessStats &operator+=(const StrokeTessStats &o)
+    {
+        strokes += o.strokes;
+        input_points += o.input_points;
+        kept_points += o.kept_points;
+        vertices += o.vertices;
+        indices += o.indices;
+        polyline_vertices += o.polyline_vertices;
+        polyline_indices += o.polyline_indices;
+        replayed_strokes += o.replayed_strokes;
+        wet_strokes += o.wet_strokes;
+        wet_points += o.wet_points;
+        return *this;
+    }
+};
+
+// Counters of the frame being rendered; RenderCanvas resets them each frame.
+// On a thread inside a ScopedStrokeStats these are that scope's counters.
+StrokeTessStats &FrameStrokeStats();
+
+// Redirects FrameStrokeStats() of the calling thread to `stats` while alive,
+// so render batches on worker threads count without sharing the counters.
+class ScopedStrokeStats
+{
+public:
+    explicit ScopedStrokeStats(StrokeTessStats &stats);
+    ~ScopedStrokeStats();
+    ScopedStrokeStats(const ScopedStrokeStats &) = delete;
+    ScopedStrokeStats &operator=(const ScopedStrokeStats &) = delete;
+
+private:
+    StrokeTessStats *previous;
+};
+
+struct StrokeTessOptions
+{
+    float lod_step = 0.0f; // coarser sample merging (px) at lower render quality, 0 = full quality
+};
+
+// Options of the frame being rendered; RenderCanvas sets them from the render quality.
+StrokeTessOptions &FrameStrokeOptions();
+
+// pts are in screen space, width is the full line width in pixels.
+void TessellateStroke(ImDrawList *draw_list, const ImVec2 *pts, size_t count, float width, ImU32 col,
+                      StrokeTessStats *stats = &FrameStrokeStats());
+
+// Tessellated stroke kept for replay: positions relative to the stroke
+// origin and per-vertex coverage, the color is applied by DrawStrokeMesh.
+// Each block is one reservation with block-local 16-bit indices.
+struct StrokeMesh
+{
+    struct Block
+    {
+        uint32_t vtx_start, vtx_count;
+        uint32_t idx_start, idx_count;
+    };
+    TrackedVector<ImVec2, MemCategory::Caches> pos;
+    TrackedVector<uint8_t, MemCategory::Caches> alpha;
+    TrackedVector<uint16_t, MemCategory::Caches> idx;
+    TrackedVector<Block, MemCategory::Caches> blocks;
+
+    size_t memory_bytes() const
+    {
+        return sizeof(StrokeMesh) + pos.capacity() * sizeof(ImVec2) + alpha.capacity() +
+               idx.capacity() * sizeof(uint16_t) + blocks.capacity() * sizeof(Block);
+    }
+};
+
+// Same tessellation as TessellateStroke, recorded into `mesh` (previous contents are dropped).
+void TessellateStrokeMesh(const ImVec2 *pts, size_t count, float width, StrokeMesh &mesh,
+                          StrokeTessStats *stats = &FrameStrokeStats());
+
+// Appends the mesh translated by `offset` and tinted with `col`.
+void DrawStrokeMesh(ImDrawList *draw_list, const StrokeMesh &mesh, const ImVec2 &offset, ImU32 col,
+                    StrokeTessStats *stats = &FrameStrokeStats());
+
+// Incremental tessellation of a stroke that is still being drawn (wet ink).
+// Points are fed as they arrive; the part of the outline that later points
+// can no longer change is appended to a persistent mesh once, and only the
+// last two segments with the end cap are rebuilt. An update costs the same
+// for a short and a long stroke; the outline is the one TessellateStrokeMesh
+// builds for the same points.
+class WetStrokeMesh
+{
+public:
+    // Mesh space is the stroke in canvas coordinates times `mesh_scale`,
+    // as for the geometry meshes of StrokeRenderer; width in pixels
+    WetStrokeMesh(float mesh_scale, float width, float lod_step);
+
+    bool matches(float mesh_scale, float width, float lod_step) const
+    {
+        return key_scale == mesh_scale && key_width == width && key_lod == lod_step;
+    }
+    float mesh_scale() const { return key_scale; }
+    float width() const { return key_width; }
+    float lod_step() const { return key_lod; }
+
+    // Points consumed so far
+    size_t point_count() const { return points_in; }
+
+    // Points added to the stroke since the previous call, in mesh space
+    void append(const ImVec2 *pts, size_t count, StrokeTessStats *stats = &FrameStrokeStats());
+
+    // Same as DrawStrokeMesh for the outline built so far
+    void draw(ImDrawList *draw_list, const ImVec2 &offset, ImU32 col,
+              StrokeTessStats *stats = &FrameStrokeStats()) const;
+
+    // The whole outline as one mesh, for the cache of the finished stroke
+    std::shared_ptr<const StrokeMesh> finish() const;
+
+    size_t memory_bytes() const { return sizeof(WetStrokeMesh) + frozen.memory_bytes() + tail.memory_bytes(); }
+
+private:
+    void push_kept(const ImVec2 &p);
+    void freeze_next();
+    void freeze_strip(const ImVec2 &pos, const ImVec2 &normal, bool connect);
+    size_t rebuild_tail();
+
+    float key_scale, key_width, key_lod;
+    float step2;
+
+    // Last kept (de-duplicated) points, newest at the end, and their count
+    ImVec2 recent[4];
+    size_t kept_n = 0;
+    ImVec2 last_in = ImVec2(0.0f, 0.0f);
+    size_t points_in = 0;
+    // Kept points whose strip vertices are final (all but the last two)
+    size_t frozen_n = 0;
+
+    // Last strip point in `frozen` and the block-local index of its vertices
+    ImVec2 strip_pos = ImVec2(0.0f, 0.0f);
+    ImVec2 strip_normal = ImVec2(0.0f, 0.0f);
+    bool strip_valid = false;
+    bool strip_connect = false;
+    uint32_t strip_block = 0;
+    uint32_t strip_vtx = 0;
+
+    StrokeMesh frozen; // final part, only grows
+    StrokeMesh tail;   // last segments and caps, rebuilt by append()
+};
@@ -0,0 +1,289 @@
+#include "render/ThumbnailCache.hpp"
+#include "core/CanvasElement.hpp"
+#include "export/PngWriter.hpp"
+#include "util/DiskCache.hpp"
+#include "util/ThreadPool.hpp"
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Part of the file name; bump when thumbnails are drawn differently
+constexpr int kThumbnailFormat = 1;
+// A queued request is dropped when the page was not shown for this many frames
+constexpr uint64_t kForgetFrames = 3;
+// Textures of thumbnails not shown for this many frames are released
+constexpr uint64_t kReleaseFrames = 600;
+// Cache directory limits, applied at startup
+constexpr auto kMaxFileAge = std::chrono::hours(24 * 30);
+constexpr uintmax_t kMaxCacheBytes = 64ull << 20;
+// Canvas units around the page content
+constexpr float kMargin = 16.0f;
+// A small page is not magnified beyond 1:1
+constexpr float kMaxScale = 1.0f;
+// Same as the canvas background
+const ImVec4 kBackground(40 / 255.0f, 40 / 255.0f, 50 / 255.0f, 1.0f);
+
+fs::path ThumbnailFile(const fs::path& dir, uint64_t key) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "page-%016llx-%dx%d-v%d.png", static_cast<unsigned long long>(key),
+                  ThumbnailCache::kWidth, ThumbnailCache::kHeight, kThumbnailFormat);
+    return dir / name;
+}
+
+// A thumbnail found on disk; its time orders the size-cap eviction
+bool UseExisting(const fs::path& file) {
+    std::error_code ec;
+    if (!fs::exists(file, ec)) return false;
+    fs::last_write_time(file, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+// Removes files older than kMaxFileAge, then the least recently used ones
+// until the directory fits in kMaxCacheBytes. Files touched after started
+// belong to this session and are kept. Runs on a worker before any job.
+void PruneThumbnails(const fs::path& dir, fs::file_time_type started) {
+    struct File {
+        fs::file_time_type time;
+        uintmax_t size;
+        fs::path path;
+    };
+    std::vector<File> files;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code file_ec;
+        if (!it->is_regular_file(file_ec)) continue;
+        File file{it->last_write_time(file_ec), it->file_size(file_ec), it->path()};
+        if (file_ec) continue;
+        if (file.time < started - kMaxFileAge) {
+            fs::remove(file.path, file_ec); // also temporaries left by a crash
+            continue;
+        }
+        total += file.size;
+        files.push_back(std::move(file));
+    }
+    if (total <= kMaxCacheBytes) return;
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+    for (const File& file : files) {
+        if (total <= kMaxCacheBytes || file.time >= started) break;
+        if (fs::remove(file.path, ec)) total -= file.size;
+    }
+}
+
+// Fits the page content into the thumbnail and writes it as PNG. Runs on a
+// worker; written under a temporary name so readers never see half a file.
+bool WriteThumbnail(const CanvasState& page, const RasterFont& font, const fs::path& file, double* ms) {
+    auto start = std::chrono::steady_clock::now();
+    const int width = ThumbnailCache::kWidth;
+    const int height = ThumbnailCache::kHeight;
+
+    std::vector<RasterItem> items = CollectRasterItems(page, font);
+    RasterView view;
+    if (!items.empty()) {
+        ImVec2 min = items[0].min, max = items[0].max;
+        for (const RasterItem& item : items) {
+            min.x = std::min(min.x, item.min.x);
+            min.y = std::min(min.y, item.min.y);
+            max.x = std::max(max.x, item.max.x);
+            max.y = std::max(max.y, item.max.y);
+        }
+        min = min - ImVec2(kMargin, kMargin);
+        max = max + ImVec2(kMargin, kMargin);
+        view.scale = std::min({width / (max.x - min.x), height / (max.y - min.y), kMaxScale});
+        view.world_min = (min + max) * 0.5f - ImVec2(float(width), float(height)) * (0.5f / view.scale);
+        LoadRasterImages(items, view.scale);
+    }
+
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    RasterizeTile(items, font, view, kBackground, 0, 0, width, height, rgba.data(), size_t(width) * 4);
+
+    fs::path tmp = file;
+    tmp += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    PngWriter png;
+    bool ok = png.open(tmp.string(), width, height) && png.write_rows(rgba.data(), height, size_t(width) * 4);
+    ok = png.close() && ok;
+    std::error_code ec;
+    if (ok) fs::rename(tmp, file, ec);
+    if (!ok || ec) fs::remove(tmp, ec);
+    *ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache() {
+    std::error_code ec;
+    fs::path base = CacheDirectory();
+    if (base.empty()) base = fs::temp_directory_path(ec) / "myNotes";
+    dir = base / "thumbs";
+    fs::create_directories(dir, ec);
+
+    ThreadPool::shared().submit([results = results, dir = dir, started = fs::file_time_type::clock::now()] {
+        PruneThumbnails(dir, started);
+        std::lock_guard<std::mutex> lock(results->mutex);
+        results->pruned = true;
+    });
+}
+
+fs::path ThumbnailCache::file_for(uint64_t key) const {
+    return ThumbnailFile(dir, key);
+}
+
+void ThumbnailCache::begin_frame() {
+    frame++;
+    if (!font_captured) {
+        // The atlas may be built here, on the UI thread; workers get a copy of the glyphs and pixels
+        font = CaptureRasterFont();
+        font_captured = true;
+    }
+
+    std::vector<Done> done;
+    {
+        std::lock_guard<std::mutex> lock(results->mutex);
+        done.swap(results->done);
+        pruning = !results->pruned;
+    }
+    for (const Done& d : done) finish(d);
+
+    std::vector<std::pair<uint64_t, uint64_t>> queued; // (last wanted, key)
+    for (auto it = entries.begin(); it != entries.end();) {
+        Entry& entry = it->second;
+        if (entry.state == State::Queued) {
+            if (frame - entry.last_wanted > kForgetFrames) {
+                it = entries.erase(it);
+                continue;
+            }
+            queued.emplace_back(entry.last_wanted, it->first);
+        } else if (entry.asset && frame - entry.last_wanted > kReleaseFrames) {
+            entry.asset.reset();
+        }
+        ++it;
+    }
+
+    if (pruning) return;
+    // Pages on screen now go first; the pool is shared with decoding and export
+    std::sort(queued.begin(), queued.end(), std::greater<>());
+    const size_t max_running = std::max(1u, ThreadPool::shared().size());
+    for (const auto& [wanted, key] : queued) {
+        if (running >= max_running) break;
+        Entry& entry = entries[key];
+        entry.state = State::Running;
+        running++;
+        ThreadPool::shared().submit([results = results, key = key, data = entry.data, file = file_for(key),
+                                     font = font] {
+            Done done;
+            done.key = key;
+            if (UseExisting(file)) {
+                done.ok = true;
+            } else if (PageBytes bytes = data.load()) {
+                // Only this page is parsed; images are decoded from their files for the thumbnail
+                CanvasState page;
+                if (ParsePage(*bytes, page)) {
+                    done.ok = WriteThumbnail(page, font, file, &done.ms);
+                    done.rendered = true;
+                }
+            }
+            std::lock_guard<std::mutex> lock(results->mutex);
+            results->done.push_back(done);
+        });
+    }
+}
+
+ImTextureID ThumbnailCache::texture(uint64_t key, const PageData& data) {
+    auto [it, inserted] = entries.try_emplace(key);
+    Entry& entry = it->second;
+    entry.last_wanted = frame;
+    if (inserted) entry.data = data;
+    if (entry.state != State::Ready) return ImTextureID{};
+    if (!entry.asset) entry.asset = ImageStore::shared().acquire(file_for(key).string());
+    return ImageStore::shared().texture_for(entry.asset, ImVec2(float(kWidth), float(kHeight)));
+}
+
+void ThumbnailCache::render_snapshot(uint64_t serial, std::unique_ptr<CanvasState> snapshot) {
+    snapshot_in_flight = true;
+    std::shared_ptr<CanvasState> page = std::move(snapshot);
+    ThreadPool::shared().submit([results = results, serial, page, dir = dir, font = font] {
+        SnapshotResult result;
+        result.serial = serial;
+        result.bytes = SerializePage(*page);
+        result.key = PageKey(*result.bytes);
+        result.element_count = static_cast<uint32_t>(page->elements.size());
+
+        Done done;
+        done.key = result.key;
+        done.snapshot = true;
+        fs::path file = ThumbnailFile(dir, result.key);
+        if (UseExisting(file)) {
+            done.ok = true;
+        } else {
+            done.ok = WriteThumbnail(*page, font, file, &done.ms);
+            done.rendered = true;
+        }
+        std::lock_guard<std::mutex> lock(results->mutex);
+        results->done.push_back(done);
+        results->snapshots.push_back(std::move(result));
+    });
+}
+
+bool ThumbnailCache::take_snapshot(SnapshotResult& out) {
+    std::lock_guard<std::mutex> lock(results->mutex);
+    if (results->snapshots.empty()) return false;
+    out = std::move(results->snapshots.back());
+    results->snapshots.clear();
+    snapshot_in_flight = false;
+    return true;
+}
+
+void ThumbnailCache::discard(uint64_t key) {
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        // A running job would write the file again; the startup cleanup gets it then
+        if (it->second.state == State::Running) return;
+        entries.erase(it);
+    }
+    ThreadPool::shared().submit([file = file_for(key)] {
+        std::error_code ec;
+        fs::remove(file, ec);
+    });
+}
+
+void ThumbnailCache::finish(const Done& done) {
+    if (!done.snapshot) running--;
+    auto it = entries.find(done.key);
+    if (it == entries.end()) {
+        // A snapshot of the page being edited: its key is new to the cache
+        if (!done.ok) return;
+        it = entries.try_emplace(done.key).first;
+        it->second.last_wanted = frame;
+    }
+    Entry& entry = it->second;
+    if (done.rendered) {
+        rendered++;
+        render_ms = done.ms;
+    } else if (done.ok) {
+        disk_hits++;
+    }
+    if (entry.state == State::Ready) return;
+    entry.state = done.ok ? State::Ready : State::Failed;
+    entry.data = PageData{};
+}
+
+ThumbnailStats ThumbnailCache::stats() const {
+    ThumbnailStats s;
+    s.known = entries.size();
+    for (const auto& [key, entry] : entries)
+        if (entry.state == State::Queued) s.queued++;
+    s.running = running + (snapshot_in_flight ? 1 : 0);
+    s.rendered = rendered;
+    s.disk_hits = disk_hits;
+    s.render_ms = render_ms;
+    return s;
+}
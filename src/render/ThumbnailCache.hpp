@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <imgui.h>
+#include "core/Notebook.hpp"
+#include "render/ImageStore.hpp"
+#include "render/SoftwareRasterizer.hpp"
+
+struct ThumbnailStats {
+    size_t known = 0;     // thumbnails the navigator asked for
+    size_t queued = 0;
+    size_t running = 0;
+    size_t rendered = 0;  // rasterized this session
+    size_t disk_hits = 0; // already on disk
+    double render_ms = 0.0; // last rasterization, on a worker
+};
+
+// Page thumbnails rasterized on the thread pool by SoftwareRasterizer and
+// cached on disk as PNG files named after the page content key (PageKey).
+// A page is rendered again only when its content changed, also across
+// sessions. Finished files are shown through ImageStore, which decodes them
+// in the background and uploads the textures within the frame budget.
+// The directory is bounded: at startup files unused for a month are removed,
+// then the least recently used ones until it fits in a size cap (a disk hit
+// refreshes the file time). Thumbnails of superseded snapshots are removed
+// as soon as the navigator drops them (discard).
+// Main thread only; workers hand back nothing but their results.
+class ThumbnailCache {
+public:
+    static constexpr int kWidth = 160;
+    static constexpr int kHeight = 120;
+
+    struct SnapshotResult {
+        uint64_t serial = 0;
+        uint64_t key = 0;
+        PageBytes bytes; // the serialized snapshot, see Notebook::adopt_snapshot
+        uint32_t element_count = 0;
+    };
+
+    ThumbnailCache();
+
+    // Once per frame: collects finished jobs and starts queued ones, most
+    // recently requested first. Requests not repeated for a few frames
+    // (pages scrolled out of view) are dropped before they start.
+    void begin_frame();
+
+    // Texture of a stored page, null while its thumbnail is generated or
+    // decoded. Call for visible pages only, every frame they are visible.
+    ImTextureID texture(uint64_t key, const PageData& data);
+
+    // Renders the page being edited from a snapshot (cloned elements share
+    // their stroke geometry, so taking one is cheap). The worker also
+    // serializes the snapshot; take_snapshot() returns the result.
+    void render_snapshot(uint64_t serial, std::unique_ptr<CanvasState> snapshot);
+    // Also true while the startup cleanup runs: no job starts before it ends
+    bool snapshot_running() const { return snapshot_in_flight || pruning; }
+    bool take_snapshot(SnapshotResult& out);
+
+    // The page content with this key is gone (a newer snapshot replaced it and
+    // no page refers to it): forgets its thumbnail and removes the file
+    void discard(uint64_t key);
+
+    ThumbnailStats stats() const;
+
+private:
+    enum class State { Queued, Running, Ready, Failed };
+
+    struct Entry {
+        State state = State::Queued;
+        PageData data;
+        uint64_t last_wanted = 0; // frame
+        std::shared_ptr<ImageAsset> asset;
+    };
+
+    struct Done {
+        uint64_t key = 0;
+        bool ok = false;
+        bool rendered = false; // false = found on disk
+        bool snapshot = false; // from render_snapshot(), not a queued request
+        double ms = 0.0;
+    };
+
+    // Worker -> main thread
+    struct Results {
+        std::mutex mutex;
+        std::vector<Done> done;
+        std::vector<SnapshotResult> snapshots;
+        bool pruned = false;
+    };
+
+    std::filesystem::path file_for(uint64_t key) const;
+    void finish(const Done& done);
+
+    std::shared_ptr<Results> results = std::make_shared<Results>();
+    std::unordered_map<uint64_t, Entry> entries;
+    std::filesystem::path dir;
+    RasterFont font;
+    bool font_captured = false;
+    uint64_t frame = 0;
+    size_t running = 0;
+    bool snapshot_in_flight = false;
+    bool pruning = true;
+    size_t rendered = 0;
+    size_t disk_hits = 0;
+    double render_ms = 0.0;
+};
@@ -0,0 +1,81 @@
+#include "ui/DiagnosticsPanel.hpp"
+#include <imgui.h>
+#include "core/HitTest.hpp"
+#include "render/CanvasRenderer.hpp"
+#include "render/ImageStore.hpp"
+#include "render/StrokeTessellator.hpp"
+#include "util/MemoryStats.hpp"
+#include "util/FrameScheduler.hpp"
+
+void RenderDiagnostics()
+{
+    if (!ImGui::CollapsingHeader("Diagnostics"))
+        return;
+
+    // Бюджет кадра и уровень качества отрисовки
+    const FrameSchedulerStats &frame = FrameScheduler::shared().stats();
+    ImGui::Text("Frame budget: %.2f ms", frame.budget_ms);
+    ImGui::Text("CPU work: %.2f ms (avg %.2f ms)", frame.work_ms, frame.work_avg_ms);
+    ImGui::Text("Jobs: %.2f ms, %zu pending", frame.jobs_ms, frame.jobs_pending);
+    ImGui::Text("Quality level: %d, over budget %llu of %llu frames", frame.quality_level,
+                static_cast<unsigned long long>(frame.over_budget_frames),
+                static_cast<unsigned long long>(frame.frames));
+    ImGui::Separator();
+
+    // Пропускная способность hit-test ядер (отрезков в секунду)
+    static HitTestBenchmark hit_bench;
+    static bool hit_bench_done = false;
+    ImGui::Text("Hit-test kernel: %s", PolylineKernelName());
+    if (ImGui::Button("Benchmark hit-test"))
+    {
+        hit_bench = RunHitTestBenchmark();
+        hit_bench_done = true;
+    }
+    if (hit_bench_done)
+    {
+        ImGui::Text("%zu segments", hit_bench.segments);
+        ImGui::Text("Vertex loop: %.1f M seg/s", hit_bench.vertex_loop_sps / 1e6);
+        ImGui::Text("Scalar:      %.1f M seg/s", hit_bench.scalar_sps / 1e6);
+        ImGui::Text("SIMD:        %.1f M seg/s", hit_bench.simd_sps / 1e6);
+    }
+
+    // Построение геометрии холста пакетами на пуле потоков
+    ImGui::Separator();
+    const CanvasRenderStats &canvas = LastCanvasRenderStats();
+    ImGui::Text("Canvas: %zu visible, %zu culled", canvas.visible, canvas.culled);
+    if (canvas.batches > 0)
+        ImGui::Text("Batches: %zu on %u threads, build %.2f ms, merge %.2f ms", canvas.batches, canvas.threads,
+                    canvas.build_ms, canvas.merge_ms);
+    else
+        ImGui::Text("Batches: none (UI thread), build %.2f ms", canvas.build_ms);
+    static RenderBenchmark render_bench;
+    if (ImGui::Button("Benchmark canvas render"))
+        render_bench = RunRenderBenchmark();
+    if (!render_bench.runs.empty())
+    {
+        ImGui::Text("%zu strokes, %zu vertices", render_bench.strokes, render_bench.vertices);
+        const double base = render_bench.runs[0].ms;
+        for (const RenderBenchmarkRun &run : render_bench.runs)
+            ImGui::Text("%2u threads: %6.2f ms  x%.2f  (%zu batches)", run.threads, run.ms,
+                        run.ms > 0.0 ? base / run.ms : 0.0, run.batches);
+    }
+
+    // Геометрия штрихов последнего кадра в сравнении с AddPolyline
+    ImGui::Separator();
+    const StrokeTessStats &tess = FrameStrokeStats();
+    ImGui::Text("Strokes drawn: %zu, points %zu -> %zu", tess.strokes, tess.input_points, tess.kept_points);
+    ImGui::Text("Instanced (mesh replay): %zu", tess.replayed_strokes);
+    ImGui::Text("Being drawn: %zu, points tessellated %zu", tess.wet_strokes, tess.wet_points);
+    ImGui::Text("Vertices: %zu (AddPolyline: %zu)", tess.vertices, tess.polyline_vertices);
+    ImGui::Text("Indices:  %zu (AddPolyline: %zu)", tess.indices, tess.polyline_indices);
+
+    // Изображения: декодирование и загрузка текстур в пределах бюджета
+    ImGui::Separator();
+    const ImageStoreStats images = ImageStore::shared().stats();
+    ImGui::Text("Images: %zu (decoding %zu, failed %zu), decodes %zu", images.images, images.decoding, images.failed,
+                images.decodes);
+    ImGui::Text("Textures: %s of %s, %zu levels, %zu evicted", FormatMemoryBytes(images.gpu_bytes).c_str(),
+                FormatMemoryBytes(images.gpu_budget).c_str(), images.resident_levels, images.evicted_levels);
+    ImGui::Text("Uploads: %s last frame, %zu queued", FormatMemoryBytes(images.uploaded_bytes).c_str(),
+                images.pending_uploads);
+}
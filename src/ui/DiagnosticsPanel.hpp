@@ -0,0 +1,4 @@
+#pragma once
+
+// Benchmarks and counters shown as a section of the Tools window.
+void RenderDiagnostics();
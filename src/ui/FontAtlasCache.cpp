@@ -0,0 +1,226 @@
+#include "ui/FontAtlasCache.hpp"
+#include "core/Serialize.hpp"
+#include "util/DiskCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void BuildAtlas(ImFontAtlas* atlas, const std::vector<FontSpec>& fonts) {
+    for (const FontSpec& spec : fonts) {
+        ImFont* font = nullptr;
+        if (!spec.path.empty())
+            font = atlas->AddFontFromFileTTF(spec.path.c_str(), spec.size_px, nullptr, spec.ranges);
+        if (!font) {
+            ImFontConfig cfg;
+            cfg.SizePixels = spec.size_px;
+            atlas->AddFontDefault(&cfg);
+        }
+    }
+    atlas->Build();
+}
+
+// Кэш заполняет внутренние поля ImFontAtlas/ImFont напрямую, как
+// ImFontAtlas::Build версии 1.89.1. С другой версией ImGui он не собирается,
+// и атлас всегда строится обычным способом
+#if IMGUI_VERSION_NUM == 18910
+constexpr uint32_t kAtlasMagic = 0x4146'4e4d; // "MNFA"
+constexpr uint32_t kAtlasFormat = 1;
+constexpr int kTexLines = IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1;
+
+uint64_t AtlasKey(ImFontAtlas* atlas, const std::vector<FontSpec>& fonts) {
+    Fnv1a h;
+    h.add<int>(IMGUI_VERSION_NUM);
+    h.add(kAtlasFormat);
+    for (const FontSpec& spec : fonts) {
+        h.add(spec.path.data(), spec.path.size());
+        h.add(spec.size_px);
+        if (!spec.path.empty()) {
+            // Изменённый файл шрифта даёт новый ключ
+            std::error_code ec;
+            auto size = fs::file_size(spec.path, ec);
+            auto mtime = fs::last_write_time(spec.path, ec).time_since_epoch().count();
+            h.add(size);
+            h.add(mtime);
+        }
+        const ImWchar* r = spec.ranges ? spec.ranges : atlas->GetGlyphRangesDefault();
+        for (; r[0]; r += 2) {
+            h.add(r[0]);
+            h.add(r[1]);
+        }
+    }
+    return h.h;
+}
+
+std::vector<uint8_t> SerializeAtlas(ImFontAtlas* atlas, uint64_t key) {
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0;
+    atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+
+    std::vector<uint8_t> out;
+    ByteWriter w(out);
+    w.put(kAtlasMagic);
+    w.put(kAtlasFormat);
+    w.put(key);
+    w.put<int32_t>(width);
+    w.put<int32_t>(height);
+    w.put(atlas->TexUvWhitePixel);
+    w.put_bytes(atlas->TexUvLines, sizeof(ImVec4) * kTexLines);
+    w.put<uint32_t>(static_cast<uint32_t>(atlas->Fonts.Size));
+    for (ImFont* font : atlas->Fonts) {
+        w.put(font->FontSize);
+        w.put(font->Ascent);
+        w.put(font->Descent);
+        w.put_string(font->ConfigData ? font->ConfigData->Name : "");
+        w.put<uint32_t>(static_cast<uint32_t>(font->Glyphs.Size));
+        for (const ImFontGlyph& g : font->Glyphs) {
+            w.put<uint32_t>(g.Codepoint);
+            w.put<uint8_t>(static_cast<uint8_t>(g.Visible | (g.Colored << 1)));
+            w.put(g.AdvanceX);
+            w.put(g.X0); w.put(g.Y0); w.put(g.X1); w.put(g.Y1);
+            w.put(g.U0); w.put(g.V0); w.put(g.U1); w.put(g.V1);
+        }
+    }
+    w.put_bytes(pixels, static_cast<size_t>(width) * height);
+    return out;
+}
+
+// Восстанавливает атлас без растеризации: шрифты, глифы и готовая текстура.
+// После этого IsBuilt() истинно и бэкенд сразу загружает текстуру в GPU.
+// При обновлении ImGui сверить поля (ConfigData, TexUvLines, TexReady...)
+// с Build, поднять kAtlasFormat и версию в условии выше
+bool RestoreAtlas(ImFontAtlas* atlas, const std::vector<uint8_t>& data, uint64_t key) {
+    ByteReader r(data.data(), data.size());
+    if (r.get<uint32_t>() != kAtlasMagic || r.get<uint32_t>() != kAtlasFormat || r.get<uint64_t>() != key)
+        return false;
+    int32_t width = r.get<int32_t>();
+    int32_t height = r.get<int32_t>();
+    ImVec2 white = r.get<ImVec2>();
+    ImVec4 lines[kTexLines];
+    r.get_bytes(lines, sizeof(lines));
+    uint32_t font_count = r.get<uint32_t>();
+    if (r.failed() || width <= 0 || height <= 0 || font_count == 0) return false;
+
+    struct FontData {
+        float size, ascent, descent;
+        std::string name;
+        std::vector<ImFontGlyph> glyphs;
+    };
+    std::vector<FontData> parsed(font_count);
+    for (FontData& f : parsed) {
+        f.size = r.get<float>();
+        f.ascent = r.get<float>();
+        f.descent = r.get<float>();
+        f.name = r.get_string();
+        uint32_t glyph_count = r.get<uint32_t>();
+        if (r.failed() || glyph_count > r.remaining()) return false;
+        f.glyphs.resize(glyph_count);
+        for (ImFontGlyph& g : f.glyphs) {
+            g.Codepoint = r.get<uint32_t>();
+            uint8_t flags = r.get<uint8_t>();
+            g.Visible = flags & 1;
+            g.Colored = (flags >> 1) & 1;
+            g.AdvanceX = r.get<float>();
+            g.X0 = r.get<float>(); g.Y0 = r.get<float>(); g.X1 = r.get<float>(); g.Y1 = r.get<float>();
+            g.U0 = r.get<float>(); g.V0 = r.get<float>(); g.U1 = r.get<float>(); g.V1 = r.get<float>();
+        }
+    }
+    size_t pixel_bytes = static_cast<size_t>(width) * height;
+    if (r.failed() || r.remaining() != pixel_bytes) return false;
+
+    atlas->Clear();
+    for (const FontData& f : parsed) {
+        ImFontConfig cfg;
+        cfg.SizePixels = f.size;
+        cfg.FontData = nullptr;
+        cfg.FontDataOwnedByAtlas = false;
+        std::snprintf(cfg.Name, sizeof(cfg.Name), "%s", f.name.c_str());
+        atlas->ConfigData.push_back(cfg);
+        atlas->Fonts.push_back(IM_NEW(ImFont)());
+    }
+    // Указатели на ConfigData берём после всех push_back
+    for (uint32_t i = 0; i < font_count; ++i) {
+        const FontData& f = parsed[i];
+        ImFont* font = atlas->Fonts[i];
+        ImFontConfig* cfg = &atlas->ConfigData[i];
+        cfg->DstFont = font;
+        font->ConfigData = cfg;
+        font->ConfigDataCount = 1;
+        font->ContainerAtlas = atlas;
+        font->FontSize = f.size;
+        font->Ascent = f.ascent;
+        font->Descent = f.descent;
+        // cfg == nullptr: метрики уже с учётом настроек шрифта
+        for (const ImFontGlyph& g : f.glyphs)
+            font->AddGlyph(nullptr, static_cast<ImWchar>(g.Codepoint), g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1,
+                           g.V1, g.AdvanceX);
+        font->BuildLookupTable();
+    }
+
+    atlas->TexWidth = width;
+    atlas->TexHeight = height;
+    atlas->TexUvScale = ImVec2(1.0f / width, 1.0f / height);
+    atlas->TexUvWhitePixel = white;
+    for (int i = 0; i < kTexLines; ++i) atlas->TexUvLines[i] = lines[i];
+    atlas->TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(pixel_bytes));
+    r.get_bytes(atlas->TexPixelsAlpha8, pixel_bytes);
+    atlas->TexReady = true;
+    return true;
+}
+#endif
+
+} // namespace
+
+FontAtlasInfo LoadFontAtlas(ImFontAtlas* atlas, const std::vector<FontSpec>& fonts) {
+    auto start = std::chrono::steady_clock::now();
+    FontAtlasInfo info;
+#if IMGUI_VERSION_NUM == 18910
+    uint64_t key = AtlasKey(atlas, fonts);
+
+    fs::path dir = CacheDirectory();
+    fs::path file;
+    if (!dir.empty()) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "fonts-%016llx.bin", static_cast<unsigned long long>(key));
+        file = dir / name;
+        info.cache_path = file.string();
+
+        std::ifstream in(file, std::ios::binary);
+        if (in) {
+            std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            info.from_cache = RestoreAtlas(atlas, data, key);
+        }
+    }
+
+    if (!info.from_cache) {
+        atlas->Clear();
+        BuildAtlas(atlas, fonts);
+        if (!file.empty()) {
+            // Пишем во временный файл и переименовываем, чтобы параллельно
+            // стартующий экземпляр не прочитал половину атласа
+            std::vector<uint8_t> data = SerializeAtlas(atlas, key);
+            std::error_code ec;
+            fs::create_directories(dir, ec);
+            fs::path tmp = file;
+            tmp += ".tmp";
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            out.close();
+            if (out) fs::rename(tmp, file, ec);
+            else fs::remove(tmp, ec);
+        }
+    }
+#else
+    atlas->Clear();
+    BuildAtlas(atlas, fonts);
+#endif
+
+    info.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return info;
+}
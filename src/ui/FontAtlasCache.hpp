@@ -0,0 +1,23 @@
+#pragma once
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+// Шрифт, запекаемый в атлас. Пустой path — встроенный ProggyClean
+struct FontSpec {
+    std::string path;
+    float size_px = 13.0f;
+    const ImWchar* ranges = nullptr; // nullptr — GetGlyphRangesDefault()
+};
+
+struct FontAtlasInfo {
+    bool from_cache = false;
+    double ms = 0.0;        // загрузка из кэша либо сборка + запись
+    std::string cache_path; // пусто, если каталог кэша недоступен или кэш выключен
+};
+
+// Заполняет атлас готовой текстурой из дискового кэша, а при промахе
+// собирает его обычным способом и сохраняет. Ключ кэша — версия ImGui,
+// шрифты (путь, размер и время изменения файла), размеры и диапазоны глифов.
+// Кэш работает только с ImGui 1.89.1, с другими версиями атлас всегда собирается
+FontAtlasInfo LoadFontAtlas(ImFontAtlas* atlas, const std::vector<FontSpec>& fonts);
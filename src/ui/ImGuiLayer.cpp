@@ -3,13 +3,18 @@
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 
-void InitImGui(GLFWwindow* window) {
+FontAtlasInfo InitImGui(GLFWwindow* window) {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO(); (void)io;
+    ImGuiIO& io = ImGui::GetIO();
     ImGui::StyleColorsDark();
+
+    // Атлас берётся из дискового кэша, иначе собирается и сохраняется
+    FontAtlasInfo fonts = LoadFontAtlas(io.Fonts, {FontSpec{}});
+
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
+    return fonts;
 }
 
 void NewFrame() {
@@ -23,6 +28,22 @@ void RenderImGui() {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+size_t ImGuiMemoryBytes() {
+    size_t bytes = 0;
+    if (ImDrawData* draw_data = ImGui::GetDrawData()) {
+        for (int i = 0; i < draw_data->CmdListsCount; ++i) {
+            const ImDrawList* list = draw_data->CmdLists[i];
+            bytes += list->CmdBuffer.Capacity * sizeof(ImDrawCmd) + list->IdxBuffer.Capacity * sizeof(ImDrawIdx) +
+                     list->VtxBuffer.Capacity * sizeof(ImDrawVert);
+        }
+    }
+    const ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    size_t texels = static_cast<size_t>(atlas->TexWidth) * atlas->TexHeight;
+    if (atlas->TexPixelsAlpha8) bytes += texels;
+    if (atlas->TexPixelsRGBA32) bytes += texels * 4;
+    return bytes;
+}
+
 void ShutdownImGui() {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
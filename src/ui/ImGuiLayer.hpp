@@ -1,7 +1,11 @@
 #pragma once
 #include <GLFW/glfw3.h>
+#include "ui/FontAtlasCache.hpp"
 
-void InitImGui(GLFWwindow* window);
+FontAtlasInfo InitImGui(GLFWwindow* window);
 void NewFrame();
 void RenderImGui();
 void ShutdownImGui();
+
+// Draw buffers of the last rendered frame plus the font atlas (valid after ImGui::Render)
+size_t ImGuiMemoryBytes();
@@ -0,0 +1,71 @@
+#include "ui/MemoryPanel.hpp"
+#include <imgui.h>
+#include "util/MemoryStats.hpp"
+
+#include <iostream>
+
+void DumpMemoryReport()
+{
+    RefreshMeasuredMemory();
+    std::cerr << MemoryReport();
+}
+
+void RenderMemoryPanel()
+{
+    if (!ImGui::CollapsingHeader("Memory"))
+        return;
+
+    // Измеряемые категории обходят документ — обновляем пару раз в секунду
+    static double last_refresh = -1.0;
+    double now = ImGui::GetTime();
+    if (last_refresh < 0.0 || now - last_refresh > 0.5)
+    {
+        RefreshMeasuredMemory();
+        last_refresh = now;
+    }
+
+    if (ImGui::BeginTable("##memory", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Subsystem");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableSetupColumn("Allocs");
+        ImGui::TableSetupColumn("Frees");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < static_cast<int>(MemCategory::Count); ++i)
+        {
+            MemCategory category = static_cast<MemCategory>(i);
+            const MemCounter &c = MemCounterFor(category);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(MemCategoryName(category));
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FormatMemoryBytes(c.live.load(std::memory_order_relaxed)).c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FormatMemoryBytes(c.peak.load(std::memory_order_relaxed)).c_str());
+            if (MemCategoryTracked(category))
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(c.allocs.load(std::memory_order_relaxed)));
+                ImGui::TableNextColumn();
+                ImGui::Text("%llu", static_cast<unsigned long long>(c.frees.load(std::memory_order_relaxed)));
+            }
+            else
+            {
+                ImGui::TableNextColumn();
+                ImGui::TextDisabled("measured");
+                ImGui::TableNextColumn();
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::TextDisabled("History snapshots also count in Geometry/Elements");
+
+    if (ImGui::Button("Dump to log"))
+    {
+        DumpMemoryReport();
+        ImGui::SetClipboardText(MemoryReport().c_str());
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(also copied to clipboard, or kill -USR1)");
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Раздел "Memory" окна Tools: память по подсистемам и дамп в лог
+void RenderMemoryPanel();
+
+// Печать отчёта о памяти в stderr (кнопка панели, SIGUSR1)
+void DumpMemoryReport();
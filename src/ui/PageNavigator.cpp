@@ -0,0 +1,181 @@
+#include "ui/PageNavigator.hpp"
+#include <imgui.h>
+#include <util/ImVecUtil.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace
+{
+
+// Пауза после последней правки до снимка страницы
+constexpr std::chrono::milliseconds kSnapshotDelay(500);
+
+struct NavigatorState
+{
+    char path[256] = "notebook.mnb";
+    std::string status;
+    std::string notebook_path;      // последний путь, открытый или сохранённый блокнотом
+    size_t shown_page = ~size_t(0); // страница, к которой прокручена лента
+    uint64_t snapshot_serial = 0;
+    uint64_t snapshot_key = 0;      // ключ последнего снимка: его миниатюру заменит следующий
+};
+
+NavigatorState& State()
+{
+    static NavigatorState state;
+    return state;
+}
+
+bool SwitchTo(Notebook& notebook, size_t index, CanvasState& canvas, History& history)
+{
+    std::string error;
+    if (notebook.switch_to(index, canvas, history, &error))
+        return true;
+    State().status = "Page " + std::to_string(index + 1) + ": " + error;
+    return false;
+}
+
+} // namespace
+
+void UpdatePageThumbnails(Notebook& notebook, ThumbnailCache& thumbnails, const CanvasState& canvas, bool is_drawing)
+{
+    NavigatorState& s = State();
+    ThumbnailCache::SnapshotResult result;
+    if (thumbnails.take_snapshot(result))
+    {
+        notebook.adopt_snapshot(result.serial, result.key, std::move(result.bytes), result.element_count);
+        // Миниатюра промежуточного состояния не нужна, если на него не ссылается ни одна страница
+        uint64_t previous = std::exchange(s.snapshot_key, result.key);
+        bool referenced = previous == result.key;
+        for (size_t i = 0; i < notebook.page_count() && !referenced; ++i)
+            referenced = notebook.info(i).key == previous;
+        if (previous != 0 && !referenced)
+            thumbnails.discard(previous);
+    }
+
+    if (!notebook.current_dirty() || is_drawing || thumbnails.snapshot_running())
+        return;
+    if (s.snapshot_serial == notebook.edit_serial() ||
+        std::chrono::steady_clock::now() - notebook.last_edit() < kSnapshotDelay)
+        return;
+    // Клоны штрихов делят геометрию, снимок дешевле сериализации;
+    // сериализация, хэш и растеризация — на рабочем потоке
+    s.snapshot_serial = notebook.edit_serial();
+    thumbnails.render_snapshot(s.snapshot_serial, std::make_unique<CanvasState>(canvas));
+}
+
+void RenderPageNavigator(Notebook& notebook, ThumbnailCache& thumbnails, CanvasState& canvas, History& history,
+                         bool can_switch)
+{
+    NavigatorState& s = State();
+    ImGui::SetNextWindowSize(ImVec2(200, 560), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Pages");
+
+    if (s.notebook_path != notebook.path())
+    {
+        s.notebook_path = notebook.path();
+        std::snprintf(s.path, sizeof(s.path), "%s", s.notebook_path.c_str());
+    }
+    ImGui::InputText("##path", s.path, sizeof(s.path));
+    if (ImGui::Button("Open") && can_switch)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::string error;
+        if (notebook.open(s.path, canvas, history, &error))
+        {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "Opened %zu pages, %.1f ms", notebook.page_count(), ms);
+            s.status = buf;
+        }
+        else
+        {
+            s.status = "Open failed: " + error;
+        }
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save"))
+    {
+        std::string error;
+        s.status = notebook.save(s.path, canvas, &error) ? "Saved" : "Save failed: " + error;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("New page") && can_switch)
+        notebook.add_page(canvas, history);
+    if (!s.status.empty())
+        ImGui::TextDisabled("%s", s.status.c_str());
+
+    const size_t count = notebook.page_count();
+    const size_t current = notebook.current();
+    if (can_switch && !canvas.is_editing_text && ImGui::IsKeyDown(ImGuiKey_LeftCtrl))
+    {
+        if (ImGui::IsKeyPressed(ImGuiKey_PageDown) && current + 1 < count)
+            SwitchTo(notebook, current + 1, canvas, history);
+        else if (ImGui::IsKeyPressed(ImGuiKey_PageUp) && current > 0)
+            SwitchTo(notebook, current - 1, canvas, history);
+    }
+    ImGui::Text("Page %zu of %zu", notebook.current() + 1, count);
+
+    const ThumbnailStats stats = thumbnails.stats();
+    if (stats.queued + stats.running > 0)
+        ImGui::TextDisabled("Thumbnails: %zu rendering, %zu queued", stats.running, stats.queued);
+    else
+        ImGui::TextDisabled("Thumbnails: %zu rendered, %zu from disk", stats.rendered, stats.disk_hits);
+    ImGui::Separator();
+
+    // Лента миниатюр: клиппер выдаёт только видимые строки, поэтому число
+    // страниц не влияет ни на кадр, ни на число фоновых задач
+    const ImVec2 thumb(float(ThumbnailCache::kWidth), float(ThumbnailCache::kHeight));
+    const float row_h = thumb.y + ImGui::GetTextLineHeight() + 4.0f;
+    const float row_step = row_h + ImGui::GetStyle().ItemSpacing.y;
+    ImGui::BeginChild("##pages");
+    if (s.shown_page != notebook.current())
+    {
+        s.shown_page = notebook.current();
+        ImGui::SetScrollY(row_step * static_cast<float>(s.shown_page));
+    }
+
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(count), row_step);
+    while (clipper.Step())
+    {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+        {
+            const size_t index = static_cast<size_t>(i);
+            const PageInfo& info = notebook.info(index);
+            ImGui::PushID(i);
+            ImVec2 pos = ImGui::GetCursorScreenPos();
+            bool clicked = ImGui::InvisibleButton("##page", ImVec2(thumb.x, row_h));
+            bool hovered = ImGui::IsItemHovered();
+
+            // Пока миниатюры нет (рисуется или декодируется) — фон страницы
+            ImVec2 tmax = pos + thumb;
+            if (ImTextureID texture = thumbnails.texture(info.key, notebook.data(index)))
+                dl->AddImage(texture, pos, tmax);
+            else
+                dl->AddRectFilled(pos, tmax, IM_COL32(40, 40, 50, 255));
+            ImU32 border = index == notebook.current() ? IM_COL32(255, 200, 0, 255)
+                           : hovered                   ? IM_COL32(200, 200, 200, 255)
+                                                       : IM_COL32(90, 90, 100, 255);
+            dl->AddRect(pos, tmax, border, 0.0f, 0, index == notebook.current() ? 2.0f : 1.0f);
+
+            // Число элементов; у текущей страницы — живое
+            size_t elements = index == notebook.current() ? canvas.elements.size() : info.element_count;
+            char label[48];
+            std::snprintf(label, sizeof(label), "%d  (%zu)", i + 1, elements);
+            dl->AddText(ImVec2(pos.x, tmax.y + 2.0f), IM_COL32(200, 200, 200, 255), label);
+
+            // Щелчок по видимой странице ленту не прокручивает
+            if (clicked && can_switch && index != notebook.current() && SwitchTo(notebook, index, canvas, history))
+                s.shown_page = index;
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+
+    ImGui::End();
+}
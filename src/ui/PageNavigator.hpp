@@ -0,0 +1,16 @@
+#pragma once
+#include "core/CanvasState.hpp"
+#include "core/History.hpp"
+#include "core/Notebook.hpp"
+#include "render/ThumbnailCache.hpp"
+
+// Окно страниц блокнота: лента миниатюр (запрашиваются только видимые
+// строки), переход по щелчку или Ctrl+PageUp/PageDown, новая страница,
+// открытие и сохранение. can_switch = false, пока идёт штрих или жест ластика
+void RenderPageNavigator(Notebook& notebook, ThumbnailCache& thumbnails, CanvasState& canvas, History& history,
+                         bool can_switch);
+
+// Каждый кадр после CollectChanges: после паузы в правках текущая страница
+// отдаётся снимком на фоновую отрисовку миниатюры, готовый снимок
+// становится содержимым страницы (см. Notebook::adopt_snapshot)
+void UpdatePageThumbnails(Notebook& notebook, ThumbnailCache& thumbnails, const CanvasState& canvas, bool is_drawing);
@@ -0,0 +1,21 @@
+#include "ui/ReplicationPanel.hpp"
+#include <imgui.h>
+
+void RenderReplicationPanel(const char *role, const ReplicationStats &stats)
+{
+    if (!stats.active)
+        return;
+
+    ImGui::Begin("Replication");
+    ImGui::Text("Role: %s", role);
+    ImGui::Text("Batch seq: %llu", static_cast<unsigned long long>(stats.seq));
+    if (stats.subscribers > 0 || stats.latency_avg_ms == 0.0)
+        ImGui::Text("Subscribers: %zu", stats.subscribers);
+    ImGui::Text("Bandwidth: %.1f KB/s (%.1f MB total)", stats.bytes_per_sec / 1024.0,
+                stats.total_bytes / (1024.0 * 1024.0));
+    ImGui::Text("Ops: %.0f/s in %.0f batches/s", stats.ops_per_sec, stats.batches_per_sec);
+    if (stats.latency_avg_ms > 0.0)
+        ImGui::Text("Latency: %.2f ms avg, %.2f ms max", stats.latency_avg_ms, stats.latency_max_ms);
+    ImGui::Text("Snapshots: %llu", static_cast<unsigned long long>(stats.snapshots));
+    ImGui::End();
+}
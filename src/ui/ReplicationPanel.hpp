@@ -0,0 +1,5 @@
+#pragma once
+#include "net/Replication.hpp"
+
+// Status window for a publishing or mirroring instance.
+void RenderReplicationPanel(const char* role, const ReplicationStats& stats);
@@ -0,0 +1,120 @@
+#include "ui/SearchPanel.hpp"
+#include <imgui.h>
+#include <util/ImVecUtil.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+constexpr size_t kMaxResults = 500;
+
+struct SearchState
+{
+    char query[256] = "";
+    int mode = 0; // TextIndex::Mode
+    std::string last_query;
+    int last_mode = -1;
+    uint64_t last_version = ~0ull;
+    std::vector<TextIndex::Hit> hits;
+    size_t total = 0;
+    double search_ms = 0.0;
+    int current = -1;
+};
+
+SearchState& State()
+{
+    static SearchState state;
+    return state;
+}
+
+// Центрирует вид на метке; слишком мелкий масштаб поднимается до 1
+void JumpTo(CanvasState& canvas, uint64_t id)
+{
+    auto it = std::find_if(canvas.elements.begin(), canvas.elements.end(),
+                           [id](const auto& el) { return el->id == id; });
+    if (it == canvas.elements.end())
+        return;
+
+    ImVec2 min, max;
+    (*it)->get_bounds(min, max);
+    ImVec2 center = (min + max) * 0.5f;
+    canvas.zoom = std::max(canvas.zoom, 1.0f);
+    canvas.pan = ImGui::GetMainViewport()->Size * 0.5f - center * canvas.zoom;
+    canvas.selected_element = it->get();
+    canvas.is_editing_text = false;
+}
+
+} // namespace
+
+void RenderSearchPanel(CanvasState& canvas, const TextIndex& index)
+{
+    SearchState& s = State();
+    bool focus_input = ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_F, false);
+
+    ImGui::SetNextWindowSize(ImVec2(320, 360), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Search");
+
+    if (focus_input)
+        ImGui::SetKeyboardFocusHere();
+    bool submitted = ImGui::InputText("##query", s.query, sizeof(s.query), ImGuiInputTextFlags_EnterReturnsTrue);
+    ImGui::SameLine();
+    ImGui::TextDisabled("Ctrl+F");
+    ImGui::RadioButton("Substring", &s.mode, static_cast<int>(TextIndex::Mode::Substring));
+    ImGui::SameLine();
+    ImGui::RadioButton("Word prefix", &s.mode, static_cast<int>(TextIndex::Mode::WordPrefix));
+
+    // Повторяем запрос только при смене строки, режима или содержимого индекса
+    if (s.last_query != s.query || s.last_mode != s.mode || s.last_version != index.version())
+    {
+        bool new_query = s.last_query != s.query || s.last_mode != s.mode;
+        auto start = std::chrono::steady_clock::now();
+        s.hits = index.search(s.query, static_cast<TextIndex::Mode>(s.mode), kMaxResults, &s.total);
+        s.search_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        s.last_query = s.query;
+        s.last_mode = s.mode;
+        s.last_version = index.version();
+        if (new_query || s.current >= static_cast<int>(s.hits.size()))
+            s.current = -1;
+    }
+
+    // Enter переходит к следующему совпадению
+    if (submitted && !s.hits.empty())
+    {
+        s.current = (s.current + 1) % static_cast<int>(s.hits.size());
+        JumpTo(canvas, s.hits[s.current].id);
+        ImGui::SetKeyboardFocusHere(-1);
+    }
+
+    if (s.query[0] != '\0')
+    {
+        if (s.total > s.hits.size())
+            ImGui::Text("%zu matches (showing %zu), %.2f ms", s.total, s.hits.size(), s.search_ms);
+        else
+            ImGui::Text("%zu matches, %.2f ms", s.total, s.search_ms);
+    }
+    if (index.pending() > 0)
+        ImGui::TextDisabled("%zu labels indexed, %zu updates pending", index.size(), index.pending());
+    else
+        ImGui::TextDisabled("%zu labels indexed", index.size());
+    ImGui::Separator();
+
+    ImGui::BeginChild("##results");
+    for (int i = 0; i < static_cast<int>(s.hits.size()); ++i)
+    {
+        const TextIndex::Hit& hit = s.hits[i];
+        ImGui::PushID(i);
+        if (ImGui::Selectable(hit.text->c_str(), i == s.current))
+        {
+            s.current = i;
+            JumpTo(canvas, hit.id);
+        }
+        ImGui::PopID();
+    }
+    ImGui::EndChild();
+
+    ImGui::End();
+}
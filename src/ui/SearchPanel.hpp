@@ -0,0 +1,7 @@
+#pragma once
+#include "core/CanvasState.hpp"
+#include "core/TextIndex.hpp"
+
+// Окно поиска по текстовым меткам (Ctrl+F). Выбор результата переводит
+// вид на метку и выделяет её
+void RenderSearchPanel(CanvasState& canvas, const TextIndex& index);
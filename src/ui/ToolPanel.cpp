@@ -2,8 +2,14 @@
 #include <imgui.h>
 #include <cstring>
 #include "core/CanvasElement.hpp"
+#include "export/PngExport.hpp"
+#include "export/SvgExport.hpp"
+#include "ui/DiagnosticsPanel.hpp"
+#include "ui/MemoryPanel.hpp"
+#include "util/MemoryStats.hpp"
+#include <util/ImVecUtil.hpp>
 
-void RenderToolPanel(CanvasState &canvas, History &history, ToolSettings &tool)
+void RenderToolPanel(CanvasState &canvas, History &history, ToolSettings &tool, const Notebook &notebook)
 {
     ImGui::Begin("Tools");
 
@@ -41,26 +47,27 @@ void RenderToolPanel(CanvasState &canvas, History &history, ToolSettings &tool)
     // Undo/Redo
     if (ImGui::Button("Undo"))
     {
-        if (auto prev = history.undo(canvas))
-            canvas = *prev;
+        history.undo(canvas);
     }
     ImGui::SameLine();
     if (ImGui::Button("Redo"))
     {
-        if (auto next = history.redo(canvas))
-            canvas = *next;
+        history.redo(canvas);
     }
 
     size_t stroke_count = 0;
     size_t text_count = 0;
+    size_t image_count = 0;
     for (const auto &el : canvas.elements)
     {
         if (dynamic_cast<Stroke *>(el.get()))
             ++stroke_count;
         if (dynamic_cast<TextLabel *>(el.get()))
             ++text_count;
+        if (dynamic_cast<ImageElement *>(el.get()))
+            ++image_count;
     }
-    ImGui::Text("Strokes: %zu, Texts: %zu", stroke_count, text_count);
+    ImGui::Text("Strokes: %zu, Texts: %zu, Images: %zu", stroke_count, text_count, image_count);
     const char *tool_names[] = {"Brush", "Eraser", "Text"};
     ImGui::Text("Current tool: %s", tool_names[static_cast<int>(tool.type)]);
 
@@ -75,5 +82,97 @@ void RenderToolPanel(CanvasState &canvas, History &history, ToolSettings &tool)
         }
     }
 
+    // Экспорт в PNG и SVG
+    if (ImGui::CollapsingHeader("Export"))
+    {
+        static char png_path[256] = "canvas.png";
+        static char svg_path[256] = "canvas.svg";
+        static float dpi = 150.0f;
+        static bool visible_only = false;
+        static int svg_precision = 1;
+        static float svg_tolerance = 0.25f;
+        static bool all_pages = false;
+        static PngExportStats last_stats;
+        static SvgExportStats last_svg_stats;
+        static bool last_ok = false;
+        static bool exported = false;
+        static bool last_svg_ok = false;
+        static bool svg_exported = false;
+
+        // Видимая область окна в координатах холста
+        auto visible_region = [&](ImVec2 &min, ImVec2 &max)
+        {
+            ImVec2 size = ImGui::GetMainViewport()->Size;
+            min = (ImVec2(0.0f, 0.0f) - canvas.pan) / canvas.zoom;
+            max = (size - canvas.pan) / canvas.zoom;
+        };
+
+        ImGui::Checkbox("Visible area only", &visible_only);
+        ImGui::InputText("File", png_path, sizeof(png_path));
+        ImGui::SliderFloat("DPI", &dpi, 72.0f, 1200.0f, "%.0f");
+
+        if (ImGui::Button("Export PNG"))
+        {
+            PngExportOptions options;
+            options.dpi = dpi;
+            if (visible_only)
+            {
+                options.use_region = true;
+                visible_region(options.region_min, options.region_max);
+            }
+            last_ok = ExportCanvasPng(canvas, png_path, options, &last_stats);
+            exported = true;
+        }
+        if (exported)
+        {
+            if (last_ok)
+                ImGui::Text("%dx%d, %d tiles, %zu images, %.2fs, %.1f MB buffers",
+                            last_stats.width, last_stats.height, last_stats.tiles, last_stats.images,
+                            last_stats.seconds, last_stats.buffer_bytes / (1024.0 * 1024.0));
+            else
+                ImGui::Text("Export failed");
+        }
+
+        // Векторный экспорт: штрихи упрощаются до допуска, координаты
+        // округляются до заданного числа знаков
+        ImGui::Separator();
+        ImGui::InputText("SVG file", svg_path, sizeof(svg_path));
+        ImGui::SliderInt("Precision", &svg_precision, 0, 4, "%d digits");
+        ImGui::SliderFloat("Simplify", &svg_tolerance, 0.0f, 2.0f, "%.2f");
+        ImGui::Checkbox("All pages", &all_pages);
+        if (ImGui::Button("Export SVG"))
+        {
+            SvgExportOptions options;
+            options.precision = svg_precision;
+            options.simplify_tolerance = svg_tolerance;
+            if (visible_only)
+            {
+                options.use_region = true;
+                visible_region(options.region_min, options.region_max);
+            }
+            last_svg_ok = all_pages ? ExportNotebookSvg(notebook, canvas, svg_path, options, &last_svg_stats)
+                                    : ExportCanvasSvg(canvas, svg_path, options, &last_svg_stats);
+            svg_exported = true;
+        }
+        if (svg_exported)
+        {
+            if (last_svg_ok)
+            {
+                ImGui::Text("%zu pages, %zu elements, %.2fs (%.0f elements/s)", last_svg_stats.pages,
+                            last_svg_stats.elements, last_svg_stats.seconds, last_svg_stats.elements_per_second);
+                ImGui::Text("Points %zu -> %zu, %s, %s buffers", last_svg_stats.input_points,
+                            last_svg_stats.output_points, FormatMemoryBytes(last_svg_stats.file_bytes).c_str(),
+                            FormatMemoryBytes(last_svg_stats.buffer_bytes).c_str());
+            }
+            else
+            {
+                ImGui::Text("Export failed");
+            }
+        }
+    }
+
+    RenderMemoryPanel();
+    RenderDiagnostics();
+
     ImGui::End();
 }
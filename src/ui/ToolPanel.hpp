@@ -1,6 +1,7 @@
 #pragma once
 #include "core/CanvasState.hpp"
 #include "core/History.hpp"
+#include "core/Notebook.hpp"
 #include "core/Tool.hpp"
 
-void RenderToolPanel(CanvasState& canvas, History& history, ToolSettings& tool);
+void RenderToolPanel(CanvasState& canvas, History& history, ToolSettings& tool, const Notebook& notebook);
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+
+// Per-user cache directory ($XDG_CACHE_HOME/myNotes or ~/.cache/myNotes),
+// empty when neither variable is set.
+inline std::filesystem::path CacheDirectory() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) return std::filesystem::path(xdg) / "myNotes";
+    if (const char* home = std::getenv("HOME"); home && *home) return std::filesystem::path(home) / ".cache" / "myNotes";
+    return {};
+}
+
+// 64-bit FNV-1a, used to name cache entries after their inputs.
+struct Fnv1a {
+    uint64_t h = 1469598103934665603ull;
+    void add(const void* data, size_t n) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 1099511628211ull;
+    }
+    template <typename T>
+    void add(const T& v) { add(&v, sizeof(T)); }
+};
@@ -0,0 +1,92 @@
+#include "util/FrameScheduler.hpp"
+
+#include <algorithm>
+
+namespace {
+
+constexpr double kRenderReserve = 0.25;  // share of the budget left for ImGui::Render, GL submit and swap
+constexpr double kMinSliceMs = 0.5;      // jobs progress even on frames that are already over budget
+constexpr double kOverBudget = 0.95;
+constexpr double kUnderBudget = 0.5;
+constexpr int kDegradeAfterFrames = 3;
+constexpr int kRecoverAfterFrames = 60;
+
+double ms_between(FrameScheduler::Clock::time_point a, FrameScheduler::Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+} // namespace
+
+FrameScheduler& FrameScheduler::shared() {
+    static FrameScheduler scheduler;
+    return scheduler;
+}
+
+void FrameScheduler::set_refresh_rate(double hz) {
+    stats_.budget_ms = 1000.0 / std::max(hz, 1.0);
+}
+
+void FrameScheduler::begin_frame() {
+    if (stats_.budget_ms == 0.0) set_refresh_rate(60.0);
+    frame_start = Clock::now();
+    stats_.jobs_ms = 0.0;
+}
+
+void FrameScheduler::post(std::string name, Step step) {
+    if (has_job(name)) return;
+    jobs.push_back({std::move(name), std::move(step)});
+    stats_.jobs_pending = jobs.size();
+}
+
+bool FrameScheduler::has_job(const std::string& name) const {
+    return std::any_of(jobs.begin(), jobs.end(), [&](const Job& job) { return job.name == name; });
+}
+
+void FrameScheduler::run_jobs() {
+    if (jobs.empty()) return;
+    Clock::time_point start = Clock::now();
+    double left_ms = stats_.budget_ms * (1.0 - kRenderReserve) - ms_between(frame_start, start);
+    double total_ms = std::max(left_ms, kMinSliceMs);
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double, std::milli>(total_ms));
+
+    // Each job gets an equal share of what is left; a job that finishes
+    // early leaves its remainder to the ones after it
+    size_t count = jobs.size();
+    for (size_t i = 0; i < count && !jobs.empty(); ++i) {
+        Clock::time_point now = Clock::now();
+        if (i > 0 && now >= end) break;
+        Clock::time_point slice_end = now + (end - now) / static_cast<long>(count - i);
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        if (!job.step(slice_end)) jobs.push_back(std::move(job));
+    }
+
+    stats_.jobs_ms = ms_between(start, Clock::now());
+    stats_.jobs_pending = jobs.size();
+}
+
+void FrameScheduler::end_frame() {
+    double work = ms_between(frame_start, Clock::now());
+    stats_.work_ms = work;
+    stats_.work_avg_ms = stats_.frames == 0 ? work : stats_.work_avg_ms * 0.9 + work * 0.1;
+    stats_.frames++;
+
+    if (work > stats_.budget_ms * kOverBudget) {
+        stats_.over_budget_frames++;
+        under_streak = 0;
+        if (++over_streak >= kDegradeAfterFrames && stats_.quality_level < kMaxQualityLevel) {
+            stats_.quality_level++;
+            over_streak = 0;
+        }
+    } else if (work < stats_.budget_ms * kUnderBudget) {
+        over_streak = 0;
+        if (++under_streak >= kRecoverAfterFrames && stats_.quality_level > 0) {
+            stats_.quality_level--;
+            under_streak = 0;
+        }
+    } else {
+        over_streak = 0;
+        under_streak = 0;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+struct FrameSchedulerStats {
+    double budget_ms = 0.0;
+    double work_ms = 0.0;     // CPU time of the last frame up to the swap
+    double work_avg_ms = 0.0; // smoothed
+    double jobs_ms = 0.0;     // spent in background jobs last frame
+    size_t jobs_pending = 0;
+    int quality_level = 0;
+    uint64_t frames = 0;
+    uint64_t over_budget_frames = 0;
+};
+
+// Per-frame time budget derived from the display refresh rate.
+//  - Resumable jobs run in whatever is left of the budget after input, UI
+//    and canvas submission, at least a small slice per frame so they always
+//    make progress.
+//  - Quality governor: a few frames over budget in a row lower the render
+//    quality level (0 = full), a long stretch well under budget raises it.
+// Main thread only.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Does work until the deadline, returns true once the job is finished.
+    using Step = std::function<bool(Clock::time_point deadline)>;
+
+    static constexpr int kMaxQualityLevel = 2;
+
+    static FrameScheduler& shared();
+
+    void set_refresh_rate(double hz);
+    double budget_ms() const { return stats_.budget_ms; }
+
+    void begin_frame();
+    // Queues a job unless one with the same name is already queued.
+    void post(std::string name, Step step);
+    bool has_job(const std::string& name) const;
+    // Time-slices queued jobs into the remaining budget (round-robin).
+    void run_jobs();
+    // Call right before presenting; updates timing and the quality level.
+    void end_frame();
+
+    int quality_level() const { return stats_.quality_level; }
+    const FrameSchedulerStats& stats() const { return stats_; }
+
+private:
+    struct Job {
+        std::string name;
+        Step step;
+    };
+
+    std::deque<Job> jobs;
+    Clock::time_point frame_start = Clock::now();
+    int over_streak = 0;
+    int under_streak = 0;
+    FrameSchedulerStats stats_;
+};
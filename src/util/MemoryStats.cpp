@@ -0,0 +1,99 @@
+#include "util/MemoryStats.hpp"
+
+#include <cstdio>
+#include <mutex>
+
+namespace {
+
+constexpr int kCategories = static_cast<int>(MemCategory::Count);
+
+MemCounter g_counters[kCategories];
+
+std::mutex g_sources_mutex;
+std::function<size_t()> g_sources[kCategories];
+
+} // namespace
+
+std::string FormatMemoryBytes(int64_t bytes) {
+    char buf[32];
+    double b = static_cast<double>(bytes);
+    if (bytes >= (int64_t(1) << 30)) std::snprintf(buf, sizeof(buf), "%.2f GB", b / (1 << 30));
+    else if (bytes >= (1 << 20)) std::snprintf(buf, sizeof(buf), "%.1f MB", b / (1 << 20));
+    else if (bytes >= (1 << 10)) std::snprintf(buf, sizeof(buf), "%.1f KB", b / (1 << 10));
+    else std::snprintf(buf, sizeof(buf), "%lld B", static_cast<long long>(bytes));
+    return buf;
+}
+
+const char* MemCategoryName(MemCategory category) {
+    switch (category) {
+        case MemCategory::History: return "History";
+        case MemCategory::Geometry: return "Geometry";
+        case MemCategory::Elements: return "Elements";
+        case MemCategory::Text: return "Text";
+        case MemCategory::Index: return "Index";
+        case MemCategory::Render: return "Render";
+        case MemCategory::Caches: return "Caches";
+        case MemCategory::Images: return "Images";
+        case MemCategory::Textures: return "Textures";
+        case MemCategory::Pages: return "Pages";
+        default: return "?";
+    }
+}
+
+bool MemCategoryTracked(MemCategory category) {
+    return category == MemCategory::History || category == MemCategory::Geometry ||
+           category == MemCategory::Elements || category == MemCategory::Caches ||
+           category == MemCategory::Images;
+}
+
+MemCounter& MemCounterFor(MemCategory category) {
+    return g_counters[static_cast<int>(category)];
+}
+
+void SetMemorySource(MemCategory category, std::function<size_t()> source) {
+    std::lock_guard<std::mutex> lock(g_sources_mutex);
+    g_sources[static_cast<int>(category)] = std::move(source);
+}
+
+void MemSetMeasured(MemCategory category, size_t bytes) {
+    MemCounter& c = MemCounterFor(category);
+    int64_t live = static_cast<int64_t>(bytes);
+    c.live.store(live, std::memory_order_relaxed);
+    if (live > c.peak.load(std::memory_order_relaxed)) c.peak.store(live, std::memory_order_relaxed);
+}
+
+void RefreshMeasuredMemory() {
+    std::lock_guard<std::mutex> lock(g_sources_mutex);
+    for (int i = 0; i < kCategories; ++i) {
+        if (g_sources[i]) MemSetMeasured(static_cast<MemCategory>(i), g_sources[i]());
+    }
+}
+
+std::string MemoryReport() {
+    std::string out = "Memory by subsystem:\n";
+    char line[160];
+    int64_t total = 0;
+    for (int i = 0; i < kCategories; ++i) {
+        MemCategory category = static_cast<MemCategory>(i);
+        const MemCounter& c = g_counters[i];
+        std::string live = FormatMemoryBytes(c.live.load(std::memory_order_relaxed));
+        std::string peak = FormatMemoryBytes(c.peak.load(std::memory_order_relaxed));
+        if (MemCategoryTracked(category)) {
+            std::snprintf(line, sizeof(line), "  %-9s %10s  peak %10s  allocs %llu  frees %llu\n",
+                          MemCategoryName(category), live.c_str(), peak.c_str(),
+                          static_cast<unsigned long long>(c.allocs.load(std::memory_order_relaxed)),
+                          static_cast<unsigned long long>(c.frees.load(std::memory_order_relaxed)));
+        } else {
+            std::snprintf(line, sizeof(line), "  %-9s %10s  peak %10s  (measured)\n", MemCategoryName(category),
+                          live.c_str(), peak.c_str());
+        }
+        out += line;
+        total += c.live.load(std::memory_order_relaxed);
+    }
+    // History snapshots hold their own geometry/elements, which are also in
+    // those categories, so the sum is an upper bound
+    std::snprintf(line, sizeof(line), "  sum       %10s  (history overlaps geometry/elements)\n",
+                  FormatMemoryBytes(total).c_str());
+    out += line;
+    return out;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+// Per-subsystem memory accounting.
+// Tracked categories are updated at the allocation site (container
+// allocators, element new/delete, history push/pop) and also count
+// allocations and frees. Measured categories are footprints recomputed on
+// demand from a registered source, for memory that is not worth hooking.
+enum class MemCategory : int {
+    History,  // undo/redo snapshots (full copies of the document)
+    Geometry, // stroke point buffers; packed geometry is shared by instances and history copies
+    Elements, // element objects, including the copies held by history
+    Text,     // label strings of the document
+    Index,    // search index
+    Render,   // ImGui draw buffers, canvas render batches and the font atlas
+    Caches,   // tessellation and hit-test caches of stroke geometry, mesh of the stroke being drawn
+    Images,   // decoded image pixels waiting for (or kept for) texture upload
+    Textures, // image textures resident on the GPU
+    Pages,    // notebook pages kept serialized in memory (edited since the last save)
+    Count
+};
+
+struct MemCounter {
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> peak{0};
+    std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> frees{0};
+};
+
+const char* MemCategoryName(MemCategory category);
+bool MemCategoryTracked(MemCategory category);
+MemCounter& MemCounterFor(MemCategory category);
+
+inline void MemTrackAlloc(MemCategory category, size_t bytes) {
+    MemCounter& c = MemCounterFor(category);
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    int64_t live = c.live.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes);
+    int64_t peak = c.peak.load(std::memory_order_relaxed);
+    while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+inline void MemTrackFree(MemCategory category, size_t bytes) {
+    MemCounter& c = MemCounterFor(category);
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.live.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+// Measured categories: the source returns the current footprint in bytes.
+void SetMemorySource(MemCategory category, std::function<size_t()> source);
+void MemSetMeasured(MemCategory category, size_t bytes);
+// Re-evaluates all registered sources (O(document), call at a low rate).
+void RefreshMeasuredMemory();
+
+// Plain-text table of all categories, for logs and bug reports.
+std::string MemoryReport();
+
+// "12.3 MB" style size for reports and panels.
+std::string FormatMemoryBytes(int64_t bytes);
+
+// std::allocator that books every allocation under a category.
+template <typename T, MemCategory C>
+struct TrackedAllocator {
+    using value_type = T;
+    template <typename U>
+    struct rebind {
+        using other = TrackedAllocator<U, C>;
+    };
+
+    TrackedAllocator() = default;
+    template <typename U>
+    TrackedAllocator(const TrackedAllocator<U, C>&) {}
+
+    T* allocate(size_t n) {
+        MemTrackAlloc(C, n * sizeof(T));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) {
+        MemTrackFree(C, n * sizeof(T));
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const TrackedAllocator<U, C>&) const { return true; }
+    template <typename U>
+    bool operator!=(const TrackedAllocator<U, C>&) const { return false; }
+};
+
+template <typename T, MemCategory C>
+using TrackedVector = std::vector<T, TrackedAllocator<T, C>>;
@@ -0,0 +1,41 @@
+#include "util/Startup.hpp"
+
+#include <cstdio>
+
+void StartupProfile::mark(std::string phase) {
+    auto now = std::chrono::steady_clock::now();
+    phases.push_back({std::move(phase), std::chrono::duration<double, std::milli>(now - last).count()});
+    last = now;
+}
+
+double StartupProfile::total_ms() const {
+    return std::chrono::duration<double, std::milli>(last - start).count();
+}
+
+std::string StartupProfile::report(double target_ms) const {
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "Time to first frame: %.1fms (target %.0fms)", total_ms(), target_ms);
+    std::string out = buf;
+    for (size_t i = 0; i < phases.size(); ++i) {
+        std::snprintf(buf, sizeof(buf), "%s%s %.1fms", i == 0 ? " [" : ", ", phases[i].name.c_str(), phases[i].ms);
+        out += buf;
+    }
+    if (!phases.empty()) out += "]";
+    if (total_ms() > target_ms) out += " -- over target";
+    return out;
+}
+
+void DeferredInit::add(std::string name, std::function<void()> task) {
+    tasks.push_back({std::move(name), std::move(task)});
+}
+
+bool DeferredInit::run_next(std::string* name, double* ms) {
+    if (!pending()) return false;
+    Task& task = tasks[next++];
+    auto start = std::chrono::steady_clock::now();
+    task.fn();
+    if (ms) *ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (name) *name = task.name;
+    task.fn = nullptr;
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Time-to-first-frame breakdown. Each mark() closes the phase that started
+// at the previous mark (or at construction).
+class StartupProfile {
+public:
+    StartupProfile() : start(std::chrono::steady_clock::now()), last(start) {}
+
+    void mark(std::string phase);
+    double total_ms() const;
+
+    // Single log line with all phases; warns when the total exceeds target_ms.
+    std::string report(double target_ms) const;
+
+private:
+    struct Phase {
+        std::string name;
+        double ms;
+    };
+    std::chrono::steady_clock::time_point start, last;
+    std::vector<Phase> phases;
+};
+
+// Non-critical subsystems started after the first frame is presented,
+// one task per frame so none of them stalls interaction.
+class DeferredInit {
+public:
+    void add(std::string name, std::function<void()> task);
+
+    bool pending() const { return next < tasks.size(); }
+
+    // Runs the next task; returns false when nothing was left.
+    bool run_next(std::string* name = nullptr, double* ms = nullptr);
+
+private:
+    struct Task {
+        std::string name;
+        std::function<void()> fn;
+    };
+    std::vector<Task> tasks;
+    size_t next = 0;
+};
@@ -0,0 +1,90 @@
+#include "util/ThreadPool.hpp"
+#include <algorithm>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(job));
+    }
+    cv.notify_one();
+}
+
+void ThreadPool::worker_loop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping && queue.empty()) return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn, unsigned max_threads) {
+    if (count == 0) return;
+
+    unsigned threads = size() + 1; // workers + calling thread
+    if (max_threads > 0) threads = std::min(threads, max_threads);
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // Shared state outlives this call: a helper may be dequeued after all the
+    // work is done and must still be able to look at the counters.
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+    const std::function<void(size_t)>* body = &fn;
+
+    auto run = [state, body, count] {
+        size_t finished = 0;
+        for (size_t i = state->next.fetch_add(1); i < count; i = state->next.fetch_add(1)) {
+            (*body)(i);
+            ++finished;
+        }
+        if (finished > 0 && state->done.fetch_add(finished) + finished == count) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->cv.notify_all();
+        }
+    };
+
+    for (unsigned i = 0; i + 1 < threads; ++i) submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->done.load() == count; });
+}
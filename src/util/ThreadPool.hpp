@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by export, decoding and render batching.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool sized to the number of hardware threads.
+    static ThreadPool& shared();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+    // Fire-and-forget background job.
+    void submit(std::function<void()> job);
+
+    // Runs fn(i) for every i in [0, count) and blocks until all calls returned.
+    // The calling thread takes part in the work, so this never deadlocks even
+    // when the workers are busy with long background jobs.
+    // max_threads limits the number of participating threads (0 = all).
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn, unsigned max_threads = 0);
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};